@@ -0,0 +1,147 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/repo/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/root/repo/cmake/modules/FindNUMA.cmake"
+  "/root/repo/libs/gtest/CMakeLists.txt"
+  "/root/repo/libs/gtest/cmake/internal_utils.cmake"
+  "/root/repo/src/CMakeLists.txt"
+  "/root/repo/src/base/CMakeLists.txt"
+  "/root/repo/src/data/CMakeLists.txt"
+  "/root/repo/src/memory/CMakeLists.txt"
+  "/root/repo/src/regtests/CMakeLists.txt"
+  "/root/repo/src/storage/CMakeLists.txt"
+  "/root/repo/src/tasking/CMakeLists.txt"
+  "/root/repo/src/tests/CMakeLists.txt"
+  "/usr/lib/x86_64-linux-gnu/cmake/Boost-1.74.0/BoostConfig.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/Boost-1.74.0/BoostConfigVersion.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/BoostDetectToolset-1.74.0.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_atomic-1.74.0/boost_atomic-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_atomic-1.74.0/boost_atomic-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_atomic-1.74.0/libboost_atomic-variant-shared.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_atomic-1.74.0/libboost_atomic-variant-static.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_chrono-1.74.0/boost_chrono-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_chrono-1.74.0/boost_chrono-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_chrono-1.74.0/libboost_chrono-variant-shared.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_chrono-1.74.0/libboost_chrono-variant-static.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_context-1.74.0/boost_context-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_context-1.74.0/boost_context-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_context-1.74.0/libboost_context-variant-shared.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_context-1.74.0/libboost_context-variant-static.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_date_time-1.74.0/boost_date_time-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_date_time-1.74.0/boost_date_time-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_date_time-1.74.0/libboost_date_time-variant-shared.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_date_time-1.74.0/libboost_date_time-variant-static.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_headers-1.74.0/boost_headers-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_headers-1.74.0/boost_headers-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_locale-1.74.0/boost_locale-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_locale-1.74.0/boost_locale-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_locale-1.74.0/libboost_locale-variant-shared.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_locale-1.74.0/libboost_locale-variant-static.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_program_options-1.74.0/boost_program_options-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_program_options-1.74.0/boost_program_options-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_program_options-1.74.0/libboost_program_options-variant-shared.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_program_options-1.74.0/libboost_program_options-variant-static.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_system-1.74.0/boost_system-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_system-1.74.0/boost_system-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_system-1.74.0/libboost_system-variant-shared.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_system-1.74.0/libboost_system-variant-static.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_thread-1.74.0/boost_thread-config-version.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_thread-1.74.0/boost_thread-config.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_thread-1.74.0/libboost_thread-variant-shared.cmake"
+  "/usr/lib/x86_64-linux-gnu/cmake/boost_thread-1.74.0/libboost_thread-variant-static.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeFindDependencyMacro.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckCSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckIncludeFile.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckIncludeFileCXX.cmake"
+  "/usr/share/cmake-3.25/Modules/CheckLibraryExists.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/FindBoost.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageHandleStandardArgs.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPackageMessage.cmake"
+  "/usr/share/cmake-3.25/Modules/FindPythonInterp.cmake"
+  "/usr/share/cmake-3.25/Modules/FindThreads.cmake"
+  "/usr/share/cmake-3.25/Modules/Internal/CheckSourceCompiles.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  "libs/gtest/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "src/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "src/base/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "src/storage/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "src/memory/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "src/tasking/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "src/data/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "src/tests/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "src/regtests/CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "libs/gtest/CMakeFiles/gtest.dir/DependInfo.cmake"
+  "libs/gtest/CMakeFiles/gtest_main.dir/DependInfo.cmake"
+  "src/base/CMakeFiles/base.dir/DependInfo.cmake"
+  "src/storage/CMakeFiles/storage.dir/DependInfo.cmake"
+  "src/memory/CMakeFiles/memory.dir/DependInfo.cmake"
+  "src/tasking/CMakeFiles/tasking.dir/DependInfo.cmake"
+  "src/data/CMakeFiles/data.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/file_storage_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/sequential_storage_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/write_ahead_log_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/double_write_buffer_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/page_table_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/prefetcher_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/buffer_pool_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/buffer_pool_set_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/tasking_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/schema_test.dir/DependInfo.cmake"
+  "src/tests/CMakeFiles/tests.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/alloc_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/groupby_array_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/groupby_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/hashjoin_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/scan_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/scanfilter_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/loadgraph_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/bfsgraph_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/parallelread_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/ingest_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/checksum_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/devicemodel_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/checkpoint_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/pin_regtest.dir/DependInfo.cmake"
+  "src/regtests/CMakeFiles/regtests.dir/DependInfo.cmake"
+  )
@@ -0,0 +1,13 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/src
+# Build directory: /root/repo/_debug_build/src
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+subdirs("base")
+subdirs("storage")
+subdirs("memory")
+subdirs("tasking")
+subdirs("data")
+subdirs("tests")
+subdirs("regtests")
@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/base/error.cpp" "src/base/CMakeFiles/base.dir/error.cpp.o" "gcc" "src/base/CMakeFiles/base.dir/error.cpp.o.d"
+  "/root/repo/src/base/platform.cpp" "src/base/CMakeFiles/base.dir/platform.cpp.o" "gcc" "src/base/CMakeFiles/base.dir/platform.cpp.o.d"
+  "/root/repo/src/base/types_utils.cpp" "src/base/CMakeFiles/base.dir/types_utils.cpp.o" "gcc" "src/base/CMakeFiles/base.dir/types_utils.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
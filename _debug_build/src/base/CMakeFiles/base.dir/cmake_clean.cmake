@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/base.dir/error.cpp.o"
+  "CMakeFiles/base.dir/error.cpp.o.d"
+  "CMakeFiles/base.dir/platform.cpp.o"
+  "CMakeFiles/base.dir/platform.cpp.o.d"
+  "CMakeFiles/base.dir/types_utils.cpp.o"
+  "CMakeFiles/base.dir/types_utils.cpp.o.d"
+  "libbase.a"
+  "libbase.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/base.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/data.dir/schema.cpp.o"
+  "CMakeFiles/data.dir/schema.cpp.o.d"
+  "libdata.a"
+  "libdata.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/data.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
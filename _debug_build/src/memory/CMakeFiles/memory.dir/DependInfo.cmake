@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/memory/buffer_pool.cpp" "src/memory/CMakeFiles/memory.dir/buffer_pool.cpp.o" "gcc" "src/memory/CMakeFiles/memory.dir/buffer_pool.cpp.o.d"
+  "/root/repo/src/memory/buffer_pool_set.cpp" "src/memory/CMakeFiles/memory.dir/buffer_pool_set.cpp.o" "gcc" "src/memory/CMakeFiles/memory.dir/buffer_pool_set.cpp.o.d"
+  "/root/repo/src/memory/page_table.cpp" "src/memory/CMakeFiles/memory.dir/page_table.cpp.o" "gcc" "src/memory/CMakeFiles/memory.dir/page_table.cpp.o.d"
+  "/root/repo/src/memory/prefetcher.cpp" "src/memory/CMakeFiles/memory.dir/prefetcher.cpp.o" "gcc" "src/memory/CMakeFiles/memory.dir/prefetcher.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_debug_build/src/storage/CMakeFiles/storage.dir/DependInfo.cmake"
+  "/root/repo/_debug_build/src/base/CMakeFiles/base.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,17 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/memory.dir/buffer_pool.cpp.o"
+  "CMakeFiles/memory.dir/buffer_pool.cpp.o.d"
+  "CMakeFiles/memory.dir/buffer_pool_set.cpp.o"
+  "CMakeFiles/memory.dir/buffer_pool_set.cpp.o.d"
+  "CMakeFiles/memory.dir/page_table.cpp.o"
+  "CMakeFiles/memory.dir/page_table.cpp.o.d"
+  "CMakeFiles/memory.dir/prefetcher.cpp.o"
+  "CMakeFiles/memory.dir/prefetcher.cpp.o.d"
+  "libmemory.a"
+  "libmemory.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/memory.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/alloc_regtest"
+  "../../bin/regtest/alloc_regtest.pdb"
+  "CMakeFiles/alloc_regtest.dir/alloc_regtest.cpp.o"
+  "CMakeFiles/alloc_regtest.dir/alloc_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/alloc_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
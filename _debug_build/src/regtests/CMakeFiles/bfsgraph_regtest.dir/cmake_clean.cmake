@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/bfsgraph_regtest"
+  "../../bin/regtest/bfsgraph_regtest.pdb"
+  "CMakeFiles/bfsgraph_regtest.dir/bfsgraph_regtest.cpp.o"
+  "CMakeFiles/bfsgraph_regtest.dir/bfsgraph_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bfsgraph_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
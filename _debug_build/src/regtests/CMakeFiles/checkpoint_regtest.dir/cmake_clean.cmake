@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/checkpoint_regtest"
+  "../../bin/regtest/checkpoint_regtest.pdb"
+  "CMakeFiles/checkpoint_regtest.dir/checkpoint_regtest.cpp.o"
+  "CMakeFiles/checkpoint_regtest.dir/checkpoint_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/checkpoint_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
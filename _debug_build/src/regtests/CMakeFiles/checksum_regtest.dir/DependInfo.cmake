@@ -0,0 +1,25 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/regtests/checksum_regtest.cpp" "src/regtests/CMakeFiles/checksum_regtest.dir/checksum_regtest.cpp.o" "gcc" "src/regtests/CMakeFiles/checksum_regtest.dir/checksum_regtest.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_debug_build/libs/gtest/CMakeFiles/gtest.dir/DependInfo.cmake"
+  "/root/repo/_debug_build/src/base/CMakeFiles/base.dir/DependInfo.cmake"
+  "/root/repo/_debug_build/src/storage/CMakeFiles/storage.dir/DependInfo.cmake"
+  "/root/repo/_debug_build/src/memory/CMakeFiles/memory.dir/DependInfo.cmake"
+  "/root/repo/_debug_build/src/tasking/CMakeFiles/tasking.dir/DependInfo.cmake"
+  "/root/repo/_debug_build/src/data/CMakeFiles/data.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/checksum_regtest"
+  "../../bin/regtest/checksum_regtest.pdb"
+  "CMakeFiles/checksum_regtest.dir/checksum_regtest.cpp.o"
+  "CMakeFiles/checksum_regtest.dir/checksum_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/checksum_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
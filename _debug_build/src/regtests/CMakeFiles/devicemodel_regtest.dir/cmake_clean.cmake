@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/devicemodel_regtest"
+  "../../bin/regtest/devicemodel_regtest.pdb"
+  "CMakeFiles/devicemodel_regtest.dir/devicemodel_regtest.cpp.o"
+  "CMakeFiles/devicemodel_regtest.dir/devicemodel_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/devicemodel_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
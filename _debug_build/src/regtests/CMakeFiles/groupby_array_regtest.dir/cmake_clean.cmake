@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/groupby_array_regtest"
+  "../../bin/regtest/groupby_array_regtest.pdb"
+  "CMakeFiles/groupby_array_regtest.dir/groupby_array_regtest.cpp.o"
+  "CMakeFiles/groupby_array_regtest.dir/groupby_array_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/groupby_array_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/groupby_regtest"
+  "../../bin/regtest/groupby_regtest.pdb"
+  "CMakeFiles/groupby_regtest.dir/groupby_regtest.cpp.o"
+  "CMakeFiles/groupby_regtest.dir/groupby_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/groupby_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
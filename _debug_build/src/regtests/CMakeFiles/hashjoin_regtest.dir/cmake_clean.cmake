@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/hashjoin_regtest"
+  "../../bin/regtest/hashjoin_regtest.pdb"
+  "CMakeFiles/hashjoin_regtest.dir/hashjoin_regtest.cpp.o"
+  "CMakeFiles/hashjoin_regtest.dir/hashjoin_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/hashjoin_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
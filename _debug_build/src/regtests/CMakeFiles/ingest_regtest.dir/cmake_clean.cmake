@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/ingest_regtest"
+  "../../bin/regtest/ingest_regtest.pdb"
+  "CMakeFiles/ingest_regtest.dir/ingest_regtest.cpp.o"
+  "CMakeFiles/ingest_regtest.dir/ingest_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ingest_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/loadgraph_regtest"
+  "../../bin/regtest/loadgraph_regtest.pdb"
+  "CMakeFiles/loadgraph_regtest.dir/loadgraph_regtest.cpp.o"
+  "CMakeFiles/loadgraph_regtest.dir/loadgraph_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/loadgraph_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/parallelread_regtest"
+  "../../bin/regtest/parallelread_regtest.pdb"
+  "CMakeFiles/parallelread_regtest.dir/parallelread_regtest.cpp.o"
+  "CMakeFiles/parallelread_regtest.dir/parallelread_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/parallelread_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/pin_regtest"
+  "../../bin/regtest/pin_regtest.pdb"
+  "CMakeFiles/pin_regtest.dir/pin_regtest.cpp.o"
+  "CMakeFiles/pin_regtest.dir/pin_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/pin_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
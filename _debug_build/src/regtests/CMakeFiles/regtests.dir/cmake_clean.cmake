@@ -0,0 +1,8 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/regtests"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang )
+  include(CMakeFiles/regtests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/scan_regtest"
+  "../../bin/regtest/scan_regtest.pdb"
+  "CMakeFiles/scan_regtest.dir/scan_regtest.cpp.o"
+  "CMakeFiles/scan_regtest.dir/scan_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/scan_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/regtest/scanfilter_regtest"
+  "../../bin/regtest/scanfilter_regtest.pdb"
+  "CMakeFiles/scanfilter_regtest.dir/scanfilter_regtest.cpp.o"
+  "CMakeFiles/scanfilter_regtest.dir/scanfilter_regtest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/scanfilter_regtest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
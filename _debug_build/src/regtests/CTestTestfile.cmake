@@ -0,0 +1,34 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/src/regtests
+# Build directory: /root/repo/_debug_build/src/regtests
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(alloc_regtest "/root/repo/_debug_build/bin/regtest/alloc_regtest")
+set_tests_properties(alloc_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(groupby_array_regtest "/root/repo/_debug_build/bin/regtest/groupby_array_regtest")
+set_tests_properties(groupby_array_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(groupby_regtest "/root/repo/_debug_build/bin/regtest/groupby_regtest")
+set_tests_properties(groupby_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(hashjoin_regtest "/root/repo/_debug_build/bin/regtest/hashjoin_regtest")
+set_tests_properties(hashjoin_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(scan_regtest "/root/repo/_debug_build/bin/regtest/scan_regtest")
+set_tests_properties(scan_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(scanfilter_regtest "/root/repo/_debug_build/bin/regtest/scanfilter_regtest")
+set_tests_properties(scanfilter_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(loadgraph_regtest "/root/repo/_debug_build/bin/regtest/loadgraph_regtest")
+set_tests_properties(loadgraph_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(bfsgraph_regtest "/root/repo/_debug_build/bin/regtest/bfsgraph_regtest")
+set_tests_properties(bfsgraph_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(parallelread_regtest "/root/repo/_debug_build/bin/regtest/parallelread_regtest")
+set_tests_properties(parallelread_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(ingest_regtest "/root/repo/_debug_build/bin/regtest/ingest_regtest")
+set_tests_properties(ingest_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(checksum_regtest "/root/repo/_debug_build/bin/regtest/checksum_regtest")
+set_tests_properties(checksum_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(devicemodel_regtest "/root/repo/_debug_build/bin/regtest/devicemodel_regtest")
+set_tests_properties(devicemodel_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(checkpoint_regtest "/root/repo/_debug_build/bin/regtest/checkpoint_regtest")
+set_tests_properties(checkpoint_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
+add_test(pin_regtest "/root/repo/_debug_build/bin/regtest/pin_regtest")
+set_tests_properties(pin_regtest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/regtests/CMakeLists.txt;14;add_test;/root/repo/src/regtests/CMakeLists.txt;25;create_regtest;/root/repo/src/regtests/CMakeLists.txt;0;")
@@ -0,0 +1,28 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/storage/checksum.cpp" "src/storage/CMakeFiles/storage.dir/checksum.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/checksum.cpp.o.d"
+  "/root/repo/src/storage/device_model.cpp" "src/storage/CMakeFiles/storage.dir/device_model.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/device_model.cpp.o.d"
+  "/root/repo/src/storage/double_write_buffer.cpp" "src/storage/CMakeFiles/storage.dir/double_write_buffer.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/double_write_buffer.cpp.o.d"
+  "/root/repo/src/storage/file_storage.cpp" "src/storage/CMakeFiles/storage.dir/file_storage.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/file_storage.cpp.o.d"
+  "/root/repo/src/storage/file_utils.cpp" "src/storage/CMakeFiles/storage.dir/file_utils.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/file_utils.cpp.o.d"
+  "/root/repo/src/storage/io_engine.cpp" "src/storage/CMakeFiles/storage.dir/io_engine.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/io_engine.cpp.o.d"
+  "/root/repo/src/storage/io_statistics.cpp" "src/storage/CMakeFiles/storage.dir/io_statistics.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/io_statistics.cpp.o.d"
+  "/root/repo/src/storage/sequential_file_storage.cpp" "src/storage/CMakeFiles/storage.dir/sequential_file_storage.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/sequential_file_storage.cpp.o.d"
+  "/root/repo/src/storage/write_ahead_log.cpp" "src/storage/CMakeFiles/storage.dir/write_ahead_log.cpp.o" "gcc" "src/storage/CMakeFiles/storage.dir/write_ahead_log.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_debug_build/src/base/CMakeFiles/base.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,27 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/storage.dir/checksum.cpp.o"
+  "CMakeFiles/storage.dir/checksum.cpp.o.d"
+  "CMakeFiles/storage.dir/device_model.cpp.o"
+  "CMakeFiles/storage.dir/device_model.cpp.o.d"
+  "CMakeFiles/storage.dir/double_write_buffer.cpp.o"
+  "CMakeFiles/storage.dir/double_write_buffer.cpp.o.d"
+  "CMakeFiles/storage.dir/file_storage.cpp.o"
+  "CMakeFiles/storage.dir/file_storage.cpp.o.d"
+  "CMakeFiles/storage.dir/file_utils.cpp.o"
+  "CMakeFiles/storage.dir/file_utils.cpp.o.d"
+  "CMakeFiles/storage.dir/io_engine.cpp.o"
+  "CMakeFiles/storage.dir/io_engine.cpp.o.d"
+  "CMakeFiles/storage.dir/io_statistics.cpp.o"
+  "CMakeFiles/storage.dir/io_statistics.cpp.o.d"
+  "CMakeFiles/storage.dir/sequential_file_storage.cpp.o"
+  "CMakeFiles/storage.dir/sequential_file_storage.cpp.o.d"
+  "CMakeFiles/storage.dir/write_ahead_log.cpp.o"
+  "CMakeFiles/storage.dir/write_ahead_log.cpp.o.d"
+  "libstorage.a"
+  "libstorage.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/storage.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
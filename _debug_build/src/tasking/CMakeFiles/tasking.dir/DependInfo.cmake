@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/tasking/sync_counter.cpp" "src/tasking/CMakeFiles/tasking.dir/sync_counter.cpp.o" "gcc" "src/tasking/CMakeFiles/tasking.dir/sync_counter.cpp.o.d"
+  "/root/repo/src/tasking/task_pool.cpp" "src/tasking/CMakeFiles/tasking.dir/task_pool.cpp.o" "gcc" "src/tasking/CMakeFiles/tasking.dir/task_pool.cpp.o.d"
+  "/root/repo/src/tasking/tasking.cpp" "src/tasking/CMakeFiles/tasking.dir/tasking.cpp.o" "gcc" "src/tasking/CMakeFiles/tasking.dir/tasking.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
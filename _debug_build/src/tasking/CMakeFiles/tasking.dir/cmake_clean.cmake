@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/tasking.dir/sync_counter.cpp.o"
+  "CMakeFiles/tasking.dir/sync_counter.cpp.o.d"
+  "CMakeFiles/tasking.dir/task_pool.cpp.o"
+  "CMakeFiles/tasking.dir/task_pool.cpp.o.d"
+  "CMakeFiles/tasking.dir/tasking.cpp.o"
+  "CMakeFiles/tasking.dir/tasking.cpp.o.d"
+  "libtasking.a"
+  "libtasking.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/tasking.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
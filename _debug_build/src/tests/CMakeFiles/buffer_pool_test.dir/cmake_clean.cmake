@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/buffer_pool_test"
+  "../../bin/test/buffer_pool_test.pdb"
+  "CMakeFiles/buffer_pool_test.dir/buffer_pool_test.cpp.o"
+  "CMakeFiles/buffer_pool_test.dir/buffer_pool_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/buffer_pool_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/double_write_buffer_test"
+  "../../bin/test/double_write_buffer_test.pdb"
+  "CMakeFiles/double_write_buffer_test.dir/double_write_buffer_test.cpp.o"
+  "CMakeFiles/double_write_buffer_test.dir/double_write_buffer_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/double_write_buffer_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
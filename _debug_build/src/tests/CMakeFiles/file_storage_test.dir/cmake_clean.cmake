@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/file_storage_test"
+  "../../bin/test/file_storage_test.pdb"
+  "CMakeFiles/file_storage_test.dir/file_storage_test.cpp.o"
+  "CMakeFiles/file_storage_test.dir/file_storage_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/file_storage_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/page_table_test"
+  "../../bin/test/page_table_test.pdb"
+  "CMakeFiles/page_table_test.dir/page_table_test.cpp.o"
+  "CMakeFiles/page_table_test.dir/page_table_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/page_table_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/prefetcher_test"
+  "../../bin/test/prefetcher_test.pdb"
+  "CMakeFiles/prefetcher_test.dir/prefetcher_test.cpp.o"
+  "CMakeFiles/prefetcher_test.dir/prefetcher_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/prefetcher_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
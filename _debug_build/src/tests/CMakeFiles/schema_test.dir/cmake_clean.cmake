@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/schema_test"
+  "../../bin/test/schema_test.pdb"
+  "CMakeFiles/schema_test.dir/schema_test.cpp.o"
+  "CMakeFiles/schema_test.dir/schema_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/schema_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
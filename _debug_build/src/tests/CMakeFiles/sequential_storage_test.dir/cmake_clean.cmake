@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/sequential_storage_test"
+  "../../bin/test/sequential_storage_test.pdb"
+  "CMakeFiles/sequential_storage_test.dir/sequential_storage_test.cpp.o"
+  "CMakeFiles/sequential_storage_test.dir/sequential_storage_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/sequential_storage_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
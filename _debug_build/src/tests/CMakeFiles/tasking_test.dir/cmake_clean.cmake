@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/tasking_test"
+  "../../bin/test/tasking_test.pdb"
+  "CMakeFiles/tasking_test.dir/tasking_test.cpp.o"
+  "CMakeFiles/tasking_test.dir/tasking_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/tasking_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../../bin/test/write_ahead_log_test"
+  "../../bin/test/write_ahead_log_test.pdb"
+  "CMakeFiles/write_ahead_log_test.dir/write_ahead_log_test.cpp.o"
+  "CMakeFiles/write_ahead_log_test.dir/write_ahead_log_test.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/write_ahead_log_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,26 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/src/tests
+# Build directory: /root/repo/_debug_build/src/tests
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(file_storage_test "/root/repo/_debug_build/bin/test/file_storage_test")
+set_tests_properties(file_storage_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(sequential_storage_test "/root/repo/_debug_build/bin/test/sequential_storage_test")
+set_tests_properties(sequential_storage_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(write_ahead_log_test "/root/repo/_debug_build/bin/test/write_ahead_log_test")
+set_tests_properties(write_ahead_log_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(double_write_buffer_test "/root/repo/_debug_build/bin/test/double_write_buffer_test")
+set_tests_properties(double_write_buffer_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(page_table_test "/root/repo/_debug_build/bin/test/page_table_test")
+set_tests_properties(page_table_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(prefetcher_test "/root/repo/_debug_build/bin/test/prefetcher_test")
+set_tests_properties(prefetcher_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(buffer_pool_test "/root/repo/_debug_build/bin/test/buffer_pool_test")
+set_tests_properties(buffer_pool_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(buffer_pool_set_test "/root/repo/_debug_build/bin/test/buffer_pool_set_test")
+set_tests_properties(buffer_pool_set_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(tasking_test "/root/repo/_debug_build/bin/test/tasking_test")
+set_tests_properties(tasking_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
+add_test(schema_test "/root/repo/_debug_build/bin/test/schema_test")
+set_tests_properties(schema_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/src/tests/CMakeLists.txt;12;add_test;/root/repo/src/tests/CMakeLists.txt;23;create_test;/root/repo/src/tests/CMakeLists.txt;0;")
@@ -27,6 +27,10 @@ enum class ErrorCode : uint8_t {
   _ERROR_KEYWORD(E_STORAGE_UNEXPECTED_READ_ERROR , "STORAGE Unexpected read error"),
   _ERROR_KEYWORD(E_STORAGE_UNEXPECTED_WRITE_ERROR , "STORAGE Unexpected write error"),
   _ERROR_KEYWORD(E_STORAGE_CRITICAL_ERROR , "STORAGE Critical error"),
+  _ERROR_KEYWORD(E_STORAGE_IO_QUEUE_FULL , "STORAGE I/O queue full"),
+  _ERROR_KEYWORD(E_STORAGE_CHECKSUM_MISMATCH , "STORAGE Checksum mismatch"),
+  _ERROR_KEYWORD(E_STORAGE_INVALID_LOG , "STORAGE Invalid write-ahead log"),
+  _ERROR_KEYWORD(E_STORAGE_INVALID_DOUBLE_WRITE_BUFFER , "STORAGE Invalid double-write buffer"),
 
   // BUFFER POOL ERRORS
   _ERROR_KEYWORD(E_BUFPOOL_OUT_OF_MEMORY , "BUFPOOL Out of memory"),
@@ -36,8 +40,9 @@ enum class ErrorCode : uint8_t {
   _ERROR_KEYWORD(E_BUFPOOL_FREE_PAGE_NOT_IN_FREELIST , "BUFPOOL Free page in free list"),
   _ERROR_KEYWORD(E_BUFPOOL_BUFFER_DESCRIPTOR_INCORRECT_DATA , "BUFPOOL Buffer Descriptor incorrect data "),
   _ERROR_KEYWORD(E_BUFPOOL_FREE_PAGE_MAPPED_TO_BUFFER , "BUFPOOL Free page mapped to buffer"),
-  _ERROR_KEYWORD(E_BUFPOOL_NO_THREADS_AVAILABLE_FOR_PREFETCHING , "BUFPOOL No threads available for prefetching"),
   _ERROR_KEYWORD(E_BUFPOOL_NUMA_API_NOT_SUPPORTED , "BUFPOOL NUMA API not supported"),
+  _ERROR_KEYWORD(E_BUFPOOL_READ_ONLY , "BUFPOOL Buffer Pool is read-only"),
+  _ERROR_KEYWORD(E_BUFPOOL_NO_WRITE_AHEAD_LOG , "BUFPOOL Write-ahead log not enabled"),
 
   // SCHEMA ERRORS
   
@@ -11,4 +11,6 @@
 
 #define SMILE_NOT_INSTANTIABLE( classname ) classname() = delete;
 
+#define CACHE_LINE_SIZE 64
+
 #endif
@@ -11,7 +11,8 @@ SMILE_NS_BEGIN
 
 Schema::Schema(BufferPool* bufferPool) noexcept : 
   m_nextTypeId{0},
-  p_bufferPool{bufferPool} {
+  p_bufferPool{bufferPool},
+  m_pageSizeClasses{} {
 
 }
 
@@ -160,6 +161,7 @@ ErrorCode Schema::newNodeType(const char* name) noexcept {
   std::strcpy(element.m_nodeInfo.m_name, name);
   element.m_nodeInfo.m_typeId = m_nextTypeId;
   element.m_structType = DataStructureType::E_NO_STRUCT;
+  element.m_pageSizeClass = getPageSizeClass(DataStructureType::E_NO_STRUCT);
   element.m_entryPage = INVALID_PAGE_ID;
   m_nextTypeId++;
   m_nodes.insert(std::make_pair(name, element));
@@ -177,6 +179,14 @@ ErrorCode Schema::getNodeType(const char* name, NodeInfo* nodeInfo ) const noexc
   return ErrorCode::E_NO_ERROR;
 }
 
+void Schema::setPageSizeClass(DataStructureType structType, pageSizeClass_t sizeClass) noexcept {
+  m_pageSizeClasses[static_cast<uint16_t>(structType)] = sizeClass;
+}
+
+pageSizeClass_t Schema::getPageSizeClass(DataStructureType structType) const noexcept {
+  return m_pageSizeClasses[static_cast<uint16_t>(structType)];
+}
+
 SMILE_NS_END
 
 
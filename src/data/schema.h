@@ -5,6 +5,7 @@
 
 #include "../base/base.h"
 #include "../storage/types.h"
+#include "../memory/types.h"
 #include <map>
 #include <list>
 
@@ -88,6 +89,12 @@ struct SchemaElement {
    */
   DataStructureType m_structType;
 
+  /**
+   * @brief The page size class of the pages of this structure, including
+   * its entry page
+   */
+  pageSizeClass_t   m_pageSizeClass;
+
   /**
    * @brief The page that is the entry point of this structure
    */
@@ -137,6 +144,25 @@ public:
    */
   ErrorCode getNodeType(const char* name, NodeInfo* nodeInfo ) const noexcept;
 
+  /**
+   * @brief Sets the page size class of the structures of a type created
+   * from now on, for instance small pages for indexes and large pages for
+   * CSRs. Every class is 0 by default.
+   *
+   * @param structType The type of structure
+   * @param sizeClass The page size class of its pages
+   */
+  void setPageSizeClass(DataStructureType structType, pageSizeClass_t sizeClass) noexcept;
+
+  /**
+   * @brief Gets the page size class of the structures of a type 
+   *
+   * @param structType The type of structure
+   *
+   * @return The page size class of its pages
+   */
+  pageSizeClass_t getPageSizeClass(DataStructureType structType) const noexcept;
+
 private:
 
   /**
@@ -149,6 +175,11 @@ private:
    */
   BufferPool* p_bufferPool;
 
+  /**
+   * @brief The page size class of each type of structure
+   */
+  pageSizeClass_t m_pageSizeClasses[static_cast<uint16_t>(DataStructureType::E_NO_STRUCT)+1];
+
   /**
    * @brief The list of schema pages already allocated to store the schema
    */
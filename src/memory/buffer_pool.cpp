@@ -4,15 +4,103 @@
 #include "../tasking/tasking.h"
 #include <assert.h>
 #include <algorithm>
+#include <cstdio>
+#include <errno.h>
 #include <iostream>
+#include <thread>
 #include <numa.h>
 
 SMILE_NS_BEGIN
 
+/**
+ * Opens the given engine on first use, or reopens it if it is idle and a
+ * deeper queue is requested
+ *
+ * @param engine The engine to open
+ * @param queueDepth The queue depth of the engine. 0 disables the engine.
+ * @return The engine, or nullptr if it is disabled
+ */
+static IOEngine* openIOEngine( IOEngine* engine,
+                               uint32_t queueDepth ) noexcept {
+  if (queueDepth == 0) {
+    return nullptr;
+  }
+  if (engine->isOpened() && engine->queueDepth() < queueDepth && engine->inFlight() == 0) {
+    engine->close();
+  }
+  if (!engine->isOpened()) {
+    engine->open(queueDepth);
+  }
+  return engine;
+}
+
+/**
+ * Gets the I/O engine of the calling thread, opening it on first use
+ *
+ * @param queueDepth The queue depth of the engine. 0 disables the engine.
+ * @return The engine of the thread, or nullptr if it is disabled
+ */
+static IOEngine* getIOEngine( uint32_t queueDepth ) noexcept {
+  static thread_local IOEngine engine;
+  return openIOEngine(&engine, queueDepth);
+}
+
+/**
+ * Gets the I/O engine shared by the tasks of the calling thread, opening it
+ * on first use. Tasks yield while their requests are in flight, so these
+ * are kept apart from the ones of getIOEngine, whose callers expect to reap
+ * only their own.
+ *
+ * @param queueDepth The queue depth of the engine. 0 disables the engine.
+ * @return The engine of the thread, or nullptr if it is disabled
+ */
+static IOEngine* getTaskIOEngine( uint32_t queueDepth ) noexcept {
+  static thread_local IOEngine engine;
+  return openIOEngine(&engine, queueDepth);
+}
+
+/**
+ * Lets other work run while waiting for a storage request of another thread.
+ * Lightweight threads yield to the other tasks of their thread.
+ */
+static void yieldWhileWaiting() noexcept {
+  if (getCurrentThreadId() != INVALID_THREAD_ID) {
+    yield();
+  } else {
+    std::this_thread::yield();
+  }
+}
+
+uint64_t BufferDescriptor::lockHeader() noexcept {
+  uint64_t state;
+  while (!tryLockHeader(&state)) {
+    yieldWhileWaiting();
+  }
+  return state;
+}
+
+bool BufferDescriptor::tryLockHeader( uint64_t* state ) noexcept {
+  uint64_t expected = m_state.load(std::memory_order_relaxed);
+  while ((expected & BUF_LOCKED) == 0) {
+    if (m_state.compare_exchange_weak(expected, expected | BUF_LOCKED, std::memory_order_acquire)) {
+      *state = expected | BUF_LOCKED;
+      return true;
+    }
+  }
+  return false;
+}
+
+void BufferDescriptor::unlockHeader( uint64_t state ) noexcept {
+  m_state.store(state & ~BUF_LOCKED, std::memory_order_release);
+}
+
 BufferPool::BufferPool() noexcept : 
+p_descriptors{nullptr},
 p_buffersData{nullptr},
-m_nextCSVictim{0},
-m_currentThread{0},
+m_sizePerNode{0},
+p_mapping{nullptr},
+m_stopWriteBack{false},
+m_recovering{false},
 m_opened{false} {	
   p_buffersData = nullptr;
 }
@@ -23,37 +111,68 @@ BufferPool::~BufferPool() noexcept {
 
 ErrorCode BufferPool::allocatePartitions() noexcept {
 
-  size_t pageSizeKB = m_storage.getPageSize() / 1024;
-  size_t poolElems = m_config.m_poolSizeKB / pageSizeKB;
+  size_t pageSize = m_storage.getPageSize();
+  size_t poolElems = m_config.m_poolSizeKB*1024 / pageSize;
+
+  // Depending on the partition, buffers are allocated into different numa
+  // nodes. We count how many buffers each node holds to size its region.
+  std::vector<size_t> buffersPerNode(m_numaNodes, 0);
+  for (uint32_t i = 0; i < poolElems; ++i) {
+    uint32_t part = i % m_config.m_numberOfPartitions;
+    ++buffersPerNode[part % m_numaNodes];
+  }
+  m_sizePerNode = *std::max_element(buffersPerNode.begin(), buffersPerNode.end()) * pageSize;
 
   // We acquire large buffers, one per numa node to hold the buffers of the
-  // buffer pool
+  // buffer pool. Regions are aligned to the I/O alignment of the storage, and
+  // since the page size is a multiple of it, so is every buffer, which direct
+  // I/O requires.
   p_buffersData = new char*[m_numaNodes];
-  size_t sizePerNode = m_config.m_poolSizeKB*1024 / m_numaNodes;
   for(uint32_t i = 0; i < m_numaNodes; ++i) {
 #ifdef NUMA
-    p_buffersData[i] = (char*) numa_alloc_onnode( sizePerNode, i);
+    // numa_alloc_onnode maps whole memory pages, which are already aligned
+    p_buffersData[i] = (char*) numa_alloc_onnode( m_sizePerNode, i);
 #else
-    p_buffersData[i] = new (std::nothrow) char[sizePerNode];
+    size_t alignment = std::max(m_storage.getIOAlignment(), Platform::getSystemPageSize());
+    void* region = nullptr;
+    p_buffersData[i] = posix_memalign(&region, alignment, m_sizePerNode) == 0 ? static_cast<char*>(region) : nullptr;
 #endif
     assert(p_buffersData[i] != nullptr && "Unable to allocate memory buffer");
     if(p_buffersData[i] == nullptr) {
       return ErrorCode::E_BUFPOOL_OUT_OF_MEMORY;
     }
-    memset(p_buffersData[i], '0', sizePerNode);
+    assert(reinterpret_cast<uintptr_t>(p_buffersData[i]) % m_storage.getIOAlignment() == 0 && "Misaligned memory buffer");
+    memset(p_buffersData[i], '0', m_sizePerNode);
+  }
+
+  // Descriptors take a cache line each, so that pins of a buffer do not
+  // invalidate the descriptors of its neighbours. The pointers to the
+  // buffers never change, so they are kept apart.
+  void* descriptors = nullptr;
+  if (posix_memalign(&descriptors, CACHE_LINE_SIZE, poolElems*sizeof(BufferDescriptor)) != 0) {
+    return ErrorCode::E_BUFPOOL_OUT_OF_MEMORY;
+  }
+  p_descriptors = static_cast<BufferDescriptor*>(descriptors);
+  for (uint32_t i = 0; i < poolElems; ++i) {
+    new (&p_descriptors[i]) BufferDescriptor();
   }
 
-  // We initialize the descriptors with pointers to their assigned buffer
-  // section
-  m_descriptors.resize(poolElems);
+  // We initialize the buffer pointers to their assigned buffer section
+  std::vector<size_t> nextBufferInNode(m_numaNodes, 0);
+  m_buffers.resize(poolElems);
   for (uint32_t i = 0; i < poolElems; ++i) {
     uint32_t part = i % m_config.m_numberOfPartitions;
     m_partitions[part].m_freeBuffers.push(i);
-    m_descriptors[i].m_contentLock = std::make_unique<std::shared_timed_mutex>();
-    // Depending on the partition, buffers are allocated into different numa nodes
     uint32_t node = part % m_numaNodes;
     char* buffer = p_buffersData[node];
-    m_descriptors[i].p_buffer = buffer + sizeof(char)*(pageSizeKB*1024)*i/m_numaNodes;
+    m_buffers[i] = buffer + pageSize*nextBufferInNode[node]++;
+  }
+
+  // A partition never holds more pages than buffers. Its clock hand starts
+  // at its first buffer.
+  for (uint32_t p = 0; p < m_config.m_numberOfPartitions; ++p) {
+    m_partitions[p].m_bufferToPageMap.init(m_partitions[p].m_freeBuffers.size());
+    m_partitions[p].m_nextCSVictim = p;
   }
   return ErrorCode::E_NO_ERROR;
 }
@@ -75,10 +194,6 @@ ErrorCode BufferPool::open( const BufferPoolConfig& bpConfig,
     return ErrorCode::E_BUFPOOL_POOL_SIZE_NOT_MULTIPLE_OF_PAGE_SIZE;
   }
 
-  if ( getNumThreads() == 0 && bpConfig.m_prefetchingDegree > 0 ) {
-    return ErrorCode::E_BUFPOOL_NO_THREADS_AVAILABLE_FOR_PREFETCHING;
-  }
-
   m_numaNodes = 1;
 #ifdef NUMA
   if ( numa_available() < 0 ) {
@@ -87,9 +202,48 @@ ErrorCode BufferPool::open( const BufferPoolConfig& bpConfig,
   m_numaNodes = numa_max_node() + 1;
 #endif
 
-  m_storage.open(path);
+  ErrorCode err = m_storage.open(path);
+  if(err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  m_storage.setDeviceProfile(m_config.m_deviceProfile);
+
+  // Pages are served straight from the mapping, so neither buffers nor the
+  // allocation table are needed
+  if (m_config.m_readOnlyMapping) {
+    if((err = m_storage.map(&p_mapping)) != ErrorCode::E_NO_ERROR) {
+      m_storage.close();
+      return err;
+    }
+    m_opened = true;
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  // Pages torn by a crash in the middle of a checkpoint, including those of
+  // the allocation table, are restored before anything is read
+  if (m_config.m_doubleWrite) {
+    std::string dwbPath = path + ".dwb";
+    if (std::ifstream(dwbPath)) {
+      err = m_dwb.open(dwbPath, m_storage.getPageSize(), [this] (const pageId_t& pId, const char* data) {
+        return restorePage(pId, data);
+      });
+      if (err == ErrorCode::E_NO_ERROR && m_dwb.getNumRestored() > 0) {
+        err = unstagePages();
+      }
+    }
+    else {
+      err = m_dwb.create(dwbPath, m_storage.getPageSize());
+    }
+    if (err != ErrorCode::E_NO_ERROR) {
+      if (m_dwb.isOpened()) {
+        m_dwb.close();
+      }
+      m_storage.close();
+      return err;
+    }
+  }
 
-  ErrorCode err = allocatePartitions(); 
+  err = allocatePartitions(); 
   if(err != ErrorCode::E_NO_ERROR) {
     return err;
   }
@@ -97,13 +251,42 @@ ErrorCode BufferPool::open( const BufferPoolConfig& bpConfig,
   loadAllocationTable();
 
   m_opened = true;
+
+  // Updates logged after the last checkpoint are redone and checkpointed
+  // right away, which truncates the log. Both pin and checkpoint take the
+  // partition locks.
+  partitionGuards.clear();
+  if (m_config.m_writeAheadLog) {
+    std::string walPath = path + ".wal";
+    if (std::ifstream(walPath)) {
+      m_recovering = true;
+      err = m_wal.open(walPath, [this] (const WALRecord& record, const char* data) {
+        return redo(record, data);
+      });
+      m_recovering = false;
+    }
+    else {
+      err = m_wal.create(walPath);
+    }
+    if (err == ErrorCode::E_NO_ERROR) {
+      err = checkpoint();
+    }
+    if (err != ErrorCode::E_NO_ERROR) {
+      close();
+      return err;
+    }
+  }
+
+  startWriteBack();
+  startPrefetch();
   return ErrorCode::E_NO_ERROR;
 }
 
 ErrorCode BufferPool::create( const BufferPoolConfig& bpConfig, 
                               const std::string& path, 
                               const FileStorageConfig& fsConfig, 
-                              const bool& overwrite ) noexcept {
+                              const bool& overwrite,
+                              const std::vector<std::string>& stripePaths ) noexcept {
 
   m_config = bpConfig;
 
@@ -115,12 +298,12 @@ ErrorCode BufferPool::create( const BufferPoolConfig& bpConfig,
     partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
   }
 
-  if ( m_config.m_poolSizeKB % fsConfig.m_pageSizeKB != 0 ) {
-    return ErrorCode::E_BUFPOOL_POOL_SIZE_NOT_MULTIPLE_OF_PAGE_SIZE;
+  if ( m_config.m_readOnlyMapping ) {
+    return ErrorCode::E_BUFPOOL_READ_ONLY;
   }
 
-  if ( getNumThreads() == 0 && m_config.m_prefetchingDegree > 0 ) {
-    return ErrorCode::E_BUFPOOL_NO_THREADS_AVAILABLE_FOR_PREFETCHING;
+  if ( m_config.m_poolSizeKB % fsConfig.m_pageSizeKB != 0 ) {
+    return ErrorCode::E_BUFPOOL_POOL_SIZE_NOT_MULTIPLE_OF_PAGE_SIZE;
   }
 
   m_numaNodes = 1;
@@ -131,32 +314,84 @@ ErrorCode BufferPool::create( const BufferPoolConfig& bpConfig,
   m_numaNodes = numa_max_node() + 1;
 #endif
 
-  m_storage.create(path, fsConfig, overwrite);
+  ErrorCode err = m_storage.create(path, fsConfig, overwrite, stripePaths);
+  if(err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  m_storage.setDeviceProfile(m_config.m_deviceProfile);
 
-  ErrorCode err = allocatePartitions(); 
+  err = allocatePartitions(); 
   if(err != ErrorCode::E_NO_ERROR) {
     return err;
   }
 
+  // A log or staged pages left by a previous storage at the same path are
+  // stale, and would be applied by a later open with them enabled
+  if (!m_config.m_writeAheadLog) {
+    std::remove((path + ".wal").c_str());
+  }
+  else if ((err = m_wal.create(path + ".wal", true)) != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  if (!m_config.m_doubleWrite) {
+    std::remove((path + ".dwb").c_str());
+  }
+  else if ((err = m_dwb.create(path + ".dwb", m_storage.getPageSize(), true)) != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+
   m_opened = true;
+  startWriteBack();
+  startPrefetch();
   return ErrorCode::E_NO_ERROR;
 }
 
 ErrorCode BufferPool::close() noexcept {
   assert(m_opened && "Attempting to close a non-opened BufferPool");
+  stopPrefetch();
+  stopWriteBack();
+
+  if (m_config.m_readOnlyMapping) {
+    m_storage.close();
+    p_mapping = nullptr;
+    m_partitions.clear();
+    m_opened = false;
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  {
+    std::vector<std::unique_lock<std::mutex>> partitionGuards;
+    for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
+      partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
+    }
+    waitForWriteBacks(&partitionGuards);
+  }
+
   // Flush dirty buffers
-  flushDirtyBuffers();
+  lsn_t lsn = m_wal.isOpened() ? m_wal.getNextLSN() : 0;
+  ErrorCode err = flushDirtyBuffers();
 
   // Save m_allocationTable state to disk.
-  storeAllocationTable();
+  if (storeAllocationTable() == ErrorCode::E_NO_ERROR) {
+    discardReleasedPages();
+  }
+
+  if (m_wal.isOpened()) {
+    if (err == ErrorCode::E_NO_ERROR) {
+      truncateLog(lsn);
+    }
+    m_wal.close();
+  }
+
+  if (m_dwb.isOpened()) {
+    m_dwb.close();
+  }
 
-  size_t sizePerNode = m_config.m_poolSizeKB*1024 / m_numaNodes;
   for(uint32_t i = 0; i < m_numaNodes; ++i) {
 #ifdef NUMA
-    numa_free(p_buffersData[i], sizePerNode);
+    numa_free(p_buffersData[i], m_sizePerNode);
 #else
-    char* buffer = p_buffersData[i];
-    delete [] buffer; 
+    free(p_buffersData[i]);
 #endif
   }
 
@@ -164,7 +399,13 @@ ErrorCode BufferPool::close() noexcept {
 
   m_storage.close();
 
-  m_descriptors.clear();
+  // Swips outlive the buffers they are swizzled to
+  for (bufferId_t bId = 0; bId < m_buffers.size(); ++bId) {
+    unswizzleBuffer(bId);
+  }
+  free(p_descriptors);
+  p_descriptors = nullptr;
+  m_buffers.clear();
   m_partitions.clear();
   m_allocationTable.clear();
 
@@ -177,6 +418,10 @@ ErrorCode BufferPool::alloc( BufferHandler* bufferHandler ) noexcept {
   assert(m_opened && "BufferPool is not opened");
   ErrorCode err = ErrorCode::E_NO_ERROR;
 
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_BUFPOOL_READ_ONLY;
+  }
+
   // Before continuing we need to make sure that no operations are being performed
   std::vector<std::unique_lock<std::mutex>> partitionGuards;
   for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
@@ -185,13 +430,11 @@ ErrorCode BufferPool::alloc( BufferHandler* bufferHandler ) noexcept {
 
   bufferId_t bId;
   pageId_t pId;
-  // Check if there is a free page in any partition, else reserve space.
-  bool found = getFreePage(&pId);
-  if (!found) {
-    if( (err = reservePages(1, &pId)) != ErrorCode::E_NO_ERROR) {
+  // Check if there is a free page in any partition, else grow the storage.
+  while (!getFreePage(&pId)) {
+    if( (err = reservePages(getGrowthPages(), &pId)) != ErrorCode::E_NO_ERROR) {
       return err;
     }
-    getFreePage(&pId);
   }
   // Set page as allocated.		
   m_allocationTable.set(pId);
@@ -200,22 +443,22 @@ ErrorCode BufferPool::alloc( BufferHandler* bufferHandler ) noexcept {
   // Take the lock of the partition
   uint32_t part = pId % m_config.m_numberOfPartitions;
   std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);		
+  waitForWriteBack(pId, &partitionGuard);
   // Get an empty buffer pool slot for the page and update the buffer table.
   if( (err = getEmptySlot(&bId, part) ) != ErrorCode::E_NO_ERROR) {
     return err;
   }
-  m_partitions[part].m_bufferToPageMap[pId] = bId;
-  partitionGuard.unlock();
 
-  std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[bId].m_contentLock);
-  // Fill the buffer descriptor.
-  m_descriptors[bId].m_referenceCount = 1;
-  m_descriptors[bId].m_usageCount = 1;
-  m_descriptors[bId].m_dirty = 0;
-  m_descriptors[bId].m_pageId = pId;
+  // Fill the buffer descriptor before the page is visible to pins.
+  p_descriptors[bId].lockHeader();
+  p_descriptors[bId].m_pageId = pId;
+  p_descriptors[bId].m_pageLSN = 0;
+  p_descriptors[bId].unlockHeader(BUF_IN_USE | BUF_REFCOUNT_ONE | BUF_USAGECOUNT_ONE);
+  m_partitions[part].m_bufferToPageMap.insert(pId, bId);
+  partitionGuard.unlock();
 
   // Set BufferHandler for the allocated buffer.
-  bufferHandler->m_buffer 	= m_descriptors[bId].p_buffer;
+  bufferHandler->m_buffer 	= m_buffers[bId];
   bufferHandler->m_pId 		= pId;
   bufferHandler->m_bId 		= bId;
 
@@ -227,38 +470,60 @@ ErrorCode BufferPool::release( const pageId_t& pId ) noexcept {
   assert(pId <= m_storage.size() && "Page not allocated");
   assert(!isProtected(pId) && "Unable to access protected page");
 
-  // Take the lock of the partition
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_BUFPOOL_READ_ONLY;
+  }
+
+  // Releases are redone too, so that updates logged before them do not
+  // allocate the page again
+  if (m_wal.isOpened()) {
+    lsn_t lsn;
+    ErrorCode err = m_wal.append(WALRecordType::E_PAGE_RELEASE, pId, 0, nullptr, 0, &lsn);
+    if (err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+  }
+
+  // Take the lock of the partition. A write-back of the page still in flight
+  // would overwrite it once allocated again, or land in its punched hole.
   uint32_t part = pId % m_config.m_numberOfPartitions;
   std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);
+  waitForWriteBack(pId, &partitionGuard);
 
   // Evict the page in case it is in the Buffer Pool
-  auto it = m_partitions[part].m_bufferToPageMap.find(pId);
-  if (it != m_partitions[part].m_bufferToPageMap.end()) {
-    bufferId_t bId = it->second;
+  bufferId_t bId;
+  if (m_partitions[part].m_bufferToPageMap.find(pId, &bId)) {
     // Delete page entry from buffer table.
     m_partitions[part].m_bufferToPageMap.erase(pId);
+
+    // Update buffer descriptor before the buffer can be reused. If the
+    // buffer is dirty we must store it to disk.
+    uint64_t state = p_descriptors[bId].lockHeader();
+    if( state & BUF_DIRTY ) {
+      flushLog(bId);
+      m_storage.write(m_buffers[bId], p_descriptors[bId].m_pageId);
+    }
+    p_descriptors[bId].m_pageId = 0;
+    p_descriptors[bId].m_version.fetch_add(2, std::memory_order_acq_rel);
+    unswizzleBuffer(bId);
+    p_descriptors[bId].unlockHeader(0);
     m_partitions[part].m_freeBuffers.push(bId);
+
     // Set page as unallocated.
     m_allocationTable.set(pId, 0);
     m_partitions[part].m_freePages.push_back(pId);
-    partitionGuard.unlock();
-
-    // Update buffer descriptor.
-    std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[bId].m_contentLock);
-    // If the buffer is dirty we must store it to disk.
-    if( m_descriptors[bId].m_dirty ) {
-      m_storage.write(m_descriptors[bId].p_buffer, m_descriptors[bId].m_pageId);
+    if (m_config.m_punchHoles) {
+      m_partitions[part].m_releasedPages.push_back(pId);
     }
-    m_descriptors[bId].m_inUse = false;
-    m_descriptors[bId].m_referenceCount = 0;
-    m_descriptors[bId].m_usageCount = 0;
-    m_descriptors[bId].m_dirty = 0;
-    m_descriptors[bId].m_pageId = 0;
+    partitionGuard.unlock();
   }
   else {
     // Set page as unallocated.
     m_allocationTable.set(pId, 0);
     m_partitions[part].m_freePages.push_back(pId);
+    if (m_config.m_punchHoles) {
+      m_partitions[part].m_releasedPages.push_back(pId);
+    }
     partitionGuard.unlock();
   }		
 
@@ -272,240 +537,872 @@ ErrorCode BufferPool::pin( const pageId_t& pId,
   assert(pId <= m_storage.size() && "Page not allocated");
   assert(!isProtected(pId) && "Unable to access protected page");
 
-  ErrorCode err = ErrorCode::E_NO_ERROR;
+  if (m_config.m_readOnlyMapping) {
+    if(bufferHandler != nullptr) {
+      bufferHandler->m_buffer = const_cast<char*>(p_mapping) + pId*m_storage.getPageSize();
+      bufferHandler->m_pId 	= pId;
+      bufferHandler->m_bId 	= 0;
+    }
+    return ErrorCode::E_NO_ERROR;
+  }
 
-  // Take the lock of the partition
+  ErrorCode err = ErrorCode::E_NO_ERROR;
   uint32_t part = pId % m_config.m_numberOfPartitions;
-  std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);
 
+  // Look for the desired page in the Buffer Pool. Hits take no partition
+  // lock, but the buffer found may have been reused for another page
+  // meanwhile, in which case the page is looked up again under the lock.
   bufferId_t bId;
-  // Look for the desired page in the Buffer Pool.
-  auto it = m_partitions[part].m_bufferToPageMap.find(pId);
-
-  // If it is not already there, get an empty slot for the page and load it
-  // from disk. Else take the corresponding slot. Update Buffer Descriptor 
-  // accordingly.
-  if (it == m_partitions[part].m_bufferToPageMap.end()) {
-    if(( err = getEmptySlot(&bId, part) ) != ErrorCode::E_NO_ERROR) {
-      return err;
+  bool found = m_partitions[part].m_bufferToPageMap.find(pId, &bId) && 
+               referenceBuffer(bId, pId, enablePrefetch);
+  if (!found) {
+    // Take the lock of the partition
+    std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);
+    waitForWriteBack(pId, &partitionGuard);
+    found = m_partitions[part].m_bufferToPageMap.find(pId, &bId);
+
+    // If it is not already there, get an empty slot for the page and load it
+    // from disk. Else take the corresponding slot, which holds the page
+    // while the partition is locked.
+    if (!found) {
+      if(( err = getEmptySlot(&bId, part) ) != ErrorCode::E_NO_ERROR) {
+        return err;
+      }
+      beginLoad(bId, pId, enablePrefetch);
+      m_partitions[part].m_bufferToPageMap.insert(pId, bId);
+      partitionGuard.unlock();
+
+      // Prefetched pages are verified on their first pin in lazy mode
+      err = m_storage.read(m_buffers[bId], pId, false);
+      ErrorCode verifyErr = endLoad(bId, enablePrefetch || !m_config.m_lazyChecksums);
+      if (err == ErrorCode::E_NO_ERROR) {
+        err = verifyErr;
+      }
+    }
+    else {
+      // Buffers hold the pages mapped to them while the partition is locked
+      bool referenced = referenceBuffer(bId, pId, enablePrefetch);
+      assert(referenced && "Page mapped to another buffer");
+      (void) referenced;
     }
-    m_partitions[part].m_bufferToPageMap[pId] = bId;
-    partitionGuard.unlock();
-
-    std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[bId].m_contentLock);
-    m_storage.read(m_descriptors[bId].p_buffer, pId);
-    if (enablePrefetch) m_descriptors[bId].m_referenceCount = 1;
-    if (enablePrefetch) m_descriptors[bId].m_usageCount = 1;
-    m_descriptors[bId].m_dirty = 0;
-    m_descriptors[bId].m_pageId = pId;
   }
-  else {
-    partitionGuard.unlock();
 
-    bId = it->second;
-    std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[bId].m_contentLock);
-    if (enablePrefetch) ++m_descriptors[bId].m_referenceCount;
-    if (enablePrefetch) ++m_descriptors[bId].m_usageCount;
-    m_descriptors[bId].m_pageId = pId;
-  }		
+  // The page may still be being read by another pin. Since we hold a
+  // reference, the buffer cannot be evicted while we wait for it.
+  if (found && enablePrefetch) {
+    err = waitForLoad(bId);
+  }
 
   if(bufferHandler != nullptr) {
-    bufferHandler->m_buffer = m_descriptors[bId].p_buffer;
+    bufferHandler->m_buffer = m_buffers[bId];
     bufferHandler->m_pId 	= pId;
     bufferHandler->m_bId 	= bId;
   }
 
-  if (enablePrefetch && m_config.m_prefetchingDegree > 0) {
-    // Set BufferHandler for the pinned buffer.
-    struct Params{
-      BufferPool*	m_bp;
-      pageId_t 	m_pId;
-      int16_t   m_degree;
-      int16_t   m_size;
-    };
-
-    Params* params = new Params{};
-    params->m_bp = this;
-    params->m_pId = pId;
-    params->m_degree = m_config.m_prefetchingDegree;
-    params->m_size = m_storage.size();
-    Task prefetchPage {
-      [] (void * args) {
-        Params* params = reinterpret_cast<Params*>(args);
-        for (uint32_t i = 0; i < params->m_degree; ++i) {
-          if ( params->m_pId+i+1 < params->m_size ) {
-            params->m_bp->pin(params->m_pId, nullptr, false);
-          }
-        }
-        delete params;
-      },
-      params
-    };
-    executeTaskAsync(m_currentThread, prefetchPage, nullptr);
-    m_currentThread = (m_currentThread + 1) % getNumThreads();
+  if (err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+
+  // Pages that are loaded or protected are not worth prefetching
+  if (enablePrefetch && m_prefetcher.isStarted()) {
+    m_prefetcher.access(pId, m_storage.size(), [this] (const pageId_t& candidate) {
+      bufferId_t loaded;
+      return isProtected(candidate) ||
+             m_partitions[candidate % m_config.m_numberOfPartitions].m_bufferToPageMap.find(candidate, &loaded);
+    });
   }
 
   return ErrorCode::E_NO_ERROR;
 }
 
-ErrorCode BufferPool::unpin( const BufferHandler& handler ) noexcept {
+ErrorCode BufferPool::pinBatch( const pageId_t* pIds,
+                                uint32_t numPages,
+                                BufferHandler* bufferHandlers ) noexcept {
   assert(m_opened && "BufferPool is not opened");
-  assert(handler.m_pId <= m_storage.size() && "Page not allocated");
-  assert(!isProtected(handler.m_pId) && "Unable to access protected page");
-  
-  // Decrement page's reference count.  
-  std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[handler.m_bId].m_contentLock);
-  --m_descriptors[handler.m_bId].m_referenceCount;	
 
-  return ErrorCode::E_NO_ERROR;
+  ErrorCode err = ErrorCode::E_NO_ERROR;
+  IOEngine* engine = getIOEngine(m_config.m_ioQueueDepth);
+  if (engine == nullptr || m_config.m_readOnlyMapping) {
+    for (uint32_t i = 0; i < numPages && err == ErrorCode::E_NO_ERROR; ++i) {
+      err = pin(pIds[i], &bufferHandlers[i]);
+    }
+    return err;
+  }
+  return loadBatch(pIds, numPages, bufferHandlers, engine);
 }
 
-ErrorCode BufferPool::checkpoint() noexcept {
-  assert(m_opened && "BufferPool is not opened");
-  // Before continuing we need to make sure that no operations are being performed
-  std::vector<std::unique_lock<std::mutex>> partitionGuards;
-  for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
-    partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
-  }
+ErrorCode BufferPool::loadBatch( const pageId_t* pIds,
+                                 uint32_t numPages,
+                                 BufferHandler* bufferHandlers,
+                                 IOEngine* engine ) noexcept {
+  ErrorCode err = ErrorCode::E_NO_ERROR;
+  bool pinned = bufferHandlers != nullptr;
+
+  // Pages loaded by this call. Tags identify the first load of a request,
+  // and the lowest bit tells write-backs of dirty victims apart from reads.
+  std::vector<Load> loads;
+  std::vector<struct iovec> iov(numPages);
+  loads.reserve(numPages);
+  std::vector<IOCompletion> completions(engine->queueDepth());
+  auto waitForRoom = [&] (uint32_t numRequests) {
+    while (engine->inFlight() + numRequests > engine->queueDepth()) {
+      uint32_t reaped = engine->reap(completions.data(), completions.size(), 1);
+      for (uint32_t c = 0; c < reaped; ++c) {
+        completeBatchLoad(completions[c], &loads[completions[c].m_tag >> 1]);
+      }
+    }
+  };
+
+  // Misses of contiguous pages of the same stripe are accumulated in a run,
+  // which is read with a single vectored request once it cannot be extended
+  uint32_t maxRunPages = std::max<uint32_t>(1, m_config.m_ioRangeKB*1024 / m_storage.getPageSize());
+  uint32_t runStart = 0;
+  uint32_t runLength = 0;
+  auto issueRun = [&] () {
+    if (runLength > 0) {
+      waitForRoom(1);
+      loads[runStart].m_numPages = runLength;
+      m_storage.readRangeAsync(engine, &iov[runStart], loads[runStart].m_pId, runLength, runStart << 1);
+      runLength = 0;
+    }
+  };
+
+  for (uint32_t i = 0; i < numPages && err == ErrorCode::E_NO_ERROR; ++i) {
+    pageId_t pId = pIds[i];
+    assert(pId <= m_storage.size() && "Page not allocated");
+    assert(!isProtected(pId) && "Unable to access protected page");
+
+    // Hits take no partition lock, as in pin
+    uint32_t part = pId % m_config.m_numberOfPartitions;
+    bufferId_t bId;
+    if (m_partitions[part].m_bufferToPageMap.find(pId, &bId) && referenceBuffer(bId, pId, pinned)) {
+      if (pinned) {
+        bufferHandlers[i].m_buffer  = m_buffers[bId];
+        bufferHandlers[i].m_pId     = pId;
+        bufferHandlers[i].m_bId     = bId;
+      }
+      continue;
+    }
 
-  // Flush dirty buffers
-  flushDirtyBuffers();
-  // Save m_allocationTable state to disk.
-  storeAllocationTable();
+    // Pages that are not pinned may have been released since they were
+    // requested, and they must not be mapped while they are free. The
+    // allocation table only changes under the partition lock.
+    std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);
+    waitForWriteBack(pId, &partitionGuard);
+    if (m_partitions[part].m_bufferToPageMap.find(pId, &bId)) {
+      referenceBuffer(bId, pId, pinned);
+      partitionGuard.unlock();
+    }
+    else if (!pinned && (pId >= m_allocationTable.size() || !m_allocationTable.test(pId))) {
+      continue;
+    }
+    else {
+      pageId_t victim;
+      if ((err = getEmptySlot(&bId, part, &victim)) != ErrorCode::E_NO_ERROR) {
+        break;
+      }
+      if (victim != INVALID_PAGE_ID) {
+        m_partitions[part].m_pendingWriteBacks.insert(victim);
+      }
+      beginLoad(bId, pId, pinned);
+      m_partitions[part].m_bufferToPageMap.insert(pId, bId);
+      partitionGuard.unlock();
+
+      // Prefetched pages are verified on their first pin in lazy mode
+      uint32_t load = loads.size();
+      loads.push_back(Load{bId, pId, victim, 1, pinned || !m_config.m_lazyChecksums});
+      iov[load].iov_base = m_buffers[bId];
+      iov[load].iov_len = m_storage.getPageSize();
+      if (victim != INVALID_PAGE_ID) {
+        // The write-back of a dirty victim is linked to the read, so the
+        // buffer is only overwritten once its old contents are on disk
+        issueRun();
+        waitForRoom(2);
+        m_storage.writeAsync(engine, m_buffers[bId], victim, (load << 1) | 1, true);
+        m_storage.readAsync(engine, m_buffers[bId], pId, load << 1);
+      }
+      else if (runLength > 0 && 
+               runLength < maxRunPages && 
+               runLength < m_storage.getContiguousPages(loads[runStart].m_pId) &&
+               loads[runStart+runLength-1].m_pId + 1 == pId) {
+        ++runLength;
+      }
+      else {
+        issueRun();
+        runStart = load;
+        runLength = 1;
+      }
+    }
 
-  return ErrorCode::E_NO_ERROR;
-}
+    if (pinned) {
+      bufferHandlers[i].m_buffer  = m_buffers[bId];
+      bufferHandlers[i].m_pId     = pId;
+      bufferHandlers[i].m_bId     = bId;
+    }
+  }
+  issueRun();
 
-ErrorCode BufferPool::setPageDirty( const pageId_t& pId ) noexcept {
-  assert(m_opened && "BufferPool is not opened");
-  // Take the lock of the partition
-  uint32_t part = pId % m_config.m_numberOfPartitions;
-  std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);
+  engine->submit();
+  waitForRoom(engine->queueDepth());
 
-  auto it = m_partitions[part].m_bufferToPageMap.find(pId);
-  assert(it != m_partitions[part].m_bufferToPageMap.end() && "Page not present");
-  bufferId_t bId = it->second;
-  partitionGuard.unlock();
-  std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[bId].m_contentLock);
-  m_descriptors[bId].m_dirty = 1;
+  // Pages that were already being loaded by other threads
+  for (uint32_t i = 0; pinned && i < numPages && err == ErrorCode::E_NO_ERROR; ++i) {
+    err = waitForLoad(bufferHandlers[i].m_bId);
+  }
 
-  return ErrorCode::E_NO_ERROR;
+  return err;
 }
 
-ErrorCode BufferPool::getStatistics( BufferPoolStatistics* stats ) noexcept {
+ErrorCode BufferPool::pinAsync( const pageId_t& pId, 
+                                BufferHandler* bufferHandler ) noexcept {
   assert(m_opened && "BufferPool is not opened");
-  // Before continuing we need to make sure that no operations are being performed
-  std::vector<std::unique_lock<std::mutex>> partitionGuards;
-  for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
-    partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
+
+  if (m_config.m_readOnlyMapping || getCurrentThreadId() == INVALID_THREAD_ID) {
+    return pin(pId, bufferHandler);
+  }
+  IOEngine* engine = getTaskIOEngine(m_config.m_ioQueueDepth);
+  if (engine == nullptr) {
+    return pin(pId, bufferHandler);
   }
 
-  size_t numAllocatedPages = 0;
-  for (size_t i = 0; i < m_descriptors.size(); ++i) {
-    std::shared_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[i].m_contentLock);
-    if (m_descriptors[i].m_inUse) {
-      ++numAllocatedPages;
+  assert(pId <= m_storage.size() && "Page not allocated");
+  assert(!isProtected(pId) && "Unable to access protected page");
+
+  // Hits take no partition lock, as in pin
+  ErrorCode err = ErrorCode::E_NO_ERROR;
+  uint32_t part = pId % m_config.m_numberOfPartitions;
+  bufferId_t bId;
+  if (!(m_partitions[part].m_bufferToPageMap.find(pId, &bId) && referenceBuffer(bId, pId, true))) {
+    std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);
+    waitForWriteBack(pId, &partitionGuard);
+    if (m_partitions[part].m_bufferToPageMap.find(pId, &bId)) {
+      bool referenced = referenceBuffer(bId, pId, true);
+      assert(referenced && "Page mapped to another buffer");
+      (void) referenced;
+    }
+    else {
+      pageId_t victim;
+      if ((err = getEmptySlot(&bId, part, &victim)) != ErrorCode::E_NO_ERROR) {
+        return err;
+      }
+      if (victim != INVALID_PAGE_ID) {
+        m_partitions[part].m_pendingWriteBacks.insert(victim);
+      }
+      beginLoad(bId, pId, true);
+      m_partitions[part].m_bufferToPageMap.insert(pId, bId);
+      partitionGuard.unlock();
+
+      // The load stays on the stack of the task until both of its requests
+      // are reaped, so its address tags them, and the write-back of a dirty
+      // victim is linked to the read as in pinBatch. Devices may report the
+      // write-back after the read.
+      uint32_t numRequests = (victim != INVALID_PAGE_ID) ? 2 : 1;
+      AsyncLoad load{Load{bId, pId, victim, 1, true}, numRequests};
+      uint64_t tag = reinterpret_cast<uint64_t>(&load);
+      while (engine->inFlight() + numRequests > engine->queueDepth()) {
+        yield();
+        reapAsyncLoads(engine);
+      }
+      if (victim != INVALID_PAGE_ID) {
+        m_storage.writeAsync(engine, m_buffers[bId], victim, tag | 1, true);
+      }
+      m_storage.readAsync(engine, m_buffers[bId], pId, tag);
+      engine->submit();
+
+      // Other tasks of the thread run while the page is read, and any of
+      // them may complete the load
+      reapAsyncLoads(engine);
+      while (load.m_numPending > 0) {
+        yield();
+        reapAsyncLoads(engine);
+      }
     }
   }
 
-  stats->m_numAllocatedPages = numAllocatedPages;
-  stats->m_numReservedPages = m_storage.size();
-  stats->m_pageSize = m_storage.getPageSize();
+  // The page may still be being read by another pin
+  err = waitForLoad(bId);
 
-  return ErrorCode::E_NO_ERROR;
+  if(bufferHandler != nullptr) {
+    bufferHandler->m_buffer = m_buffers[bId];
+    bufferHandler->m_pId 	= pId;
+    bufferHandler->m_bId 	= bId;
+  }
+  return err;
 }
 
-ErrorCode BufferPool::checkConsistency() noexcept {
+ErrorCode BufferPool::unpin( const BufferHandler& handler ) noexcept {
   assert(m_opened && "BufferPool is not opened");
-  // Before continuing we need to make sure that no operations are being performed
-  std::vector<std::unique_lock<std::mutex>> partitionGuards;
-  for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
-    partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
-  }
-
-  for (size_t i = 0; i < m_allocationTable.size(); ++i) {
-    // Take the lock of the partition
-    uint32_t part = i % m_config.m_numberOfPartitions;
-    auto itFreePages = std::find(m_partitions[part].m_freePages.begin(), m_partitions[part].m_freePages.end(), i);
-    auto itBuffer = m_partitions[part].m_bufferToPageMap.find(reinterpret_cast<pageId_t>(i));
-
-    if (m_allocationTable.test(i)) {
-      if (!isProtected(i) && itFreePages != m_partitions[part].m_freePages.end()) {
-        return ErrorCode::E_BUFPOOL_ALLOCATED_PAGE_IN_FREELIST;
-      }
-      else if (isProtected(i) && itFreePages != m_partitions[part].m_freePages.end()) {
-        return ErrorCode::E_BUFPOOL_PROTECTED_PAGE_IN_FREELIST;
-      }
+  assert(handler.m_pId <= m_storage.size() && "Page not allocated");
+  assert(!isProtected(handler.m_pId) && "Unable to access protected page");
 
-      if (itBuffer != m_partitions[part].m_bufferToPageMap.end()) {
-        std::shared_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[itBuffer->second].m_contentLock);
-        if (!m_descriptors[itBuffer->second].m_inUse || !(m_descriptors[itBuffer->second].m_pageId == i)) {
-          return ErrorCode::E_BUFPOOL_BUFFER_DESCRIPTOR_INCORRECT_DATA;
-        }
-      }
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  
+  // Decrement page's reference count, once the header is not locked, as
+  // its holder publishes the whole state when it releases it.
+  BufferDescriptor& descriptor = p_descriptors[handler.m_bId];
+  uint64_t state = descriptor.m_state.load(std::memory_order_relaxed);
+  while (true) {
+    if (state & BUF_LOCKED) {
+      yieldWhileWaiting();
+      state = descriptor.m_state.load(std::memory_order_relaxed);
+      continue;
     }
-    else {
-      if (!isProtected(i) && itFreePages == m_partitions[part].m_freePages.end()) {
-        return ErrorCode::E_BUFPOOL_FREE_PAGE_NOT_IN_FREELIST;
-      }
-
-      if (itBuffer != m_partitions[part].m_bufferToPageMap.end()) {
-        return ErrorCode::E_BUFPOOL_FREE_PAGE_MAPPED_TO_BUFFER;
-      }
+    assert((state & BUF_REFCOUNT_MASK) > 0 && "Buffer not pinned");
+    if (descriptor.m_state.compare_exchange_weak(state, state - BUF_REFCOUNT_ONE, std::memory_order_release)) {
+      break;
     }
   }
+
   return ErrorCode::E_NO_ERROR;
 }
 
-ErrorCode BufferPool::getEmptySlot( bufferId_t* bId, uint32_t partition ) noexcept {
+ErrorCode BufferPool::pinSwip( Swip* swip, 
+                               BufferHandler* bufferHandler ) noexcept {
   assert(m_opened && "BufferPool is not opened");
-  bool found = false;
 
-  // Look for an empty Buffer Pool slot.
-  if (!m_partitions[partition].m_freeBuffers.empty()) {
-    found = true;
-    *bId = m_partitions[partition].m_freeBuffers.front();
-    m_partitions[partition].m_freeBuffers.pop();
-    std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[*bId].m_contentLock);
-    m_descriptors[*bId].m_inUse = true;
+  if (m_config.m_readOnlyMapping) {
+    return pin(swip->m_pId, bufferHandler);
   }
 
-  bool existUnpinnedPage = false;
-  uint64_t start = m_nextCSVictim;
+  // The buffer of a swizzled Swip may be left by its page right before it
+  // is referenced, so the reference still checks the page
+  bufferId_t bId = swip->m_bId.load(std::memory_order_acquire);
+  if (bId != INVALID_BUFFER_ID && referenceBuffer(bId, swip->m_pId, true)) {
+    bufferHandler->m_buffer = m_buffers[bId];
+    bufferHandler->m_pId    = swip->m_pId;
+    bufferHandler->m_bId    = bId;
+    return waitForLoad(bId);
+  }
 
-  // If there is no empty slot, use Clock Sweep algorithm to find a victim.
-  while (!found) {
-    // Check only buffers relative to our partition
-    if ((m_nextCSVictim % m_config.m_numberOfPartitions) == partition) {
-      // Check only unpinned pages
-      std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[m_nextCSVictim].m_contentLock);
-      if (m_descriptors[m_nextCSVictim].m_referenceCount == 0)
-      {
-        existUnpinnedPage = true;
+  ErrorCode err = pin(swip->m_pId, bufferHandler);
+  if (err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
 
-        if ( m_descriptors[m_nextCSVictim].m_usageCount == 0 ) {
-          *bId = m_nextCSVictim;
+  // The pinned page cannot leave its buffer meanwhile, and whenever it
+  // does, the Swip is unswizzled
+  bId = bufferHandler->m_bId;
+  uint64_t state = p_descriptors[bId].lockHeader();
+  if (p_descriptors[bId].p_swip == nullptr) {
+    p_descriptors[bId].p_swip = swip;
+    swip->m_bId.store(bId, std::memory_order_release);
+  }
+  p_descriptors[bId].unlockHeader(state);
+  return ErrorCode::E_NO_ERROR;
+}
+
+void BufferPool::unswizzle( Swip* swip ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+  bufferId_t bId = swip->m_bId.load(std::memory_order_acquire);
+  if (bId == INVALID_BUFFER_ID) {
+    return;
+  }
+  uint64_t state = p_descriptors[bId].lockHeader();
+  if (p_descriptors[bId].p_swip == swip) {
+    p_descriptors[bId].p_swip = nullptr;
+  }
+  swip->m_bId.store(INVALID_BUFFER_ID, std::memory_order_release);
+  p_descriptors[bId].unlockHeader(state);
+}
+
+ErrorCode BufferPool::beginOptimisticRead( const pageId_t& pId, 
+                                           OptimisticReadHandler* handler ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+  assert(pId <= m_storage.size() && "Page not allocated");
+  assert(!isProtected(pId) && "Unable to access protected page");
+
+  // Mapped pages never leave the mapping
+  if (m_config.m_readOnlyMapping) {
+    handler->m_buffer   = p_mapping + pId*m_storage.getPageSize();
+    handler->m_pId      = pId;
+    handler->m_bId      = 0;
+    handler->m_version  = 0;
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  uint32_t part = pId % m_config.m_numberOfPartitions;
+  while (true) {
+    // The version is read before the page of the buffer, which changes
+    // before the version does, so validation fails if the buffer is reused
+    // meanwhile. The state is read last, so a buffer being assigned to the
+    // page is seen locked or loading. Pages still being loaded or verified
+    // are read once the pin below is done with them.
+    bufferId_t bId;
+    if (m_partitions[part].m_bufferToPageMap.find(pId, &bId)) {
+      BufferDescriptor& descriptor = p_descriptors[bId];
+      uint64_t version = descriptor.m_version.load(std::memory_order_acquire);
+      pageId_t loaded = descriptor.m_pageId.load(std::memory_order_acquire);
+      uint64_t state = descriptor.m_state.load(std::memory_order_acquire);
+      uint64_t notReady = BUF_LOCKED | BUF_IO_IN_PROGRESS | BUF_CHECKSUM_PENDING | BUF_CORRUPTED;
+      if (loaded == pId && (state & (BUF_IN_USE | notReady)) == BUF_IN_USE) {
+        handler->m_buffer   = m_buffers[bId];
+        handler->m_pId      = pId;
+        handler->m_bId      = bId;
+        handler->m_version  = version;
+        return ErrorCode::E_NO_ERROR;
+      }
+    }
+
+    // Pages not ready to be read are brought in by a regular pin
+    BufferHandler pinned;
+    ErrorCode err = pin(pId, &pinned);
+    if (err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+    unpin(pinned);
+  }
+}
+
+bool BufferPool::validateOptimisticRead( const OptimisticReadHandler& handler ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+  if (m_config.m_readOnlyMapping) {
+    return true;
+  }
+  // Orders the reads of the page before the version is checked again
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return (handler.m_version & 1) == 0 &&
+         p_descriptors[handler.m_bId].m_version.load(std::memory_order_relaxed) == handler.m_version;
+}
+
+ErrorCode BufferPool::beginWrite( const BufferHandler& handler ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_BUFPOOL_READ_ONLY;
+  }
+
+  // An odd version latches the page for the writer. The fence orders the
+  // version before the writes to the page, as seen by optimistic reads.
+  std::atomic<uint64_t>& version = p_descriptors[handler.m_bId].m_version;
+  uint64_t current = version.load(std::memory_order_relaxed);
+  while (true) {
+    if (current & 1) {
+      yieldWhileWaiting();
+      current = version.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (version.compare_exchange_weak(current, current + 1, std::memory_order_acquire)) {
+      break;
+    }
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BufferPool::endWrite( const BufferHandler& handler ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_BUFPOOL_READ_ONLY;
+  }
+
+  BufferDescriptor& descriptor = p_descriptors[handler.m_bId];
+  assert((descriptor.m_version.load(std::memory_order_relaxed) & 1) && "Page not being written");
+  uint64_t state = descriptor.lockHeader();
+  descriptor.m_version.fetch_add(1, std::memory_order_release);
+  descriptor.unlockHeader(state | BUF_DIRTY);
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BufferPool::adviseAccess( AccessPattern pattern,
+                                    const pageId_t& firstPage,
+                                    uint64_t numPages ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+  assert(firstPage+numPages <= m_storage.size() && "Invalid page range");
+
+  if (numPages == 0) {
+    numPages = m_storage.size() - firstPage;
+  }
+
+  if (m_config.m_readOnlyMapping) {
+    return m_storage.adviseMapping(pattern, firstPage, numPages);
+  }
+  // Pages are read into buffers through the kernel cache, whose read-ahead
+  // follows the hint
+  return m_storage.adviseFile(pattern, firstPage, numPages);
+}
+
+ErrorCode BufferPool::checkpoint() noexcept {
+  assert(m_opened && "BufferPool is not opened");
+
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  // Before continuing we need to make sure that no operations are being performed
+  std::vector<std::unique_lock<std::mutex>> partitionGuards;
+  for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
+    partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
+  }
+  waitForWriteBacks(&partitionGuards);
+
+  // Flush dirty buffers
+  lsn_t lsn = m_wal.isOpened() ? m_wal.getNextLSN() : 0;
+  ErrorCode err = flushDirtyBuffers();
+  // Save m_allocationTable state to disk.
+  ErrorCode tableErr = storeAllocationTable();
+
+  // The updates logged so far are in the storage now
+  if (m_wal.isOpened() && err == ErrorCode::E_NO_ERROR) {
+    err = truncateLog(lsn);
+    if (err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+  }
+
+  // Released pages are discarded once the table freeing them is stored
+  if (tableErr != ErrorCode::E_NO_ERROR) {
+    return tableErr;
+  }
+  return discardReleasedPages();
+}
+
+ErrorCode BufferPool::compact( std::vector<std::pair<pageId_t, pageId_t>>* relocations ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+  relocations->clear();
+
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_BUFPOOL_READ_ONLY;
+  }
+
+  // Before continuing we need to make sure that no operations are being performed
+  std::vector<std::unique_lock<std::mutex>> partitionGuards;
+  for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
+    partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
+  }
+  waitForWriteBacks(&partitionGuards);
+
+  // Pages are moved with their latest contents, and the log is truncated so
+  // that no update is redone on the old pageId_t of a moved page
+  lsn_t lsn = m_wal.isOpened() ? m_wal.getNextLSN() : 0;
+  ErrorCode err = flushDirtyBuffers();
+  if (err == ErrorCode::E_NO_ERROR) {
+    err = storeAllocationTable();
+  }
+  if (err == ErrorCode::E_NO_ERROR && m_wal.isOpened()) {
+    err = truncateLog(lsn);
+  }
+  if (err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+
+  // The allocated pages at the end are moved to the free pages at the
+  // beginning, until both meet. The moved pages are only copied, so until
+  // the new allocation table is stored, the old one is still valid.
+  std::vector<char> buffer(m_storage.getPageSize());
+  pageId_t first = 0;
+  pageId_t last = m_allocationTable.size();
+  while (true) {
+    while (first < last && (m_allocationTable.test(first) || isProtected(first))) {
+      ++first;
+    }
+    while (last > first && (!m_allocationTable.test(last-1) || isProtected(last-1))) {
+      --last;
+    }
+    if (first >= last) {
+      break;
+    }
+
+    bool moved;
+    if ((err = movePage(last-1, first, buffer.data(), &moved)) != ErrorCode::E_NO_ERROR) {
+      break;
+    }
+    if (moved) {
+      relocations->push_back(std::make_pair(last-1, first));
+      m_allocationTable.set(first);
+      m_allocationTable.set(last-1, 0);
+      if (m_config.m_punchHoles) {
+        m_partitions[(last-1) % m_config.m_numberOfPartitions].m_releasedPages.push_back(last-1);
+      }
+    }
+    --last;
+  }
+
+  // The free pages at the end are truncated once the allocation table
+  // without them is durable. The pages holding the table are never set in
+  // it, so the truncation stops at the last of them it still needs.
+  pageId_t numPages = m_allocationTable.size();
+  while (numPages > 0 && !m_allocationTable.test(numPages-1) && !isProtected(numPages-1)) {
+    --numPages;
+  }
+  m_allocationTable.resize(numPages);
+  for (uint32_t p = 0; p < m_config.m_numberOfPartitions; ++p) {
+    m_partitions[p].m_freePages.clear();
+  }
+  for (size_t i = 0; i < m_allocationTable.size(); ++i) {
+    if (!m_allocationTable.test(i) && !isProtected(i)) {
+      m_partitions[i % m_config.m_numberOfPartitions].m_freePages.push_back(i);
+    }
+  }
+
+  ErrorCode syncErr = m_storage.sync();
+  if (syncErr == ErrorCode::E_NO_ERROR) {
+    syncErr = storeAllocationTable();
+  }
+  if (syncErr == ErrorCode::E_NO_ERROR) {
+    syncErr = m_storage.sync();
+  }
+  if (syncErr == ErrorCode::E_NO_ERROR) {
+    syncErr = m_storage.truncate(numPages);
+  }
+  if (syncErr == ErrorCode::E_NO_ERROR) {
+    syncErr = discardReleasedPages();
+  }
+  return err != ErrorCode::E_NO_ERROR ? err : syncErr;
+}
+
+ErrorCode BufferPool::setPageDirty( const pageId_t& pId ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_BUFPOOL_READ_ONLY;
+  }
+
+  // The page is pinned, so its buffer holds it, but a lookup without the
+  // partition lock may still miss it while the table is updated, in which
+  // case the page is looked up again under the lock
+  uint32_t part = pId % m_config.m_numberOfPartitions;
+  bufferId_t bId;
+  uint64_t state;
+  bool locked = false;
+  if (m_partitions[part].m_bufferToPageMap.find(pId, &bId)) {
+    state = p_descriptors[bId].lockHeader();
+    locked = true;
+    if (p_descriptors[bId].m_pageId != pId) {
+      p_descriptors[bId].unlockHeader(state);
+      locked = false;
+    }
+  }
+  if (!locked) {
+    std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);
+    bool found = m_partitions[part].m_bufferToPageMap.find(pId, &bId);
+    assert(found && "Page not present");
+    (void) found;
+    partitionGuard.unlock();
+    state = p_descriptors[bId].lockHeader();
+  }
+  // Optimistic reads validated from now on are retried
+  p_descriptors[bId].m_version.fetch_add(2, std::memory_order_acq_rel);
+  p_descriptors[bId].unlockHeader(state | BUF_DIRTY);
+
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BufferPool::logUpdate( const BufferHandler& handler,
+                                 uint32_t offset,
+                                 uint32_t size,
+                                 lsn_t* lsn ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+  assert(offset + size <= m_storage.getPageSize() && "Update out of the page");
+
+  if (!m_wal.isOpened()) {
+    return ErrorCode::E_BUFPOOL_NO_WRITE_AHEAD_LOG;
+  }
+
+  // The page is set as dirty before its record is appended, so that a
+  // concurrent checkpoint either writes the page back or keeps the record.
+  // The header lock is released before the append, which may write the
+  // log, so pins and unpins of the page do not wait for it.
+  bufferId_t bId = handler.m_bId;
+  uint64_t state = p_descriptors[bId].lockHeader();
+  p_descriptors[bId].m_version.fetch_add(2, std::memory_order_acq_rel);
+  p_descriptors[bId].unlockHeader(state | BUF_DIRTY);
+
+  ErrorCode err = m_wal.append(WALRecordType::E_PAGE_UPDATE, handler.m_pId, offset, handler.m_buffer + offset, size, lsn);
+  if (err == ErrorCode::E_NO_ERROR) {
+    // Updates of the page appended concurrently may publish theirs first
+    lsn_t pageLSN = p_descriptors[bId].m_pageLSN.load(std::memory_order_relaxed);
+    while (pageLSN < *lsn && 
+           !p_descriptors[bId].m_pageLSN.compare_exchange_weak(pageLSN, *lsn, std::memory_order_release)) {
+    }
+  }
+
+  return err;
+}
+
+ErrorCode BufferPool::commit( const lsn_t& lsn ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+
+  if (!m_wal.isOpened()) {
+    return ErrorCode::E_BUFPOOL_NO_WRITE_AHEAD_LOG;
+  }
+
+  return m_wal.flush(lsn);
+}
+
+ErrorCode BufferPool::getStatistics( BufferPoolStatistics* stats ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+
+  // Every page of the storage is accessible through the mapping
+  if (m_config.m_readOnlyMapping) {
+    stats->m_numAllocatedPages = m_storage.size();
+    stats->m_numReservedPages = m_storage.size();
+    stats->m_pageSize = m_storage.getPageSize();
+    stats->m_numPrefetchedPages = 0;
+    stats->m_numPendingWriteBacks = 0;
+    m_storage.getIOStatistics(&stats->m_io);
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  // Before continuing we need to make sure that no operations are being performed
+  std::vector<std::unique_lock<std::mutex>> partitionGuards;
+  for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
+    partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
+  }
+
+  size_t numAllocatedPages = 0;
+  for (size_t i = 0; i < m_buffers.size(); ++i) {
+    if (p_descriptors[i].m_state.load(std::memory_order_acquire) & BUF_IN_USE) {
+      ++numAllocatedPages;
+    }
+  }
+  size_t numPendingWriteBacks = 0;
+  for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
+    numPendingWriteBacks += m_partitions[i].m_pendingWriteBacks.size();
+  }
+
+  stats->m_numAllocatedPages = numAllocatedPages;
+  stats->m_numReservedPages = m_storage.size();
+  stats->m_pageSize = m_storage.getPageSize();
+  stats->m_numPrefetchedPages = m_prefetcher.getNumRequested();
+  stats->m_numPendingWriteBacks = numPendingWriteBacks;
+  m_storage.getIOStatistics(&stats->m_io);
+
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BufferPool::checkConsistency() noexcept {
+  assert(m_opened && "BufferPool is not opened");
+
+  if (m_config.m_readOnlyMapping) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  // Before continuing we need to make sure that no operations are being performed
+  std::vector<std::unique_lock<std::mutex>> partitionGuards;
+  for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
+    partitionGuards.push_back( std::unique_lock<std::mutex>(*m_partitions[i].p_lock) );
+  }
+
+  for (size_t i = 0; i < m_allocationTable.size(); ++i) {
+    // Take the lock of the partition
+    uint32_t part = i % m_config.m_numberOfPartitions;
+    auto itFreePages = std::find(m_partitions[part].m_freePages.begin(), m_partitions[part].m_freePages.end(), i);
+    bufferId_t bId;
+    bool loaded = m_partitions[part].m_bufferToPageMap.find(i, &bId);
+
+    if (m_allocationTable.test(i)) {
+      if (!isProtected(i) && itFreePages != m_partitions[part].m_freePages.end()) {
+        return ErrorCode::E_BUFPOOL_ALLOCATED_PAGE_IN_FREELIST;
+      }
+      else if (isProtected(i) && itFreePages != m_partitions[part].m_freePages.end()) {
+        return ErrorCode::E_BUFPOOL_PROTECTED_PAGE_IN_FREELIST;
+      }
+
+      if (loaded) {
+        uint64_t state = p_descriptors[bId].m_state.load(std::memory_order_acquire);
+        if (!(state & BUF_IN_USE) || !(p_descriptors[bId].m_pageId == i)) {
+          return ErrorCode::E_BUFPOOL_BUFFER_DESCRIPTOR_INCORRECT_DATA;
+        }
+      }
+    }
+    else {
+      if (!isProtected(i) && itFreePages == m_partitions[part].m_freePages.end()) {
+        return ErrorCode::E_BUFPOOL_FREE_PAGE_NOT_IN_FREELIST;
+      }
+
+      if (loaded) {
+        return ErrorCode::E_BUFPOOL_FREE_PAGE_MAPPED_TO_BUFFER;
+      }
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BufferPool::getEmptySlot( bufferId_t* bId, 
+                                     uint32_t partition,
+                                     pageId_t* dirtyVictim ) noexcept {
+  assert(m_opened && "BufferPool is not opened");
+  bool found = false;
+
+  if (dirtyVictim != nullptr) {
+    *dirtyVictim = INVALID_PAGE_ID;
+  }
+
+  // Look for an empty Buffer Pool slot.
+  if (!m_partitions[partition].m_freeBuffers.empty()) {
+    found = true;
+    *bId = m_partitions[partition].m_freeBuffers.front();
+    m_partitions[partition].m_freeBuffers.pop();
+    p_descriptors[*bId].lockHeader();
+    p_descriptors[*bId].unlockHeader(BUF_IN_USE);
+  }
+
+  // Partitions own the buffers whose id is congruent to theirs, so the hand
+  // steps over the buffers of the others. Pools smaller than the number of
+  // partitions leave some of them without buffers.
+  Partition& part = m_partitions[partition];
+  if (!found && part.m_nextCSVictim >= m_buffers.size()) {
+    return ErrorCode::E_BUFPOOL_OUT_OF_MEMORY;
+  }
+  bool existUnpinnedPage = false;
+  bufferId_t start = part.m_nextCSVictim;
+
+  // If there is no empty slot, use Clock Sweep algorithm to find a victim.
+  while (!found) {
+    bufferId_t candidate = part.m_nextCSVictim;
+    BufferDescriptor& descriptor = p_descriptors[candidate];
+
+    // Check only unpinned pages. Descriptors locked by another thread are
+    // being updated, so they are skipped as if they were pinned
+    uint64_t state;
+    if (descriptor.tryLockHeader(&state)) {
+      if (!(state & BUF_IO_IN_PROGRESS) && (state & BUF_REFCOUNT_MASK) == 0) {
+        existUnpinnedPage = true;
+
+        if ( (state & BUF_USAGECOUNT_MASK) == 0 ) {
+          *bId = candidate;
           found = true;
 
-          // If the buffer is dirty we must store it to disk.
-          if( m_descriptors[*bId].m_dirty ) {
-            m_storage.write(m_descriptors[*bId].p_buffer, m_descriptors[*bId].m_pageId);
+          // If the buffer is dirty we must store it to disk, unless the
+          // caller takes care of it.
+          if( state & BUF_DIRTY ) {
+            state &= ~BUF_DIRTY;
+            flushLog(*bId);
+            if (dirtyVictim != nullptr) {
+              *dirtyVictim = descriptor.m_pageId;
+            }
+            else {
+              m_storage.write(m_buffers[candidate], descriptor.m_pageId);
+            }
           }
 
-          // Delete page entry from buffer table.
-          m_partitions[partition].m_bufferToPageMap.erase(m_descriptors[*bId].m_pageId);
+          // Delete page entry from buffer table. Pins that found the
+          // buffer without the partition lock see it no longer holds the
+          // page. The version changes after the page does, so that
+          // optimistic reads either see the new page or fail.
+          part.m_bufferToPageMap.erase(descriptor.m_pageId);
+          descriptor.m_pageId = INVALID_PAGE_ID;
+          descriptor.m_version.fetch_add(2, std::memory_order_acq_rel);
+          unswizzleBuffer(candidate);
         }
         else {
-          --m_descriptors[m_nextCSVictim].m_usageCount;
-        }	
+          state -= BUF_USAGECOUNT_ONE;
+        }
       }
+      descriptor.unlockHeader(state);
     }
 
-    // Advance victim pointer.
-    m_nextCSVictim = (m_nextCSVictim+1) % m_descriptors.size();
+    // Advance victim pointer to the next buffer of the partition.
+    part.m_nextCSVictim += m_config.m_numberOfPartitions;
+    if (part.m_nextCSVictim >= m_buffers.size()) {
+      part.m_nextCSVictim = partition;
+    }
 
     // Stop Clock Sweep in case there are no unpinned pages.
-    if (!existUnpinnedPage && m_nextCSVictim == start) {
+    if (!existUnpinnedPage && part.m_nextCSVictim == start) {
       break;
     }
   }
@@ -519,42 +1416,49 @@ ErrorCode BufferPool::getEmptySlot( bufferId_t* bId, uint32_t partition ) noexce
 
 bool BufferPool::getFreePage(pageId_t* pId) noexcept {
   assert(m_opened && "BufferPool is not opened");
-  bool found = false;
-  for (uint32_t p = 0; p < m_config.m_numberOfPartitions && !found; ++p) {
-    if ( !m_partitions[p].m_freePages.empty() ) {
-      found = true;
-      *pId = m_partitions[p].m_freePages.front();
-      m_partitions[p].m_freePages.pop_front();
+  uint32_t found = m_config.m_numberOfPartitions;
+  for (uint32_t p = 0; p < m_config.m_numberOfPartitions; ++p) {
+    if ( !m_partitions[p].m_freePages.empty() && 
+         (found == m_config.m_numberOfPartitions || 
+          m_partitions[p].m_freePages.front() < m_partitions[found].m_freePages.front()) ) {
+      found = p;
     }
   }
-  return found;
+  if (found == m_config.m_numberOfPartitions) {
+    return false;
+  }
+  *pId = m_partitions[found].m_freePages.front();
+  m_partitions[found].m_freePages.pop_front();
+  return true;
+}
+
+uint32_t BufferPool::getGrowthPages() noexcept {
+  assert(m_opened && "BufferPool is not opened");
+  uint64_t numPages = std::max<uint32_t>(m_config.m_growthPages, 1);
+  if (m_config.m_growthPolicy == GrowthPolicy::E_GEOMETRIC) {
+    uint64_t maxPages = std::max<uint64_t>(m_config.m_maxGrowthKB*1024 / m_storage.getPageSize(), 1);
+    numPages = std::max<uint64_t>(numPages, std::min<uint64_t>(m_storage.size(), maxPages));
+  }
+  return numPages;
 }
 
 ErrorCode BufferPool::reservePages( const uint32_t& numPages, pageId_t* pId ) noexcept {
   assert(m_opened && "BufferPool is not opened");
   // Reserve space in disk.
-  m_storage.reserve(numPages, pId);
+  ErrorCode err = m_storage.reserve(numPages, pId);
+  if (err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
 
-  // Add reserved pages to free list and increment the Allocation Table size to fit the new pages.
+  // Add reserved pages to free list and increment the Allocation Table size
+  // to fit the new pages. Protected pages are never handed out.
+  m_allocationTable.resize(m_allocationTable.size() + numPages, false);
   for (size_t i = 0; i < numPages; ++i) {
     size_t page = (*pId)+i;
     uint32_t part = page % m_config.m_numberOfPartitions;
     if (!isProtected(page)) {
       m_partitions[part].m_freePages.push_back(page);	
     } 
-    m_allocationTable.push_back(0);
-  }
-
-  // If the first reserved page is protected, an extra page must be reserved.
-  if (isProtected(*pId)) {
-    pageId_t pIdToReturn = (*pId) + 1;
-
-    m_storage.reserve(1, pId);
-    uint32_t part = *pId % m_config.m_numberOfPartitions;
-    m_partitions[part].m_freePages.push_back(*pId);
-    m_allocationTable.push_back(0);
-
-    *pId = pIdToReturn;
   }
 
   return ErrorCode::E_NO_ERROR;
@@ -583,7 +1487,7 @@ ErrorCode BufferPool::loadAllocationTable() noexcept {
   for (size_t i = 0; i < m_allocationTable.size(); ++i) {
     if (!m_allocationTable.test(i) && !isProtected(i)) {
       uint32_t part = i % m_config.m_numberOfPartitions;
-      m_partitions[i].m_freePages.push_back(i);
+      m_partitions[part].m_freePages.push_back(i);
     }
   }
 
@@ -600,10 +1504,117 @@ ErrorCode BufferPool::storeAllocationTable() noexcept {
   std::vector<boost::dynamic_bitset<>::block_type> v(vectorSize);
   to_block_range(m_allocationTable, v.begin());
 
+  std::vector<pageId_t> pageIds;
+  std::vector<const char*> data;
   for (size_t i = 0; i < m_allocationTable.size(); i += bitsPerPage) {
-    m_storage.write(reinterpret_cast<char*>(&v[i/blockSize]), i);
+    pageIds.push_back(i);
+    data.push_back(reinterpret_cast<char*>(&v[i/blockSize]));
   }
 
+  ErrorCode err = stagePages(pageIds.data(), data.data(), pageIds.size());
+  if (err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  for (size_t i = 0; i < pageIds.size(); ++i) {
+    if ((err = m_storage.write(data[i], pageIds[i])) != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+  }
+
+  return unstagePages();
+}
+
+ErrorCode BufferPool::discardReleasedPages() noexcept {
+  std::vector<pageId_t> pages;
+  for (uint32_t p = 0; p < m_config.m_numberOfPartitions; ++p) {
+    for (pageId_t pId : m_partitions[p].m_releasedPages) {
+      // Pages allocated again, or truncated by compact, are skipped
+      if (pId < m_allocationTable.size() && !m_allocationTable.test(pId)) {
+        pages.push_back(pId);
+      }
+    }
+    m_partitions[p].m_releasedPages.clear();
+  }
+  if (pages.empty()) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  // The contents of the pages are lost, so they must be free in the stored
+  // allocation table after a crash
+  ErrorCode err = m_storage.sync();
+  if (err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+
+  // Runs of contiguous pages are discarded at once
+  std::sort(pages.begin(), pages.end());
+  pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+  size_t begin = 0;
+  while (begin < pages.size()) {
+    size_t end = begin + 1;
+    while (end < pages.size() && pages[end] == pages[end-1] + 1) {
+      ++end;
+    }
+    if ((err = m_storage.discard(pages[begin], end - begin)) != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+    begin = end;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BufferPool::movePage( const pageId_t& from,
+                                const pageId_t& to,
+                                char* buffer,
+                                bool* moved ) noexcept {
+  *moved = false;
+  uint32_t part = from % m_config.m_numberOfPartitions;
+  assert(m_partitions[part].m_pendingWriteBacks.count(from) == 0 && "Moving a page being written back");
+  assert(m_partitions[to % m_config.m_numberOfPartitions].m_pendingWriteBacks.count(to) == 0 && 
+         "Moving a page over one being written back");
+
+  bufferId_t bId;
+  if (!m_partitions[part].m_bufferToPageMap.find(from, &bId)) {
+    ErrorCode err = m_storage.read(buffer, from);
+    if (err == ErrorCode::E_NO_ERROR) {
+      err = m_storage.write(buffer, to);
+    }
+    *moved = err == ErrorCode::E_NO_ERROR;
+    return err;
+  }
+
+  // Loaded pages are copied from their buffers, which were just flushed,
+  // and evicted, unless they are in use. Pages not verified yet are copied
+  // from the storage instead, which verifies them.
+  uint64_t state;
+  if (!p_descriptors[bId].tryLockHeader(&state)) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  if ((state & BUF_REFCOUNT_MASK) > 0 ||
+      (state & (BUF_IO_IN_PROGRESS | BUF_CORRUPTED))) {
+    p_descriptors[bId].unlockHeader(state);
+    return ErrorCode::E_NO_ERROR;
+  }
+  const char* data = m_buffers[bId];
+  ErrorCode err = ErrorCode::E_NO_ERROR;
+  if (state & BUF_CHECKSUM_PENDING) {
+    err = m_storage.read(buffer, from);
+    data = buffer;
+  }
+  if (err == ErrorCode::E_NO_ERROR) {
+    err = m_storage.write(data, to);
+  }
+  if (err != ErrorCode::E_NO_ERROR) {
+    p_descriptors[bId].unlockHeader(state);
+    return err;
+  }
+  m_partitions[part].m_bufferToPageMap.erase(from);
+  m_partitions[part].m_freeBuffers.push(bId);
+  p_descriptors[bId].m_pageId = 0;
+  p_descriptors[bId].m_version.fetch_add(2, std::memory_order_acq_rel);
+  unswizzleBuffer(bId);
+  p_descriptors[bId].unlockHeader(0);
+  *moved = true;
   return ErrorCode::E_NO_ERROR;
 }
 
@@ -621,16 +1632,482 @@ bool BufferPool::isProtected( const pageId_t& pId ) noexcept {
 ErrorCode BufferPool::flushDirtyBuffers() noexcept {
   assert(m_opened && "BufferPool is not opened");
 
-  // Look for dirty Buffer Pool slots and flush them to disk.
-  for (int bId = 0; bId < m_descriptors.size(); ++bId) {
-    std::unique_lock<std::shared_timed_mutex> contentGuard(*m_descriptors[bId].m_contentLock);
-    if (m_descriptors[bId].m_inUse && m_descriptors[bId].m_dirty) {
-      m_storage.write(m_descriptors[bId].p_buffer, m_descriptors[bId].m_pageId);
-      m_descriptors[bId].m_dirty = 0;
+  // Collect the dirty Buffer Pool slots. Buffers are marked as clean before
+  // they are written, so modifications made during the write mark them as
+  // dirty again.
+  std::vector<std::pair<pageId_t, bufferId_t>> dirty;
+  lsn_t maxLSN = 0;
+  for (bufferId_t bId = 0; bId < m_buffers.size(); ++bId) {
+    uint64_t state = p_descriptors[bId].lockHeader();
+    if ((state & (BUF_IN_USE | BUF_DIRTY | BUF_IO_IN_PROGRESS)) == (BUF_IN_USE | BUF_DIRTY)) {
+      state &= ~BUF_DIRTY;
+      maxLSN = std::max(maxLSN, p_descriptors[bId].m_pageLSN.load(std::memory_order_acquire));
+      dirty.push_back(std::make_pair(p_descriptors[bId].m_pageId.load(), bId));
     }
+    p_descriptors[bId].unlockHeader(state);
   }
 
-  return ErrorCode::E_NO_ERROR;
+  ErrorCode err = ErrorCode::E_NO_ERROR;
+
+  // The log records of all the pages are made durable before any of them
+  // is written, with a single flush. Records still being appended are not
+  // covered, but they follow the LSN checkpoints truncate the log at, so
+  // they are redone after a crash.
+  if (m_wal.isOpened() && maxLSN > 0 && 
+      (err = m_wal.flush(maxLSN)) != ErrorCode::E_NO_ERROR) {
+    for (auto& page : dirty) {
+      completeFlush(page.second, err, &err);
+    }
+    return err;
+  }
+
+  // Staged pages are written in batches that fit in the double-write
+  // buffer, as every batch overwrites the previous one
+  std::sort(dirty.begin(), dirty.end());
+  uint32_t batchPages = dirty.size();
+  if (m_dwb.isOpened()) {
+    batchPages = std::max<uint32_t>(1, static_cast<uint64_t>(m_config.m_doubleWriteKB)*1024 / m_storage.getPageSize());
+  }
+  std::vector<pageId_t> pageIds(std::min<size_t>(batchPages, dirty.size()));
+  std::vector<const char*> data(pageIds.size());
+  for (uint32_t first = 0; first < dirty.size(); first += batchPages) {
+    uint32_t numPages = std::min<uint32_t>(batchPages, dirty.size() - first);
+    for (uint32_t i = 0; i < numPages; ++i) {
+      pageIds[i] = dirty[first+i].first;
+      data[i] = m_buffers[dirty[first+i].second];
+    }
+
+    // Buffers whose write fails are already left dirty
+    ErrorCode result = stagePages(pageIds.data(), data.data(), numPages);
+    if (result == ErrorCode::E_NO_ERROR) {
+      if ((result = writeDirtyBuffers(&dirty[first], numPages)) != ErrorCode::E_NO_ERROR) {
+        err = result;
+        continue;
+      }
+      result = unstagePages();
+    }
+    if (result != ErrorCode::E_NO_ERROR) {
+      for (uint32_t i = first; i < first + numPages; ++i) {
+        completeFlush(dirty[i].second, result, &err);
+      }
+    }
+  }
+
+  return err;
+}
+
+ErrorCode BufferPool::writeDirtyBuffers( const std::pair<pageId_t, bufferId_t>* dirty,
+                                         uint32_t numPages ) noexcept {
+  ErrorCode err = ErrorCode::E_NO_ERROR;
+
+  // Runs of contiguous pages are written with a single vectored write of up
+  // to m_ioRangeKB. Runs end at stripe boundaries, so that the writes to
+  // different stripes are in flight at the same time.
+  uint32_t maxRunPages = std::max<uint32_t>(1, m_config.m_ioRangeKB*1024 / m_storage.getPageSize());
+  std::vector<std::pair<uint32_t, uint32_t>> runs;
+  for (uint32_t i = 0; i < numPages; ++i) {
+    if (!runs.empty() && 
+        runs.back().second < maxRunPages &&
+        runs.back().second < m_storage.getContiguousPages(dirty[runs.back().first].first) &&
+        dirty[i].first == dirty[i-1].first + 1) {
+      ++runs.back().second;
+    }
+    else {
+      runs.push_back(std::make_pair(i, 1));
+    }
+  }
+
+  std::vector<struct iovec> iov(numPages);
+  for (uint32_t i = 0; i < numPages; ++i) {
+    iov[i].iov_base = m_buffers[dirty[i].second];
+    iov[i].iov_len = m_storage.getPageSize();
+  }
+
+  auto completeRun = [this, dirty, &runs, &err] (uint32_t run, ErrorCode result) {
+    for (uint32_t i = runs[run].first; i < runs[run].first + runs[run].second; ++i) {
+      completeFlush(dirty[i].second, result, &err);
+    }
+  };
+
+  IOEngine* engine = getIOEngine(m_config.m_ioQueueDepth);
+  if (engine == nullptr) {
+    std::vector<const char*> data(maxRunPages);
+    for (uint32_t run = 0; run < runs.size(); ++run) {
+      for (uint32_t i = 0; i < runs[run].second; ++i) {
+        data[i] = m_buffers[dirty[runs[run].first + i].second];
+      }
+      completeRun(run, m_storage.writeRange(dirty[runs[run].first].first, runs[run].second, data.data()));
+    }
+    return err;
+  }
+
+  // Up to the queue depth of the engine runs are kept in flight
+  std::vector<IOCompletion> completions(engine->queueDepth());
+  auto reap = [&] (uint32_t minCompletions) {
+    uint32_t reaped = engine->reap(completions.data(), completions.size(), minCompletions);
+    for (uint32_t c = 0; c < reaped; ++c) {
+      uint32_t run = completions[c].m_tag;
+      bool success = completions[c].m_result == static_cast<int64_t>(runs[run].second*m_storage.getPageSize());
+      completeRun(run, success ? ErrorCode::E_NO_ERROR : ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR);
+    }
+  };
+  for (uint32_t run = 0; run < runs.size(); ++run) {
+    while (engine->inFlight() == engine->queueDepth()) {
+      reap(1);
+    }
+    m_storage.writeRangeAsync(engine, &iov[runs[run].first], dirty[runs[run].first].first, runs[run].second, run);
+  }
+  engine->submit();
+  while (engine->inFlight() > 0) {
+    reap(1);
+  }
+
+  return err;
+}
+
+void BufferPool::completeFlush( bufferId_t bId,
+                                ErrorCode result,
+                                ErrorCode* err ) noexcept {
+  if (result != ErrorCode::E_NO_ERROR) {
+    // The buffer stays dirty so that a later flush retries it
+    uint64_t state = p_descriptors[bId].lockHeader();
+    p_descriptors[bId].unlockHeader(state | BUF_DIRTY);
+    *err = result;
+  }
+}
+
+ErrorCode BufferPool::redo( const WALRecord& record, 
+                           const char* data ) noexcept {
+  pageId_t pId = record.m_pageId;
+  if (pId == INVALID_PAGE_ID || 
+      isProtected(pId) || 
+      static_cast<uint64_t>(record.m_offset) + record.m_size > m_storage.getPageSize()) {
+    return ErrorCode::E_STORAGE_INVALID_LOG;
+  }
+
+  // Pages reserved after the last checkpoint
+  ErrorCode err = ErrorCode::E_NO_ERROR;
+  while (pId >= m_storage.size()) {
+    pageId_t first;
+    if ((err = reservePages(getGrowthPages(), &first)) != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+  }
+
+  if (record.m_type == WALRecordType::E_PAGE_RELEASE) {
+    return m_allocationTable.test(pId) ? release(pId) : ErrorCode::E_NO_ERROR;
+  }
+
+  // Pages allocated after the last checkpoint
+  if (!m_allocationTable.test(pId)) {
+    m_allocationTable.set(pId);
+    m_partitions[pId % m_config.m_numberOfPartitions].m_freePages.remove(pId);
+  }
+
+  // The page is loaded without a reference, as nothing else uses the pool
+  // while it is recovered, so it is not unpinned
+  BufferHandler handler;
+  if ((err = pin(pId, &handler, false)) != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  memcpy(handler.m_buffer + record.m_offset, data, record.m_size);
+  return setPageDirty(pId);
+}
+
+ErrorCode BufferPool::stagePages( const pageId_t* pageIds,
+                                  const char* const* data,
+                                  uint32_t numPages ) noexcept {
+  if (!m_dwb.isOpened()) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  return m_dwb.stage(pageIds, data, numPages);
+}
+
+ErrorCode BufferPool::unstagePages() noexcept {
+  if (!m_dwb.isOpened()) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  ErrorCode err = m_storage.sync();
+  if (err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  return m_dwb.clear();
+}
+
+ErrorCode BufferPool::restorePage( const pageId_t& pId,
+                                   const char* data ) noexcept {
+  // Pages reserved after the last checkpoint
+  if (pId >= m_storage.size()) {
+    pageId_t first;
+    ErrorCode err = m_storage.reserve(pId + 1 - m_storage.size(), &first);
+    if (err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+  }
+  return m_storage.write(data, pId);
+}
+
+void BufferPool::startWriteBack() noexcept {
+  if (m_config.m_writeBackIntervalMs > 0 && !m_config.m_readOnlyMapping) {
+    m_stopWriteBack = false;
+    m_writeBackThread = std::thread(&BufferPool::writeBackLoop, this);
+  }
+}
+
+void BufferPool::stopWriteBack() noexcept {
+  if (m_writeBackThread.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(m_writeBackLock);
+      m_stopWriteBack = true;
+    }
+    m_writeBackCondition.notify_all();
+    m_writeBackThread.join();
+  }
+}
+
+void BufferPool::writeBackLoop() noexcept {
+  std::chrono::milliseconds interval(m_config.m_writeBackIntervalMs);
+  std::unique_lock<std::mutex> guard(m_writeBackLock);
+  while (!m_writeBackCondition.wait_for(guard, interval, [this] () { return m_stopWriteBack; })) {
+    // Errors are not reported, as the pages are still written back by the
+    // next checkpoint
+    guard.unlock();
+    m_storage.writeBack();
+    guard.lock();
+  }
+}
+
+void BufferPool::startPrefetch() noexcept {
+  if (m_config.m_prefetchingDegree > 0) {
+    m_prefetcher.start(m_config.m_prefetchingDegree, m_config.m_maxPrefetchedPages, 
+                       [this] (const pageId_t* pIds, uint32_t numPages) {
+      prefetchPages(pIds, numPages);
+    });
+  }
+}
+
+void BufferPool::stopPrefetch() noexcept {
+  if (m_prefetcher.isStarted()) {
+    m_prefetcher.stop();
+  }
+}
+
+void BufferPool::prefetchPages( const pageId_t* pIds,
+                                uint32_t numPages ) noexcept {
+  IOEngine* engine = getIOEngine(m_config.m_ioQueueDepth);
+  if (engine != nullptr) {
+    loadBatch(pIds, numPages, nullptr, engine);
+    return;
+  }
+
+  // Without an engine the pages are read one at a time, as in pin
+  for (uint32_t i = 0; i < numPages; ++i) {
+    pageId_t pId = pIds[i];
+    uint32_t part = pId % m_config.m_numberOfPartitions;
+    bufferId_t bId;
+    std::unique_lock<std::mutex> partitionGuard(*m_partitions[part].p_lock);
+    waitForWriteBack(pId, &partitionGuard);
+    if (m_partitions[part].m_bufferToPageMap.find(pId, &bId) ||
+        pId >= m_allocationTable.size() || 
+        !m_allocationTable.test(pId)) {
+      continue;
+    }
+    if (getEmptySlot(&bId, part) != ErrorCode::E_NO_ERROR) {
+      return;
+    }
+    beginLoad(bId, pId, false);
+    m_partitions[part].m_bufferToPageMap.insert(pId, bId);
+    partitionGuard.unlock();
+
+    m_storage.read(m_buffers[bId], pId, false);
+    endLoad(bId, !m_config.m_lazyChecksums);
+  }
+}
+
+ErrorCode BufferPool::flushLog( bufferId_t bId ) noexcept {
+  if (!m_wal.isOpened()) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  return m_wal.flush(p_descriptors[bId].m_pageLSN.load(std::memory_order_acquire));
+}
+
+ErrorCode BufferPool::truncateLog( const lsn_t& lsn ) noexcept {
+  ErrorCode err = m_wal.flush(lsn);
+  if (err == ErrorCode::E_NO_ERROR) {
+    err = m_storage.sync();
+  }
+  if (err == ErrorCode::E_NO_ERROR) {
+    err = m_wal.truncate(lsn);
+  }
+  return err;
+}
+
+bool BufferPool::referenceBuffer( bufferId_t bId,
+                                 const pageId_t& pId,
+                                 bool pinned ) noexcept {
+  // The page of the buffer is only checked under the header lock, as the
+  // buffer may be being reused for another page
+  uint64_t state = p_descriptors[bId].lockHeader();
+  bool holdsPage = (state & BUF_IN_USE) && p_descriptors[bId].m_pageId == pId;
+  if (holdsPage && pinned) {
+    state += BUF_REFCOUNT_ONE;
+    if ((state & BUF_USAGECOUNT_MASK) != BUF_USAGECOUNT_MASK) {
+      state += BUF_USAGECOUNT_ONE;
+    }
+  }
+  p_descriptors[bId].unlockHeader(state);
+  return holdsPage;
+}
+
+void BufferPool::unswizzleBuffer( bufferId_t bId ) noexcept {
+  if (p_descriptors[bId].p_swip != nullptr) {
+    p_descriptors[bId].p_swip->m_bId.store(INVALID_BUFFER_ID, std::memory_order_release);
+    p_descriptors[bId].p_swip = nullptr;
+  }
+}
+
+void BufferPool::beginLoad( bufferId_t bId,
+                            pageId_t pId,
+                            bool pinned ) noexcept {
+  p_descriptors[bId].lockHeader();
+  p_descriptors[bId].m_pageId = pId;
+  p_descriptors[bId].m_pageLSN = 0;
+  uint64_t state = BUF_IN_USE | BUF_IO_IN_PROGRESS;
+  if (pinned) {
+    state |= BUF_REFCOUNT_ONE | BUF_USAGECOUNT_ONE;
+  }
+  if (m_storage.config().m_checksums && !m_recovering) {
+    state |= BUF_CHECKSUM_PENDING;
+  }
+  p_descriptors[bId].unlockHeader(state);
+}
+
+ErrorCode BufferPool::endLoad( bufferId_t bId,
+                               bool verify ) noexcept {
+  // The page is verified before other pins can see it, which wait while
+  // the load is in progress
+  ErrorCode err = ErrorCode::E_NO_ERROR;
+  if (verify && (p_descriptors[bId].m_state.load(std::memory_order_acquire) & BUF_CHECKSUM_PENDING)) {
+    err = m_storage.verify(m_buffers[bId], p_descriptors[bId].m_pageId);
+  }
+
+  uint64_t state = p_descriptors[bId].lockHeader();
+  if (verify) {
+    state &= ~(BUF_CHECKSUM_PENDING | BUF_CORRUPTED);
+    if (err == ErrorCode::E_STORAGE_CHECKSUM_MISMATCH) {
+      state |= BUF_CORRUPTED;
+    }
+  }
+  p_descriptors[bId].unlockHeader(state & ~BUF_IO_IN_PROGRESS);
+  return err;
+}
+
+ErrorCode BufferPool::waitForLoad( bufferId_t bId ) noexcept {
+  while (true) {
+    uint64_t state = p_descriptors[bId].m_state.load(std::memory_order_acquire);
+    if (!(state & (BUF_IO_IN_PROGRESS | BUF_CHECKSUM_PENDING))) {
+      return (state & BUF_CORRUPTED) ? ErrorCode::E_STORAGE_CHECKSUM_MISMATCH : ErrorCode::E_NO_ERROR;
+    }
+    if (!(state & BUF_IO_IN_PROGRESS)) {
+      // The first pin of a page loaded without verification verifies it,
+      // and the following ones wait as if it was still being loaded
+      state = p_descriptors[bId].lockHeader();
+      bool verifies = (state & (BUF_IO_IN_PROGRESS | BUF_CHECKSUM_PENDING)) == BUF_CHECKSUM_PENDING;
+      p_descriptors[bId].unlockHeader(verifies ? state | BUF_IO_IN_PROGRESS : state);
+      if (verifies) {
+        return endLoad(bId);
+      }
+      continue;
+    }
+    yieldWhileWaiting();
+  }
+}
+
+void BufferPool::waitForWriteBack( pageId_t pId,
+                                   std::unique_lock<std::mutex>* partitionGuard ) noexcept {
+  uint32_t part = pId % m_config.m_numberOfPartitions;
+  while (m_partitions[part].m_pendingWriteBacks.count(pId) > 0) {
+    partitionGuard->unlock();
+    yieldWhileWaiting();
+    partitionGuard->lock();
+  }
+}
+
+void BufferPool::waitForWriteBacks( std::vector<std::unique_lock<std::mutex>>* partitionGuards ) noexcept {
+  auto pending = [this] () {
+    for (uint32_t i = 0; i < m_config.m_numberOfPartitions; ++i) {
+      if (!m_partitions[i].m_pendingWriteBacks.empty()) {
+        return true;
+      }
+    }
+    return false;
+  };
+  while (pending()) {
+    for (auto& partitionGuard : *partitionGuards) {
+      partitionGuard.unlock();
+    }
+    // The write-backs of other tasks of this thread are only done once
+    // their completions are reaped, which they cannot do while we wait
+    if (getCurrentThreadId() != INVALID_THREAD_ID) {
+      IOEngine* engine = getTaskIOEngine(m_config.m_ioQueueDepth);
+      if (engine != nullptr) {
+        reapAsyncLoads(engine);
+      }
+    }
+    yieldWhileWaiting();
+    for (auto& partitionGuard : *partitionGuards) {
+      partitionGuard.lock();
+    }
+  }
+}
+
+void BufferPool::endWriteBack( pageId_t pId ) noexcept {
+  uint32_t part = pId % m_config.m_numberOfPartitions;
+  std::lock_guard<std::mutex> partitionGuard(*m_partitions[part].p_lock);
+  m_partitions[part].m_pendingWriteBacks.erase(pId);
+}
+
+void BufferPool::reapAsyncLoads( IOEngine* engine ) noexcept {
+  const uint32_t maxCompletions = 16;
+  IOCompletion completions[maxCompletions];
+  uint32_t reaped;
+  do {
+    reaped = engine->reap(completions, maxCompletions, 0);
+    for (uint32_t c = 0; c < reaped; ++c) {
+      AsyncLoad* load = reinterpret_cast<AsyncLoad*>(completions[c].m_tag & ~1ULL);
+      completeBatchLoad(completions[c], &load->m_load);
+      --load->m_numPending;
+    }
+  } while (reaped == maxCompletions);
+}
+
+void BufferPool::completeBatchLoad( const IOCompletion& completion,
+                                    const Load* loads ) noexcept {
+  bool isWrite = (completion.m_tag & 1) != 0;
+  if (isWrite) {
+    // A failed write-back cancels the linked read, so both are retried
+    // synchronously once the read reports its cancellation
+    if (completion.m_result == static_cast<int64_t>(m_storage.getPageSize())) {
+      endWriteBack(loads[0].m_victim);
+    }
+    return;
+  }
+
+  uint32_t numPages = loads[0].m_numPages;
+  if (completion.m_result != static_cast<int64_t>(numPages*m_storage.getPageSize())) {
+    if (loads[0].m_victim != INVALID_PAGE_ID && completion.m_result == -ECANCELED) {
+      m_storage.write(m_buffers[loads[0].m_bId], loads[0].m_victim);
+      endWriteBack(loads[0].m_victim);
+    }
+    for (uint32_t i = 0; i < numPages; ++i) {
+      m_storage.read(m_buffers[loads[i].m_bId], loads[i].m_pId, false);
+    }
+  }
+  // Pinned pages are verified right away, and mismatches are reported by
+  // waitForLoad
+  for (uint32_t i = 0; i < numPages; ++i) {
+    endLoad(loads[i].m_bId, loads[i].m_verify);
+  }
 }
 
 ErrorCode BufferPool::dumpAllocTable() noexcept {
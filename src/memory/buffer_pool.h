@@ -4,19 +4,43 @@
 #ifndef _MEMORY_BUFFER_POOL_H_
 #define _MEMORY_BUFFER_POOL_H_
 
-#include <unordered_map>
+#include <unordered_set>
 #include <list>
 #include <queue>
+#include <atomic>
 #include <mutex>
-#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
 #include "../base/platform.h"
+#include "../storage/double_write_buffer.h"
 #include "../storage/file_storage.h"
+#include "../storage/io_engine.h"
+#include "../storage/write_ahead_log.h"
+#include "page_table.h"
+#include "prefetcher.h"
 #include "types.h"
 #include "boost/dynamic_bitset.hpp"
 
 
 SMILE_NS_BEGIN
 
+/**
+ * How the storage grows when there are no free pages left to allocate.
+ */
+enum class GrowthPolicy {
+  /**
+   * Grows by m_growthPages pages every time.
+   */
+  E_FIXED,
+
+  /**
+   * Grows by as many pages as the storage already has, at least
+   * m_growthPages and at most m_maxGrowthKB, so the number of reservations
+   * is logarithmic in the size of the storage.
+   */
+  E_GEOMETRIC
+};
+
 struct BufferPoolConfig {
     /**
      * Size of the Buffer Pool in KB.
@@ -24,15 +48,113 @@ struct BufferPoolConfig {
     size_t  m_poolSizeKB = 1024*1024;
 
     /**
-     * Number of consecutive pages to prefetch. For instance: if set to 3,
-     * after pinning page X, pages: X+1, X+2 and X+3 will be prefetched.
+     * Maximum number of pages prefetched ahead of a sequential or strided
+     * stream of pins of a thread. The prefetch window of a stream starts
+     * small and doubles while the stream keeps reaching the prefetched
+     * pages, up to this size. 0 disables prefetching.
      */
     uint16_t  m_prefetchingDegree = 0;
 
+    /**
+     * Maximum number of pages requested by the prefetcher and not loaded
+     * yet. Further requests are delayed until these are loaded.
+     */
+    uint32_t  m_maxPrefetchedPages = 256;
+
     /**
      * Number of partitions of the buffer pool.
      */
     uint32_t m_numberOfPartitions = 16;
+
+    /**
+     * How the storage grows when all its pages are allocated.
+     */
+    GrowthPolicy m_growthPolicy = GrowthPolicy::E_GEOMETRIC;
+
+    /**
+     * Number of pages reserved at once by E_FIXED growth, and the minimum
+     * reserved by E_GEOMETRIC growth.
+     */
+    uint32_t m_growthPages = 64;
+
+    /**
+     * Maximum size in KB reserved at once by E_GEOMETRIC growth.
+     */
+    size_t  m_maxGrowthKB = 1024*1024;
+
+    /**
+     * Maximum number of storage requests kept in flight by batched pins,
+     * asynchronous pins, prefetches and checkpoints. 0, the default, issues
+     * them one at a time.
+     */
+    uint32_t m_ioQueueDepth = 0;
+
+    /**
+     * Maximum size in KB of a single storage request covering contiguous
+     * pages. Batched pins and checkpoints merge runs of contiguous pages into
+     * vectored requests of up to this size.
+     */
+    uint32_t m_ioRangeKB = 4*1024;
+
+    /**
+     * Maps the whole storage in memory instead of copying pages into
+     * buffers. Pins return pointers into the mapping, which is read-only, so
+     * alloc, release and setPageDirty fail. The pool size is ignored.
+     */
+    bool m_readOnlyMapping = false;
+
+    /**
+     * When the storage keeps page checksums, verifies each page on its first
+     * pin after being loaded instead of right after it is read, so that
+     * prefetched pages are only verified if they are used.
+     */
+    bool m_lazyChecksums = false;
+
+    /**
+     * Emulates a slower device under the storage. Disabled by default. Mostly
+     * useful together with in-memory storages to benchmark the pool against
+     * different kinds of devices.
+     */
+    DeviceProfile m_deviceProfile;
+
+    /**
+     * Keeps a write-ahead log next to the storage, at <path>.wal. Updates
+     * logged with logUpdate are durable once committed, and are redone
+     * when the pool is opened after a crash.
+     */
+    bool m_writeAheadLog = false;
+
+    /**
+     * Stages the pages written by checkpoints in a double-write file next to
+     * the storage, at <path>.dwb, before writing them in place, so that a
+     * crash in the middle of a checkpoint cannot leave torn pages behind.
+     * Pages written back on eviction are not staged. With the write-ahead
+     * log, the updates of a page torn that way are redone over it.
+     */
+    bool m_doubleWrite = false;
+
+    /**
+     * Maximum size in KB of the batches of pages staged in the double-write
+     * file. Every batch costs a sync of the file and one of the storage.
+     */
+    uint32_t m_doubleWriteKB = 16*1024;
+
+    /**
+     * Period in milliseconds of the background write-back of the pages
+     * written to the storage. A thread pushes them to the device every
+     * period and drops them from the kernel cache, so that checkpoints do
+     * not stall behind a large backlog of dirty kernel pages. 0 disables it.
+     * Ignored with direct I/O.
+     */
+    uint32_t m_writeBackIntervalMs = 0;
+
+    /**
+     * Gives the space of released pages back to the file system by punching
+     * holes in the storage. Pages released since the last checkpoint are
+     * discarded by the next one, once the allocation table that frees them
+     * is durable. They read back as new pages when allocated again.
+     */
+    bool m_punchHoles = false;
 };
 
 struct BufferHandler {
@@ -52,43 +174,162 @@ struct BufferHandler {
     bufferId_t      m_bId;
 };
 
-struct BufferDescriptor {
+struct OptimisticReadHandler {
+    /**
+     * Pointer to the buffer holding the page while the read is valid.
+     */
+    const char*     m_buffer;
+
+    /**
+     * pageId_t of the page being read.
+     */
+    pageId_t        m_pId;
+
+    /**
+     * bufferId_t of the buffer being read.
+     */
+    bufferId_t      m_bId;
+
+    /**
+     * Version of the buffer when the read began.
+     */
+    uint64_t        m_version;
+};
+
+/**
+ * A reference to a page held in memory, such as the page ids read from a
+ * metadata page, which can be swizzled into a direct reference to the buffer
+ * of the page while it is in the Buffer Pool. Pins through a swizzled
+ * reference skip the page table, and evicting the page unswizzles it. A
+ * buffer is referenced by at most one swizzled Swip at once, and Swips must
+ * be unswizzled before they are destroyed.
+ */
+struct Swip {
+    Swip() noexcept = default;
+
+    Swip( const pageId_t& pId ) noexcept : m_pId{pId} {}
+
+    /**
+     * pageId_t of the referenced page.
+     */
+    pageId_t                  m_pId = INVALID_PAGE_ID;
+
+    /**
+     * bufferId_t of the buffer holding the page while the reference is
+     * swizzled, INVALID_BUFFER_ID otherwise.
+     */
+    std::atomic<bufferId_t>   m_bId{INVALID_BUFFER_ID};
+};
+
+/**
+ * Layout of the state word of a buffer descriptor, as in the buffer headers
+ * of PostgreSQL. The reference count takes the lowest 32 bits and the usage
+ * count the next 16, followed by the flags.
+ */
+#define BUF_REFCOUNT_ONE          0x0000000000000001ULL
+#define BUF_REFCOUNT_MASK         0x00000000ffffffffULL
+#define BUF_USAGECOUNT_ONE        0x0000000100000000ULL
+#define BUF_USAGECOUNT_MASK       0x0000ffff00000000ULL
+
+/**
+ * A thread holds the descriptor header lock. The rest of the state and the
+ * other fields of the descriptor are only changed by the holder of the lock,
+ * except for the reference count, which unpins decrement once the lock is
+ * free.
+ */
+#define BUF_LOCKED                0x0001000000000000ULL
+
+/**
+ * The buffer is dirty.
+ */
+#define BUF_DIRTY                 0x0002000000000000ULL
+
+/**
+ * The buffer slot is currently being used.
+ */
+#define BUF_IN_USE                0x0004000000000000ULL
+
+/**
+ * The page is being read into the buffer. Pins of the page wait until the
+ * read is done.
+ */
+#define BUF_IO_IN_PROGRESS        0x0008000000000000ULL
+
+/**
+ * The loaded page has not been verified against its checksum yet. The first
+ * pin verifies it.
+ */
+#define BUF_CHECKSUM_PENDING      0x0010000000000000ULL
+
+/**
+ * The loaded page did not match its checksum. Pins of the page fail until it
+ * is loaded again.
+ */
+#define BUF_CORRUPTED             0x0020000000000000ULL
+
+/**
+ * The mutable state of a buffer. Descriptors are aligned to cache lines, so
+ * that the atomic updates of pins and unpins of a buffer do not invalidate
+ * the descriptors of other buffers.
+ */
+struct alignas(CACHE_LINE_SIZE) BufferDescriptor {
     /**
-     * Number of current references of the page.
+     * Reference count, usage count and flags of the buffer, packed so that
+     * pins and unpins update them with atomic operations.
      */
-    uint64_t    m_referenceCount = 0;
+    std::atomic<uint64_t> m_state{0};
 
     /**
-     * Number of times the stored page has been accessed since it was loaded in the slot.
+     * Odd while the page is being modified, and increased by two whenever
+     * the page leaves the buffer or is marked as dirty, so that optimistic
+     * reads can tell whether they read a stable page.
      */
-    uint64_t    m_usageCount    = 0;
+    std::atomic<uint64_t> m_version{0};
 
     /**
-     * pageId_t on disk of the loaded page.
+     * pageId_t on disk of the loaded page. Changed under the header lock,
+     * and read by optimistic reads without it.
      */
-    pageId_t    m_pageId        = 0;
+    std::atomic<pageId_t> m_pageId{0};
 
     /**
-     * Whether the buffer is dirty or not.
+     * The LSN following the last logged update of the page. The log is
+     * flushed up to it before the page is written back. Published once the
+     * update is appended, without the header lock.
      */
-    bool        m_dirty         = false;
+    std::atomic<lsn_t>    m_pageLSN{0};
 
     /**
-     * Whether a buffer slot is currently being used or not.
+     * The Swip swizzled to the buffer, if any, which is unswizzled when the
+     * page leaves the buffer. Changed under the header lock.
      */
-    bool        m_inUse         = false;
+    Swip*       p_swip          = nullptr;
 
     /**
-     * Lock to isolate descriptor's modifications.
+     * Takes the header lock, waiting while another thread holds it
+     *
+     * @return The state of the descriptor, including BUF_LOCKED.
      */
-    std::unique_ptr<std::shared_timed_mutex> m_contentLock = nullptr;
+    uint64_t lockHeader() noexcept;
 
     /**
-     * Pointer to data of the cached page.
+     * Takes the header lock, unless another thread holds it
+     *
+     * @param state Set to the state of the descriptor, including BUF_LOCKED.
+     * @return false if the lock is held by another thread, true otherwise.
      */
-    char*       p_buffer;
+    bool tryLockHeader( uint64_t* state ) noexcept;
+
+    /**
+     * Releases the header lock, publishing a new state
+     *
+     * @param state The new state of the descriptor.
+     */
+    void unlockHeader( uint64_t state ) noexcept;
 };
 
+static_assert(sizeof(BufferDescriptor) == CACHE_LINE_SIZE, "Buffer descriptors must take a single cache line");
+
 struct BufferPoolStatistics {
     /**
      * Number of pages currently in Buffer Pool. 
@@ -104,6 +345,22 @@ struct BufferPoolStatistics {
      * The size of a page in bytes
      */
     uint64_t    m_pageSize;
+
+    /**
+     * Number of pages requested by the prefetcher since the Buffer Pool was
+     * opened.
+     */
+    uint64_t    m_numPrefetchedPages;
+
+    /**
+     * Number of evicted pages whose write-back is still in flight.
+     */
+    uint64_t    m_numPendingWriteBacks;
+
+    /**
+     * The I/O performed on the storage since the Buffer Pool was opened.
+     */
+    IOStatistics m_io;
 };
 
 class BufferPool final {
@@ -131,11 +388,14 @@ class BufferPool final {
      * 
      * @param in the path to the storage to create.
      * @return in the configuration of the storage.
+     * @param in the paths of the data files of the stripes of the storage
+     * after the first one.
      **/
     ErrorCode create( const BufferPoolConfig& bpConfig, 
                       const std::string& path, 
                       const FileStorageConfig& fsConfig, 
-                      const bool& overwrite = false ) noexcept;
+                      const bool& overwrite = false,
+                      const std::vector<std::string>& stripePaths = {} ) noexcept;
 
     /**
      * Closes the Buffer Pool.
@@ -160,6 +420,20 @@ class BufferPool final {
      */
     ErrorCode release( const pageId_t& pId ) noexcept;
 
+    /**
+     * Compacts the storage online, moving the allocated pages at its end to
+     * the lowest free pages and truncating the free pages left at the end.
+     * The pool is checkpointed first. Pages pinned while it runs are not
+     * moved. Moved pages must not be pinned or released by their old
+     * pageId_t, so other threads must not access them until the references
+     * to them are updated.
+     * 
+     * @param relocations Filled with the old and the new pageId_t of each
+     * moved page.
+     * @return false if the storage was compacted, true otherwise.
+     */
+    ErrorCode compact( std::vector<std::pair<pageId_t, pageId_t>>* relocations ) noexcept;
+
     /**
      * Pins a page.
      * 
@@ -171,6 +445,35 @@ class BufferPool final {
                    BufferHandler* bufferHandler, 
                    bool enablePrefetch = true ) noexcept;
 
+    /**
+     * Pins a set of pages. The reads of the pages that are not in the Buffer
+     * Pool are kept in flight at the same time, and dirty buffers evicted to
+     * make room for them are written back before being reused.
+     * 
+     * @param pIds The pages to pin.
+     * @param numPages The number of pages to pin.
+     * @param bufferHandlers Array of numPages BufferHandlers for the pinned pages.
+     * @return false if the pins were successful, true otherwise. On failure,
+     * the pages pinned so far must still be unpinned.
+     */
+    ErrorCode pinBatch( const pageId_t* pIds,
+                        uint32_t numPages,
+                        BufferHandler* bufferHandlers ) noexcept;
+
+    /**
+     * Pins a page from a task. If the page is not in the Buffer Pool, its
+     * read is submitted asynchronously and the task yields to the other
+     * tasks of its thread until the page is loaded, so a single thread keeps
+     * the misses of all its tasks in flight. Outside of tasks, or with the
+     * I/O engine disabled, it behaves like pin without prefetching.
+     * 
+     * @param pId Page to pin.
+     * @param bufferHandler BufferHandler for the pinned page.
+     * @return false if the pin was successful, true otherwise.
+     */
+    ErrorCode pinAsync( const pageId_t& pId, 
+                        BufferHandler* bufferHandler ) noexcept;
+
     /**
      * Unpins a page.
      * 
@@ -179,6 +482,87 @@ class BufferPool final {
      */
     ErrorCode unpin( const BufferHandler& handler ) noexcept;
 
+    /**
+     * Pins the page of a Swip. Swizzled Swips lead straight to the buffer of
+     * the page, and the others are swizzled once the page is pinned, unless
+     * another Swip is swizzled to its buffer.
+     * 
+     * @param swip The reference to the page to pin.
+     * @param bufferHandler BufferHandler for the pinned page.
+     * @return false if the pin was successful, true otherwise.
+     */
+    ErrorCode pinSwip( Swip* swip, 
+                       BufferHandler* bufferHandler ) noexcept;
+
+    /**
+     * Unswizzles a Swip, which must be done before it is destroyed.
+     * 
+     * @param swip The reference to unswizzle.
+     */
+    void unswizzle( Swip* swip ) noexcept;
+
+    /**
+     * Begins an optimistic read of a page, which neither pins it nor writes
+     * to any shared state. The page may be evicted or modified while it is
+     * read, so whatever is read must only be used once the read has been
+     * validated, and the read must be retried otherwise. Pages that are not
+     * in the Buffer Pool are loaded first. Writers must modify the pages
+     * between beginWrite and endWrite for concurrent reads to notice the
+     * modification.
+     * 
+     * @param pId The page to read.
+     * @param handler The handler of the read.
+     * @return E_NO_ERROR if the read could begin, the error loading the page
+     * otherwise.
+     */
+    ErrorCode beginOptimisticRead( const pageId_t& pId, 
+                                   OptimisticReadHandler* handler ) noexcept;
+
+    /**
+     * Checks that the page of an optimistic read has stayed in its buffer,
+     * and has not been modified or marked as dirty, since the read began.
+     * Reads that began while the page was being modified are never valid.
+     * 
+     * @param handler The handler of the read.
+     * @return true if what was read is valid, false if the read must be
+     * retried.
+     */
+    bool validateOptimisticRead( const OptimisticReadHandler& handler ) noexcept;
+
+    /**
+     * Begins a modification of a pinned page, waiting for the one in
+     * progress, if any. Optimistic reads of the page fail their validation
+     * from now on, until the modification ends and they are retried.
+     * 
+     * @param handler The handler of the pinned page.
+     * @return E_BUFPOOL_READ_ONLY if the pool maps the storage read-only.
+     */
+    ErrorCode beginWrite( const BufferHandler& handler ) noexcept;
+
+    /**
+     * Ends the modification of a pinned page begun by beginWrite, and sets
+     * the page as dirty.
+     * 
+     * @param handler The handler of the pinned page.
+     * @return E_BUFPOOL_READ_ONLY if the pool maps the storage read-only.
+     */
+    ErrorCode endWrite( const BufferHandler& handler ) noexcept;
+
+    /**
+     * Hints the expected access pattern of a range of pages, for instance
+     * before a sequential scan or a phase of random lookups. The kernel
+     * adapts its read-ahead to it, unless the storage uses direct I/O.
+     * 
+     * @param pattern The expected access pattern.
+     * @param firstPage The first page of the range.
+     * @param numPages The number of pages of the range. 0 means up to the end
+     * of the storage.
+     * @return false if the hint was applied, true otherwise.
+     */
+    ErrorCode adviseAccess( AccessPattern pattern,
+                            const pageId_t& firstPage = 0,
+                            uint64_t numPages = 0 ) noexcept;
+
     /**
      * Checkpoints the BufferPool to the storage.
      * 
@@ -187,12 +571,39 @@ class BufferPool final {
     ErrorCode checkpoint() noexcept;
 
     /**
-     * Sets a page as dirty.
+     * Sets a page as dirty. Optimistic reads validated afterwards fail, but
+     * those validated while the page was being modified do not, so pages
+     * read optimistically must be modified with beginWrite and endWrite.
      * 
      * @param pId pageId_t of the page to be set as dirty.
      */
     ErrorCode setPageDirty( const pageId_t& pId ) noexcept;
 
+    /**
+     * Logs the current contents of a range of a pinned page in the
+     * write-ahead log, and sets the page as dirty. The update is durable
+     * once committed.
+     * 
+     * @param handler The handler of the pinned page.
+     * @param offset The offset in the page of the updated range.
+     * @param size The size of the updated range.
+     * @param lsn Set to the LSN to commit for the update to be durable.
+     * @return E_BUFPOOL_NO_WRITE_AHEAD_LOG if the log is not enabled.
+     */
+    ErrorCode logUpdate( const BufferHandler& handler,
+                         uint32_t offset,
+                         uint32_t size,
+                         lsn_t* lsn ) noexcept;
+
+    /**
+     * Waits until the updates logged up to an LSN are durable. Concurrent
+     * commits are grouped in a single sync of the log.
+     * 
+     * @param lsn The LSN returned by logUpdate.
+     * @return E_BUFPOOL_NO_WRITE_AHEAD_LOG if the log is not enabled.
+     */
+    ErrorCode commit( const lsn_t& lsn ) noexcept;
+
     /**
      * Gets some stats regarding the Buffer Pool's usage.
      * 
@@ -227,19 +638,189 @@ class BufferPool final {
 
     ErrorCode allocatePartitions() noexcept;
 
+    /**
+     * Adds a reference to a buffer found by a lookup without the partition
+     * lock, if it still holds the page.
+     * 
+     * @param bId The buffer found.
+     * @param pId The page looked up.
+     * @param pinned Whether to pin the buffer, or just check it.
+     * @return false if the buffer has been reused for another page, true
+     * otherwise.
+     */
+    bool referenceBuffer( bufferId_t bId,
+                          const pageId_t& pId,
+                          bool pinned ) noexcept;
+
+    /**
+     * Unswizzles the Swip swizzled to a buffer, if any, as its page leaves
+     * it. The header lock of the buffer must be held.
+     * 
+     * @param bId The buffer the page leaves.
+     */
+    void unswizzleBuffer( bufferId_t bId ) noexcept;
+
     /**
      * Returns the bufferId_t of an empty buffer pool slot. In case none is free
      * Clock Sweep algorithm is performed to evict a page.
      * 
      * @param bId bufferId_t of the free pool slot.
      * @param partition Buffer pool partition where to search for an empty slot.
+     * @param dirtyVictim If given, the page of an evicted dirty buffer is
+     * returned here instead of being written (INVALID_PAGE_ID otherwise), and
+     * the caller must write it back before reusing the buffer.
      * @return false if all pages are pinned, true otherwise.
      */
     ErrorCode getEmptySlot( bufferId_t* bId, 
-                            uint32_t partition ) noexcept;
+                            uint32_t partition,
+                            pageId_t* dirtyVictim = nullptr ) noexcept;
+
+    /**
+     * A page read issued by pinBatch. Contiguous pages may be read by a
+     * single request, which is tracked by the load of its first page.
+     */
+    struct Load {
+        bufferId_t  m_bId;
+        pageId_t    m_pId;
+        pageId_t    m_victim;
+        uint32_t    m_numPages;
+        bool        m_verify;
+    };
 
     /**
-     * Returns the pageId_t of an empty page. A boolean is returned indicating
+     * A page read issued by pinAsync, with the write-back of its victim. It
+     * is completed by whichever task of the thread reaps its requests, and
+     * is identified by its address in their tags, so it stays alive until
+     * none of them is pending.
+     */
+    struct AsyncLoad {
+        Load        m_load;
+        uint32_t    m_numPending;
+    };
+
+    /**
+     * Loads a set of pages with requests kept in flight at the same time,
+     * merging contiguous pages into vectored reads. Used by pinBatch, and by
+     * the prefetcher without pinning the pages.
+     * 
+     * @param pIds The pages to load.
+     * @param numPages The number of pages to load.
+     * @param bufferHandlers Array of numPages BufferHandlers for the pinned
+     * pages, or nullptr to load the pages without pinning them, skipping
+     * the free ones.
+     * @param engine The engine of the calling thread.
+     * @return false if the pages were loaded, true otherwise.
+     */
+    ErrorCode loadBatch( const pageId_t* pIds,
+                         uint32_t numPages,
+                         BufferHandler* bufferHandlers,
+                         IOEngine* engine ) noexcept;
+
+    /**
+     * Loads the pages requested by the prefetcher without pinning them.
+     * Pages that are loaded or free by then are skipped.
+     * 
+     * @param pIds The pages to load, sorted.
+     * @param numPages The number of pages to load.
+     */
+    void prefetchPages( const pageId_t* pIds,
+                        uint32_t numPages ) noexcept;
+
+    /**
+     * Sets up the descriptor of a buffer that the given page is going to be
+     * read into.
+     * 
+     * @param bId The buffer the page is read into.
+     * @param pId The page being read.
+     * @param pinned Whether the buffer is pinned by the reader.
+     */
+    void beginLoad( bufferId_t bId,
+                    pageId_t pId,
+                    bool pinned ) noexcept;
+
+    /**
+     * Marks the read into a buffer as done.
+     * 
+     * @param bId The buffer the page was read into.
+     * @param verify Whether to verify the page against its checksum now,
+     * instead of on its first pin.
+     * @return E_STORAGE_CHECKSUM_MISMATCH if the page was verified and is
+     * corrupted.
+     */
+    ErrorCode endLoad( bufferId_t bId,
+                       bool verify = true ) noexcept;
+
+    /**
+     * Waits until the page of a pinned buffer has been read, and verifies it
+     * if this is its first pin.
+     * 
+     * @param bId The buffer to wait for.
+     * @return E_STORAGE_CHECKSUM_MISMATCH if the page is corrupted.
+     */
+    ErrorCode waitForLoad( bufferId_t bId ) noexcept;
+
+    /**
+     * Waits until a page evicted by pinBatch has been written back, so that
+     * it is not read from the storage before. The partition of the page must
+     * be locked by the caller, and it is released while waiting.
+     * 
+     * @param pId The page to wait for.
+     * @param partitionGuard The lock of the partition of the page.
+     */
+    void waitForWriteBack( pageId_t pId,
+                           std::unique_lock<std::mutex>* partitionGuard ) noexcept;
+
+    /**
+     * Waits until the write-backs of every evicted page are done, so that
+     * they are covered by the next sync of the storage. The buffers of the
+     * evicted pages already hold other pages, so flushing the dirty buffers
+     * does not write them. The locks of all the partitions must be held by
+     * the caller, and they are released while waiting.
+     * 
+     * @param partitionGuards The locks of all the partitions.
+     */
+    void waitForWriteBacks( std::vector<std::unique_lock<std::mutex>>* partitionGuards ) noexcept;
+
+    /**
+     * Marks the write-back of an evicted page as done.
+     * 
+     * @param pId The page written back.
+     */
+    void endWriteBack( pageId_t pId ) noexcept;
+
+    /**
+     * Completes the requests issued by pinAsync in the engine of the calling
+     * thread that are done, without waiting for the others.
+     * 
+     * @param engine The engine shared by the tasks of the thread.
+     */
+    void reapAsyncLoads( IOEngine* engine ) noexcept;
+
+    /**
+     * Processes the completion of a request issued by pinBatch or pinAsync,
+     * retrying it synchronously if it failed.
+     * 
+     * @param completion The completion of the request.
+     * @param loads The loads of the pages of the request.
+     */
+    void completeBatchLoad( const IOCompletion& completion,
+                            const Load* loads ) noexcept;
+
+    /**
+     * Processes the result of the write of a buffer by flushDirtyBuffers.
+     * 
+     * @param bId The buffer written.
+     * @param result The result of the write.
+     * @param err Set to the result if the write failed.
+     */
+    void completeFlush( bufferId_t bId,
+                        ErrorCode result,
+                        ErrorCode* err ) noexcept;
+
+    /**
+     * Returns the pageId_t of an empty page. The lowest page at the head of
+     * the free lists is taken, so that pages reserved together are
+     * allocated in order. A boolean is returned indicating
      * whether it has been possible to find a free one or not.
      * 
      * @param pId The returned pId of a free page (if found).
@@ -247,6 +828,13 @@ class BufferPool final {
      */
     bool getFreePage(pageId_t* pId) noexcept;
 
+    /**
+     * Computes how many pages to reserve next according to the growth policy.
+     * 
+     * @return The number of pages to reserve
+     */
+    uint32_t getGrowthPages() noexcept;
+
     /**
      * Reserve a set of pages and manage the increments of the allocation table.
      * 
@@ -271,28 +859,164 @@ class BufferPool final {
      */
     ErrorCode storeAllocationTable() noexcept;
 
+    /**
+     * Punches holes in the storage for the pages released since the last
+     * call that are still free, after syncing the allocation table.
+     * 
+     * @return false if the pages have been discarded, true otherwise.
+     */
+    ErrorCode discardReleasedPages() noexcept;
+
+    /**
+     * Moves an allocated page to a free page during compaction, evicting it
+     * from the pool if it is loaded. All partitions must be locked, with no
+     * write-back in flight.
+     * 
+     * @param from The page to move.
+     * @param to The free page to move it to.
+     * @param buffer A page-sized buffer to copy pages that are not loaded.
+     * @param moved Set to false if the page is pinned and cannot be moved.
+     * @return false if the page has been moved or skipped, true otherwise.
+     */
+    ErrorCode movePage( const pageId_t& from,
+                        const pageId_t& to,
+                        char* buffer,
+                        bool* moved ) noexcept;
+
 
     /**
-     * Flushes dirty buffers back to disk.
+     * Flushes dirty buffers back to disk. No buffer may be evicted while
+     * flushing, so all partitions must be locked or the pool not in use.
      * 
      * @return false if buffers have been correctly flushed, true otherwise
      */
     ErrorCode flushDirtyBuffers() noexcept;
 
+    /**
+     * Writes dirty buffers back to disk, merging contiguous pages into
+     * vectored writes. Used by flushDirtyBuffers.
+     * 
+     * @param dirty The pages to write with their buffers, sorted by page.
+     * @param numPages The number of pages to write.
+     * @return false if buffers have been correctly written, true otherwise
+     */
+    ErrorCode writeDirtyBuffers( const std::pair<pageId_t, bufferId_t>* dirty,
+                                 uint32_t numPages ) noexcept;
+
+    /**
+     * Stages pages in the double-write buffer before they are written in
+     * place, if it is enabled.
+     * 
+     * @param pageIds The pages to write.
+     * @param data The contents of the pages.
+     * @param numPages The number of pages.
+     * @return false if the pages are staged, true otherwise.
+     */
+    ErrorCode stagePages( const pageId_t* pageIds,
+                          const char* const* data,
+                          uint32_t numPages ) noexcept;
+
+    /**
+     * Syncs the storage after the staged pages have been written in place
+     * and clears the double-write buffer, if it is enabled.
+     * 
+     * @return false if the pages are durable, true otherwise.
+     */
+    ErrorCode unstagePages() noexcept;
+
+    /**
+     * Writes in place a page found in the double-write buffer when the pool
+     * is opened.
+     * 
+     * @param pId The page to restore.
+     * @param data The contents of the page.
+     * @return false if the page has been restored, true otherwise.
+     */
+    ErrorCode restorePage( const pageId_t& pId,
+                           const char* data ) noexcept;
+
+    /**
+     * Applies a record of the write-ahead log when the pool is opened.
+     * 
+     * @param record The header of the record.
+     * @param data The data of the record.
+     * @return E_STORAGE_INVALID_LOG if the record does not fit the storage.
+     */
+    ErrorCode redo( const WALRecord& record, 
+                    const char* data ) noexcept;
+
+    /**
+     * Makes the log records of a buffer durable before it is written back.
+     * 
+     * @param bId The buffer to write back.
+     * @return false if the log was flushed, true otherwise.
+     */
+    ErrorCode flushLog( bufferId_t bId ) noexcept;
+
+    /**
+     * Discards the log records up to an LSN once the storage is synced, as
+     * the updates they log have been written back.
+     * 
+     * @param lsn The LSN up to which updates have been written back.
+     * @return false if the log was truncated, true otherwise.
+     */
+    ErrorCode truncateLog( const lsn_t& lsn ) noexcept;
+
+    /**
+     * Starts the background write-back thread, if enabled.
+     */
+    void startWriteBack() noexcept;
+
+    /**
+     * Stops the background write-back thread, if started.
+     */
+    void stopWriteBack() noexcept;
+
+    /**
+     * Body of the background write-back thread.
+     */
+    void writeBackLoop() noexcept;
+
+    /**
+     * Starts the prefetcher, if enabled.
+     */
+    void startPrefetch() noexcept;
+
+    /**
+     * Stops the prefetcher, if started.
+     */
+    void stopPrefetch() noexcept;
+
     /**
      * The file storage where this buffer pool will be persisted.
      **/
     FileStorage m_storage;
 
+    /**
+     * The redo log of the updates of the pages, if enabled.
+     **/
+    WriteAheadLog m_wal;
+
+    /**
+     * The staging area of the pages written by checkpoints, if enabled.
+     **/
+    DoubleWriteBuffer m_dwb;
+
     /**
      * The Buffer Pool configuration data.
      */
     BufferPoolConfig m_config;
 
     /**
-     * Buffer descriptors (metadata).
+     * Buffer descriptors (metadata), one per cache line.
      */
-    std::vector<BufferDescriptor> m_descriptors;
+    BufferDescriptor* p_descriptors;
+
+    /**
+     * Pointers to the data of the buffers, which are only read once the
+     * pool is allocated.
+     */
+    std::vector<char*> m_buffers;
 
     /**
      * Bitset representing whether a disk page is allocated (1) or not (0).
@@ -312,8 +1036,26 @@ class BufferPool final {
     
         /**
          * Maps pageId_t with its bufferId_t in case it is currently in the Buffer Pool. 
+         * Pins look pages up without the partition lock, which updates take.
+         */
+        PageTable m_bufferToPageMap;
+
+        /**
+         * Evicted pages whose write-back is still in flight.
+         */
+        std::unordered_set<pageId_t> m_pendingWriteBacks;
+
+        /**
+         * Pages released since the last checkpoint, whose space is given
+         * back to the file system by the next one.
          */
-        std::unordered_map<pageId_t, bufferId_t> m_bufferToPageMap;
+        std::vector<pageId_t> m_releasedPages;
+
+        /**
+         * Next victim to test during Clock Sweep. The hand only visits the
+         * buffers of the partition.
+         */
+        bufferId_t m_nextCSVictim;
 
         /**
          * Partition lock to isolate concurrent operations by different threads.
@@ -325,14 +1067,10 @@ class BufferPool final {
     std::vector<Partition> m_partitions;
 
     /**
-     * Next victim to test during Clock Sweep.
+     * Detects the streams of pins and loads the pages ahead of them, if
+     * prefetching is enabled.
      */
-    uint64_t m_nextCSVictim;
-
-    /**
-     * ID of the next thread used for prefetching.
-     */
-    uint16_t m_currentThread;    
+    Prefetcher m_prefetcher;
 
     /**
      * Sotres the number of numa nodes
@@ -344,6 +1082,44 @@ class BufferPool final {
      */
     char**   p_buffersData;
 
+    /**
+     * Size in bytes of the data buffer of each numa node
+     */
+    size_t   m_sizePerNode;
+
+    /**
+     * The mapping of the storage when opened with m_readOnlyMapping.
+     * nullptr otherwise.
+     */
+    const char* p_mapping;
+
+    /**
+     * The background write-back thread, if enabled.
+     */
+    std::thread m_writeBackThread;
+
+    /**
+     * Protects m_stopWriteBack.
+     */
+    std::mutex m_writeBackLock;
+
+    /**
+     * Wakes up the write-back thread when it has to finish.
+     */
+    std::condition_variable m_writeBackCondition;
+
+    /**
+     * Tells the write-back thread to finish.
+     */
+    bool m_stopWriteBack;
+
+    /**
+     * Flag set while the log is redone. After a system crash, pages written
+     * after the last checkpoint may have a stale checksum, and the redone
+     * updates cover them, so pages are loaded without verification.
+     */
+    bool m_recovering;
+
     /**
      * Flag set for opened buffer pools
      */
@@ -0,0 +1,107 @@
+
+
+#include "buffer_pool_set.h"
+#include <assert.h>
+#include <limits>
+
+SMILE_NS_BEGIN
+
+BufferPoolSet::BufferPoolSet() noexcept {
+}
+
+BufferPoolSet::~BufferPoolSet() noexcept {
+  assert(m_bufferPools.empty() && "BufferPoolSet destroyed without closing it");
+}
+
+ErrorCode BufferPoolSet::open( const std::vector<BufferPoolConfig>& bpConfigs,
+                               const std::string& path ) noexcept {
+  assert(m_bufferPools.empty() && "BufferPoolSet is already opened");
+  assert(!bpConfigs.empty() && bpConfigs.size() <= std::numeric_limits<pageSizeClass_t>::max() && "Invalid number of page size classes");
+
+  for (pageSizeClass_t i = 0; i < bpConfigs.size(); ++i) {
+    std::unique_ptr<BufferPool> bufferPool = std::make_unique<BufferPool>();
+    ErrorCode err = bufferPool->open(bpConfigs[i], getClassPath(path, i));
+    if (err != ErrorCode::E_NO_ERROR) {
+      close();
+      return err;
+    }
+    BufferPoolStatistics stats;
+    bufferPool->getStatistics(&stats);
+    m_pageSizes.push_back(stats.m_pageSize);
+    m_bufferPools.push_back(std::move(bufferPool));
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BufferPoolSet::create( const std::vector<PageSizeClassConfig>& classes,
+                                 const std::string& path,
+                                 const bool& overwrite ) noexcept {
+  assert(m_bufferPools.empty() && "BufferPoolSet is already opened");
+  assert(!classes.empty() && classes.size() <= std::numeric_limits<pageSizeClass_t>::max() && "Invalid number of page size classes");
+
+  for (pageSizeClass_t i = 0; i < classes.size(); ++i) {
+    std::unique_ptr<BufferPool> bufferPool = std::make_unique<BufferPool>();
+    ErrorCode err = bufferPool->create(classes[i].m_bufferPoolConfig, 
+                                       getClassPath(path, i), 
+                                       classes[i].m_storageConfig, 
+                                       overwrite);
+    if (err != ErrorCode::E_NO_ERROR) {
+      close();
+      return err;
+    }
+    m_pageSizes.push_back(classes[i].m_storageConfig.m_pageSizeKB*1024);
+    m_bufferPools.push_back(std::move(bufferPool));
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode BufferPoolSet::close() noexcept {
+  ErrorCode result = ErrorCode::E_NO_ERROR;
+  for (auto& bufferPool : m_bufferPools) {
+    ErrorCode err = bufferPool->close();
+    if (result == ErrorCode::E_NO_ERROR) {
+      result = err;
+    }
+  }
+  m_bufferPools.clear();
+  m_pageSizes.clear();
+  return result;
+}
+
+ErrorCode BufferPoolSet::checkpoint() noexcept {
+  assert(!m_bufferPools.empty() && "BufferPoolSet is not opened");
+
+  // Every class is checkpointed even if a previous one failed
+  ErrorCode result = ErrorCode::E_NO_ERROR;
+  for (auto& bufferPool : m_bufferPools) {
+    ErrorCode err = bufferPool->checkpoint();
+    if (result == ErrorCode::E_NO_ERROR) {
+      result = err;
+    }
+  }
+  return result;
+}
+
+BufferPool* BufferPoolSet::getBufferPool( pageSizeClass_t sizeClass ) noexcept {
+  assert(sizeClass < m_bufferPools.size() && "Invalid page size class");
+  return m_bufferPools[sizeClass].get();
+}
+
+pageSizeClass_t BufferPoolSet::getNumClasses() const noexcept {
+  return m_bufferPools.size();
+}
+
+size_t BufferPoolSet::getPageSize( pageSizeClass_t sizeClass ) const noexcept {
+  assert(sizeClass < m_pageSizes.size() && "Invalid page size class");
+  return m_pageSizes[sizeClass];
+}
+
+std::string BufferPoolSet::getClassPath( const std::string& path,
+                                         pageSizeClass_t sizeClass ) noexcept {
+  if (sizeClass == 0) {
+    return path;
+  }
+  return path + ".class" + std::to_string(sizeClass);
+}
+
+SMILE_NS_END
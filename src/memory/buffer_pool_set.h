@@ -0,0 +1,131 @@
+#ifndef _MEMORY_BUFFER_POOL_SET_H_
+#define _MEMORY_BUFFER_POOL_SET_H_
+
+#include "buffer_pool.h"
+#include "types.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Configuration of a page size class of a BufferPoolSet.
+ */
+struct PageSizeClassConfig {
+    /**
+     * The configuration of the storage of the class, which sets the page
+     * size of the class.
+     */
+    FileStorageConfig m_storageConfig;
+
+    /**
+     * The configuration of the Buffer Pool of the class. Its pool size is
+     * the memory devoted to pages of the class.
+     */
+    BufferPoolConfig  m_bufferPoolConfig;
+};
+
+/**
+ * A database whose pages come in several sizes, for instance small pages
+ * for index nodes looked up at random and large pages for bulk scans. Each
+ * page size class keeps its pages in its own storage, and caches them in
+ * its own Buffer Pool, with its own frames. Pages are identified by their
+ * class and their pageId_t in it. Class 0 is stored at the path of the
+ * database, and class i at <path>.class<i>.
+ */
+class BufferPoolSet final {
+
+  public:
+    SMILE_NOT_COPYABLE(BufferPoolSet);
+
+    BufferPoolSet() noexcept;
+
+    ~BufferPoolSet() noexcept;
+
+    /**
+     * Opens the Buffer Pools of the classes of the database at the given
+     * path.
+     * 
+     * @param bpConfigs The configuration of the Buffer Pool of each class.
+     * @param path The path to the database.
+     * @return false if all the classes were opened correctly.
+     **/
+    ErrorCode open( const std::vector<BufferPoolConfig>& bpConfigs,
+                    const std::string& path ) noexcept;
+
+    /**
+     * Creates a database with the given page size classes at the given path.
+     * 
+     * @param classes The configuration of each class.
+     * @param path The path to the database.
+     * @param overwrite Whether to replace an existing database.
+     * @return false if all the classes were created correctly.
+     **/
+    ErrorCode create( const std::vector<PageSizeClassConfig>& classes,
+                      const std::string& path,
+                      const bool& overwrite = false ) noexcept;
+
+    /**
+     * Closes the Buffer Pools of all the classes.
+     * 
+     * @return false if all the classes were closed correctly.
+     **/
+    ErrorCode close() noexcept;
+
+    /**
+     * Checkpoints the Buffer Pools of all the classes.
+     * 
+     * @return false if all the classes were checkpointed correctly.
+     **/
+    ErrorCode checkpoint() noexcept;
+
+    /**
+     * Gets the Buffer Pool of a page size class.
+     * 
+     * @param sizeClass The page size class.
+     * @return The Buffer Pool of the class.
+     **/
+    BufferPool* getBufferPool( pageSizeClass_t sizeClass ) noexcept;
+
+    /**
+     * Gets the number of page size classes.
+     * 
+     * @return The number of classes.
+     **/
+    pageSizeClass_t getNumClasses() const noexcept;
+
+    /**
+     * Gets the page size of a class.
+     * 
+     * @param sizeClass The page size class.
+     * @return The page size in bytes.
+     **/
+    size_t getPageSize( pageSizeClass_t sizeClass ) const noexcept;
+
+    /**
+     * Gets the path to the storage of a page size class.
+     * 
+     * @param path The path to the database.
+     * @param sizeClass The page size class.
+     * @return The path to the storage of the class.
+     **/
+    static std::string getClassPath( const std::string& path,
+                                     pageSizeClass_t sizeClass ) noexcept;
+
+  private:
+
+    /**
+     * The Buffer Pool of each class.
+     */
+    std::vector<std::unique_ptr<BufferPool>> m_bufferPools;
+
+    /**
+     * The page size in bytes of each class.
+     */
+    std::vector<size_t> m_pageSizes;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _MEMORY_BUFFER_POOL_SET_H_ */
@@ -0,0 +1,126 @@
+
+
+#include "page_table.h"
+#include <assert.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Marks free slots
+ */
+#define EMPTY_SLOT INVALID_PAGE_ID
+
+/**
+ * Marks slots being written
+ */
+#define BUSY_SLOT (INVALID_PAGE_ID - 1)
+
+PageTable::PageTable() noexcept :
+p_slots{nullptr},
+m_mask{0},
+m_size{0} {
+}
+
+void PageTable::init( size_t maxEntries ) noexcept {
+  // At most half of the slots are used, which keeps probe sequences short
+  size_t numSlots = 8;
+  while (numSlots < 2*maxEntries) {
+    numSlots *= 2;
+  }
+  p_slots.reset(new Slot[numSlots]);
+  for (size_t i = 0; i < numSlots; ++i) {
+    p_slots[i].m_pageId.store(EMPTY_SLOT, std::memory_order_relaxed);
+    p_slots[i].m_bufferId.store(0, std::memory_order_relaxed);
+  }
+  m_mask = numSlots - 1;
+  m_size = 0;
+}
+
+bool PageTable::find( const pageId_t& pId, 
+                      bufferId_t* bId ) const noexcept {
+  // Probes are bounded, as concurrent updates may move the page around
+  for (size_t i = home(pId), probes = 0; probes <= m_mask; i = (i+1) & m_mask, ++probes) {
+    pageId_t current = p_slots[i].m_pageId.load(std::memory_order_acquire);
+    if (current == EMPTY_SLOT) {
+      return false;
+    }
+    if (current == pId) {
+      // The buffer belongs to the page only if the slot was not rewritten
+      // while it was read
+      bufferId_t buffer = p_slots[i].m_bufferId.load(std::memory_order_acquire);
+      if (p_slots[i].m_pageId.load(std::memory_order_relaxed) == pId) {
+        *bId = buffer;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void PageTable::insert( const pageId_t& pId, 
+                        bufferId_t bId ) noexcept {
+  assert(m_size <= m_mask/2 && "Page table is full");
+  size_t i = home(pId);
+  while (p_slots[i].m_pageId.load(std::memory_order_relaxed) != EMPTY_SLOT) {
+    assert(p_slots[i].m_pageId.load(std::memory_order_relaxed) != pId && "Page already in the table");
+    i = (i+1) & m_mask;
+  }
+  store(i, pId, bId);
+  ++m_size;
+}
+
+bool PageTable::erase( const pageId_t& pId ) noexcept {
+  size_t i = home(pId);
+  while (true) {
+    pageId_t current = p_slots[i].m_pageId.load(std::memory_order_relaxed);
+    if (current == EMPTY_SLOT) {
+      return false;
+    }
+    if (current == pId) {
+      break;
+    }
+    i = (i+1) & m_mask;
+  }
+
+  // The following entries of the probe sequence are shifted back to fill
+  // the hole, so that no tombstones are left behind and lookups of missing
+  // pages stop at the first empty slot
+  size_t j = i;
+  while (true) {
+    j = (j+1) & m_mask;
+    pageId_t current = p_slots[j].m_pageId.load(std::memory_order_relaxed);
+    if (current == EMPTY_SLOT) {
+      break;
+    }
+    // Entries whose home lies cyclically in (i, j] stay where they are
+    size_t k = home(current);
+    if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+      continue;
+    }
+    store(i, current, p_slots[j].m_bufferId.load(std::memory_order_relaxed));
+    i = j;
+  }
+  p_slots[i].m_pageId.store(EMPTY_SLOT, std::memory_order_release);
+  --m_size;
+  return true;
+}
+
+size_t PageTable::size() const noexcept {
+  return m_size;
+}
+
+size_t PageTable::home( const pageId_t& pId ) const noexcept {
+  // Fibonacci hashing spreads the pages of a partition, which are strided
+  // by the number of partitions
+  return (pId * 0x9E3779B97F4A7C15ULL) >> 32 & m_mask;
+}
+
+void PageTable::store( size_t slot, 
+                       const pageId_t& pId, 
+                       bufferId_t bId ) noexcept {
+  p_slots[slot].m_pageId.store(BUSY_SLOT, std::memory_order_relaxed);
+  p_slots[slot].m_bufferId.store(bId, std::memory_order_release);
+  p_slots[slot].m_pageId.store(pId, std::memory_order_release);
+}
+
+SMILE_NS_END
@@ -0,0 +1,123 @@
+#ifndef _MEMORY_PAGE_TABLE_H_
+#define _MEMORY_PAGE_TABLE_H_
+
+#include "../base/platform.h"
+#include "../storage/types.h"
+#include "types.h"
+#include <atomic>
+#include <memory>
+
+SMILE_NS_BEGIN
+
+/**
+ * Open-addressing hash table mapping the pages loaded in a partition of the
+ * Buffer Pool to their buffers. Lookups take no lock and may run
+ * concurrently with updates, which must be serialized by the caller. Since
+ * an update may move entries around, a lookup running concurrently may miss
+ * a page in the table or, very rarely, return a buffer the page has just
+ * left, so lookups must be confirmed against the buffer and repeated under
+ * the lock serializing updates when they fail.
+ */
+class PageTable final {
+  public:
+    SMILE_NOT_COPYABLE(PageTable);
+
+    PageTable() noexcept;
+
+    PageTable( PageTable&& other ) noexcept = default;
+
+    PageTable& operator=( PageTable&& other ) noexcept = default;
+
+    ~PageTable() noexcept = default;
+
+    /**
+     * Sizes the table for a maximum number of entries and empties it
+     * 
+     * @param maxEntries The maximum number of pages in the table at once.
+     */
+    void init( size_t maxEntries ) noexcept;
+
+    /**
+     * Looks up the buffer of a page without taking any lock
+     * 
+     * @param pId The page to look up.
+     * @param bId Set to the buffer of the page, if found.
+     * @return true if the page was found, false otherwise.
+     */
+    bool find( const pageId_t& pId, 
+               bufferId_t* bId ) const noexcept;
+
+    /**
+     * Adds a page that is not in the table yet
+     * 
+     * @param pId The page to add.
+     * @param bId The buffer of the page.
+     */
+    void insert( const pageId_t& pId, 
+                 bufferId_t bId ) noexcept;
+
+    /**
+     * Removes a page from the table
+     * 
+     * @param pId The page to remove.
+     * @return true if the page was in the table, false otherwise.
+     */
+    bool erase( const pageId_t& pId ) noexcept;
+
+    /**
+     * Gets the number of pages in the table
+     * 
+     * @return The number of pages.
+     */
+    size_t size() const noexcept;
+
+  private:
+
+    /**
+     * An entry of the table. Writers mark the page as busy while they
+     * update the buffer, so that readers never pair a page with the buffer
+     * of another one.
+     */
+    struct Slot {
+        std::atomic<pageId_t>   m_pageId;
+        std::atomic<bufferId_t> m_bufferId;
+    };
+
+    /**
+     * Gets the slot a page is looked up from
+     * 
+     * @param pId The page.
+     * @return The index of the slot.
+     */
+    size_t home( const pageId_t& pId ) const noexcept;
+
+    /**
+     * Writes an entry to a slot
+     * 
+     * @param slot The index of the slot.
+     * @param pId The page of the entry.
+     * @param bId The buffer of the entry.
+     */
+    void store( size_t slot, 
+                const pageId_t& pId, 
+                bufferId_t bId ) noexcept;
+
+    /**
+     * The slots of the table. Their number is a power of two.
+     */
+    std::unique_ptr<Slot[]> p_slots;
+
+    /**
+     * The number of slots minus one.
+     */
+    size_t m_mask;
+
+    /**
+     * The number of pages in the table.
+     */
+    size_t m_size;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _MEMORY_PAGE_TABLE_H_ */
@@ -0,0 +1,253 @@
+
+#include "prefetcher.h"
+#include <algorithm>
+#include <assert.h>
+#include <cstdlib>
+
+SMILE_NS_BEGIN
+
+/**
+ * Used to give every prefetcher a distinct id
+ */
+static std::atomic<uint64_t> nextPrefetcherId(0);
+
+/**
+ * Maximum number of prefetchers a thread keeps its streams cached for.
+ * Entries of destroyed prefetchers are dropped when the cache is full.
+ */
+#define CACHED_PREFETCHERS 16
+
+/**
+ * Tells whether a page has been reached by a stream going in the direction
+ * of its stride
+ */
+static bool reached( int64_t position,
+                     int64_t page,
+                     int64_t stride ) noexcept {
+  int64_t distance = position - page;
+  return stride > 0 ? distance >= 0 : distance <= 0;
+}
+
+Prefetcher::Prefetcher() noexcept :
+m_id(nextPrefetcherId.fetch_add(1)),
+m_maxWindow(0),
+m_maxRequested(0),
+m_stop(false),
+m_numRequested(0),
+m_started(false)
+{
+}
+
+Prefetcher::~Prefetcher() noexcept {
+  assert(!m_started && "Prefetcher destroyed without stopping it");
+}
+
+void Prefetcher::start( uint32_t maxWindow,
+                        uint32_t maxRequested,
+                        LoadFunction load ) noexcept {
+  assert(!m_started && "Prefetcher already started");
+
+  // Streams are only reset while no thread accesses pages, as every thread
+  // updates its own without locking them
+  {
+    std::lock_guard<std::mutex> guard(m_streamsLock);
+    for (const auto& entry : m_streams) {
+      *entry.second = Streams{};
+    }
+  }
+
+  m_maxWindow     = maxWindow;
+  m_maxRequested  = std::max<uint32_t>(maxRequested, 1);
+  m_load          = std::move(load);
+  m_stop          = false;
+  m_numRequested  = 0;
+  m_thread        = std::thread(&Prefetcher::prefetchLoop, this);
+  m_started       = true;
+}
+
+void Prefetcher::stop() noexcept {
+  assert(m_started && "Prefetcher not started");
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stop = true;
+  }
+  m_condition.notify_one();
+  m_thread.join();
+
+  m_queue.clear();
+  m_requested.clear();
+  m_load = nullptr;
+  m_started = false;
+}
+
+bool Prefetcher::isStarted() const noexcept {
+  return m_started;
+}
+
+void Prefetcher::access( const pageId_t& pId,
+                         uint64_t numPages,
+                         const SkipFunction& skip ) noexcept {
+  assert(m_started && "Prefetcher not started");
+
+  Stream* stream = follow(local(), pId);
+  if (stream == nullptr || stream->m_hits < PREFETCH_TRAINING_ACCESSES) {
+    return;
+  }
+
+  // The window grows whenever the stream reaches the pages requested by its
+  // last growth, as they have proven useful
+  int64_t stride = stream->m_stride;
+  int64_t position = static_cast<int64_t>(pId);
+  if (stream->m_window == 0) {
+    stream->m_window = std::min<uint32_t>(PREFETCH_INITIAL_WINDOW, m_maxWindow);
+    stream->m_nextPage = position + stride;
+    stream->m_markPage = stream->m_nextPage;
+  }
+  else if (reached(position, stream->m_markPage, stride)) {
+    stream->m_window = std::min<uint32_t>(stream->m_window*2, m_maxWindow);
+    stream->m_markPage = stream->m_nextPage;
+  }
+  if (reached(position, stream->m_nextPage, stride)) {
+    stream->m_nextPage = position + stride;
+  }
+
+  int64_t lastPage = position + stride*stream->m_window;
+  if (!reached(lastPage, stream->m_nextPage, stride)) {
+    return;
+  }
+
+  // Pages that do not fit in the requests in flight are left to the next
+  // access, so the stream does not skip them
+  uint32_t requested = 0;
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    int64_t& page = stream->m_nextPage;
+    while (reached(lastPage, page, stride) &&
+           page >= 0 &&
+           static_cast<uint64_t>(page) < numPages &&
+           m_requested.size() < m_maxRequested) {
+      pageId_t candidate = static_cast<pageId_t>(page);
+      if (!skip(candidate) && m_requested.insert(candidate).second) {
+        m_queue.push_back(candidate);
+        ++requested;
+      }
+      page += stride;
+    }
+  }
+  if (requested > 0) {
+    m_numRequested.fetch_add(requested, std::memory_order_relaxed);
+    m_condition.notify_one();
+  }
+}
+
+uint64_t Prefetcher::getNumRequested() const noexcept {
+  return m_numRequested.load(std::memory_order_relaxed);
+}
+
+Prefetcher::Streams* Prefetcher::local() noexcept {
+  static thread_local std::vector<std::pair<uint64_t, Streams*>> cache;
+  for (const auto& entry : cache) {
+    if (entry.first == m_id) {
+      return entry.second;
+    }
+  }
+
+  // First access of the thread, or its cache entry was dropped
+  std::lock_guard<std::mutex> guard(m_streamsLock);
+  std::thread::id thread = std::this_thread::get_id();
+  auto it = std::find_if(m_streams.begin(), m_streams.end(),
+                         [thread] (const auto& entry) { return entry.first == thread; });
+  if (it == m_streams.end()) {
+    m_streams.push_back(std::make_pair(thread, std::make_unique<Streams>()));
+    it = m_streams.end() - 1;
+  }
+  if (cache.size() == CACHED_PREFETCHERS) {
+    cache.clear();
+  }
+  cache.push_back(std::make_pair(m_id, it->second.get()));
+  return it->second.get();
+}
+
+Prefetcher::Stream* Prefetcher::follow( Streams* streams,
+                                        const pageId_t& pId ) noexcept {
+  uint64_t now = ++streams->m_clock;
+
+  // Streams with a stride are looked at first, so that the accesses of a
+  // trained stream are not taken by a new stream close to it. Accesses may
+  // skip a few pages of the stream, such as the protected ones in a scan, as
+  // long as they stay within its window.
+  for (Stream& stream : streams->m_streams) {
+    if (stream.m_lastUse == 0 || stream.m_stride == 0) {
+      continue;
+    }
+    int64_t distance = static_cast<int64_t>(pId) - static_cast<int64_t>(stream.m_lastPage);
+    if (distance == 0) {
+      stream.m_lastUse = now;
+      return nullptr;
+    }
+    int64_t strides = distance / stream.m_stride;
+    if (distance % stream.m_stride == 0 &&
+        strides >= 1 &&
+        strides <= std::max<int64_t>(stream.m_window, 1) + 1) {
+      ++stream.m_hits;
+      stream.m_lastPage = pId;
+      stream.m_lastUse = now;
+      return &stream;
+    }
+  }
+
+  // The second access of a stream sets its stride
+  Stream* victim = nullptr;
+  for (Stream& stream : streams->m_streams) {
+    if (stream.m_lastUse != 0 && stream.m_stride == 0) {
+      int64_t distance = static_cast<int64_t>(pId) - static_cast<int64_t>(stream.m_lastPage);
+      if (distance == 0) {
+        stream.m_lastUse = now;
+        return nullptr;
+      }
+      if (std::abs(distance) <= PREFETCH_MAX_STRIDE) {
+        stream.m_stride = distance;
+        stream.m_lastPage = pId;
+        stream.m_lastUse = now;
+        return &stream;
+      }
+    }
+    if (victim == nullptr || stream.m_lastUse < victim->m_lastUse) {
+      victim = &stream;
+    }
+  }
+
+  // The access starts a new stream, in place of the least recently used one
+  *victim = Stream{pId, 0, 0, 0, 0, 0, now};
+  return nullptr;
+}
+
+void Prefetcher::prefetchLoop() noexcept {
+  std::vector<pageId_t> batch;
+  batch.reserve(PREFETCH_BATCH_PAGES);
+  std::unique_lock<std::mutex> guard(m_lock);
+  while (true) {
+    m_condition.wait(guard, [this] { return m_stop || !m_queue.empty(); });
+    if (m_stop) {
+      break;
+    }
+
+    while (!m_queue.empty() && batch.size() < PREFETCH_BATCH_PAGES) {
+      batch.push_back(m_queue.front());
+      m_queue.pop_front();
+    }
+    guard.unlock();
+
+    // Sorted pages let the load merge contiguous ones into single requests
+    std::sort(batch.begin(), batch.end());
+    m_load(batch.data(), batch.size());
+
+    guard.lock();
+    for (const pageId_t& pId : batch) {
+      m_requested.erase(pId);
+    }
+    batch.clear();
+  }
+}
+
+SMILE_NS_END
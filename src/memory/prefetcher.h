@@ -0,0 +1,240 @@
+
+#ifndef _MEMORY_PREFETCHER_H_
+#define _MEMORY_PREFETCHER_H_
+
+#include "../base/platform.h"
+#include "../storage/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Number of streams tracked per thread. Threads following more streams at
+ * once replace the least recently used one.
+ */
+#define PREFETCH_STREAMS 8
+
+/**
+ * Maximum distance in pages between two accesses for them to be taken as
+ * part of the same strided stream.
+ */
+#define PREFETCH_MAX_STRIDE 64
+
+/**
+ * Number of accesses following the stride of a stream, after the first two
+ * that set it, before its pages start being prefetched.
+ */
+#define PREFETCH_TRAINING_ACCESSES 1
+
+/**
+ * Size in pages of the first prefetch window of a stream.
+ */
+#define PREFETCH_INITIAL_WINDOW 4
+
+/**
+ * Maximum number of pages handed at once to the load function.
+ */
+#define PREFETCH_BATCH_PAGES 64
+
+/**
+ * Detects sequential and strided streams in the pages accessed by every
+ * thread, and loads the pages ahead of them from a background thread. The
+ * window of pages prefetched ahead of a stream starts small and doubles
+ * every time the stream reaches the pages prefetched by the last growth, as
+ * Linux read-ahead does, up to a maximum. Pages already requested are not
+ * requested again, and requests beyond a maximum number in flight are
+ * dropped until earlier ones complete.
+ */
+class Prefetcher final {
+  public:
+    SMILE_NOT_COPYABLE(Prefetcher)
+
+    /**
+     * Loads a set of pages, sorted and without duplicates, into the Buffer
+     * Pool. Pages that are already loaded must be skipped.
+     */
+    using LoadFunction = std::function<void (const pageId_t* pIds, uint32_t numPages)>;
+
+    /**
+     * Tells whether a page does not need to be prefetched.
+     */
+    using SkipFunction = std::function<bool (const pageId_t& pId)>;
+
+    Prefetcher() noexcept;
+
+    ~Prefetcher() noexcept;
+
+    /**
+     * Forgets the streams of every thread and starts the background thread
+     * @param in maxWindow The maximum number of pages prefetched ahead of a
+     * stream
+     * @param in maxRequested The maximum number of pages requested and not
+     * loaded yet
+     * @param in load The function loading the requested pages
+     **/
+    void start( uint32_t maxWindow,
+                uint32_t maxRequested,
+                LoadFunction load ) noexcept;
+
+    /**
+     * Discards the pending requests and stops the background thread, once
+     * the pages it is loading are loaded
+     **/
+    void stop() noexcept;
+
+    /**
+     * Tells whether the background thread is running
+     * @return true if started, false otherwise
+     **/
+    bool isStarted() const noexcept;
+
+    /**
+     * Records an access of the calling thread, requesting the pages that
+     * enter the window of its stream, if any
+     * @param in pId The page accessed
+     * @param in numPages The number of pages of the storage, which bounds
+     * the pages requested
+     * @param in skip Tells the pages that are not worth requesting, such as
+     * those already loaded
+     **/
+    void access( const pageId_t& pId,
+                 uint64_t numPages,
+                 const SkipFunction& skip ) noexcept;
+
+    /**
+     * Gets the number of pages requested since the prefetcher was started
+     * @return The number of pages requested
+     **/
+    uint64_t getNumRequested() const noexcept;
+
+  private:
+
+    /**
+     * A sequence of accesses of a thread separated by a constant stride.
+     */
+    struct Stream {
+      /**
+       * The last page accessed
+       */
+      pageId_t  m_lastPage;
+
+      /**
+       * Distance between consecutive accesses, 0 until the second one
+       */
+      int64_t   m_stride;
+
+      /**
+       * Accesses that followed the stride after it was set
+       */
+      uint32_t  m_hits;
+
+      /**
+       * Number of strides prefetched ahead of the last access, 0 until the
+       * stream is trained
+       */
+      uint32_t  m_window;
+
+      /**
+       * The next page to request
+       */
+      int64_t   m_nextPage;
+
+      /**
+       * The first page requested when the window last grew, which grows it
+       * again once accessed
+       */
+      int64_t   m_markPage;
+
+      /**
+       * Access clock of the thread when the stream was last accessed, 0 for
+       * unused streams
+       */
+      uint64_t  m_lastUse;
+    };
+
+    /**
+     * The streams of a thread, which only that thread accesses
+     */
+    struct Streams {
+      Stream    m_streams[PREFETCH_STREAMS];
+      uint64_t  m_clock;
+    };
+
+    /**
+     * Gets the streams of the calling thread, creating them on its first
+     * access
+     **/
+    Streams* local() noexcept;
+
+    /**
+     * Finds the stream an access belongs to, or starts a new one
+     * @param in streams The streams of the thread
+     * @param in pId The page accessed
+     * @return The stream of the access if it follows its stride, nullptr
+     * otherwise
+     **/
+    Stream* follow( Streams* streams,
+                    const pageId_t& pId ) noexcept;
+
+    /**
+     * Body of the background thread
+     **/
+    void prefetchLoop() noexcept;
+
+    // Identifies the prefetcher in the per thread caches. Ids are never
+    // reused, so cached entries of destroyed prefetchers are never matched.
+    uint64_t                    m_id;
+
+    // The maximum number of pages prefetched ahead of a stream
+    uint32_t                    m_maxWindow;
+
+    // The maximum number of pages requested and not loaded yet
+    uint32_t                    m_maxRequested;
+
+    // The function loading the requested pages
+    LoadFunction                m_load;
+
+    // Protects the list of streams
+    std::mutex                  m_streamsLock;
+
+    // The streams of every thread that accessed pages, with the thread
+    // they belong to
+    std::vector<std::pair<std::thread::id, std::unique_ptr<Streams>>> m_streams;
+
+    // The background thread
+    std::thread                 m_thread;
+
+    // Protects the requests below
+    std::mutex                  m_lock;
+
+    // Wakes up the background thread when there are requests or it has to
+    // finish
+    std::condition_variable     m_condition;
+
+    // Requested pages that the background thread has not taken yet
+    std::deque<pageId_t>        m_queue;
+
+    // Requested pages that are not loaded yet, either queued or being loaded
+    std::unordered_set<pageId_t> m_requested;
+
+    // Tells the background thread to finish
+    bool                        m_stop;
+
+    // Number of pages requested since the prefetcher was started
+    std::atomic<uint64_t>       m_numRequested;
+
+    // Whether the background thread is running
+    bool                        m_started;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _MEMORY_PREFETCHER_H_ */
@@ -10,6 +10,9 @@ SMILE_NS_BEGIN
 
 using bufferId_t = uint64_t;
 using transactionId_t = uint64_t;
+using pageSizeClass_t = uint8_t;
+
+#define INVALID_BUFFER_ID 0xffffffffffffffff
 
 SMILE_NS_END
 
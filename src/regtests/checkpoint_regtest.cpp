@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <memory/buffer_pool.h>
+#include <chrono>
+#include <cstdio>
+
+SMILE_NS_BEGIN
+
+#define PAGE_SIZE_KB 64
+#define POOL_KB (32*1024)
+#define DATA_KB (256*1024)
+#define CHECKPOINT_KB (64*1024)
+
+/**
+ * Writes DATA_KB of new pages through a Buffer Pool smaller than them, so
+ * that most pages reach the kernel cache when they are evicted, and
+ * checkpoints every CHECKPOINT_KB. Checkpoints sync the storage, as the
+ * double-write buffer is enabled.
+ * @param in writeBackIntervalMs The period of the background write-back
+ * @param out maxMs The longest checkpoint
+ * @return The time spent in checkpoints
+ **/
+static uint64_t runCheckpoints( uint32_t writeBackIntervalMs,
+                                uint64_t* maxMs ) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = POOL_KB;
+  bpConfig.m_doubleWrite = true;
+  bpConfig.m_writeBackIntervalMs = writeBackIntervalMs;
+  EXPECT_TRUE(bufferPool.create(bpConfig, "./checkpoint.db", FileStorageConfig{PAGE_SIZE_KB}, true) == ErrorCode::E_NO_ERROR);
+
+  uint64_t totalMs = 0;
+  *maxMs = 0;
+  BufferHandler bufferHandler;
+  for (uint64_t i = 1; i <= DATA_KB / PAGE_SIZE_KB; ++i) {
+    EXPECT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'a' + i%26, PAGE_SIZE_KB*1024);
+    EXPECT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    EXPECT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    if (i % (CHECKPOINT_KB / PAGE_SIZE_KB) == 0) {
+      std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+      EXPECT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+      std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+      uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+      totalMs += ms;
+      *maxMs = std::max(*maxMs, ms);
+    }
+  }
+  EXPECT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  std::remove("./checkpoint.db");
+  std::remove("./checkpoint.db.config");
+  std::remove("./checkpoint.db.dwb");
+  return totalMs;
+}
+
+/**
+ * Compares the checkpoints of a pool that leaves evicted pages in the kernel
+ * cache until the checkpoint syncs them against those of a pool that pushes
+ * them to the device in the background.
+ */
+TEST(PerformanceTest, PerformanceTestCheckpointWriteBack) {
+  uint64_t maxMs;
+  uint64_t totalMs = runCheckpoints(0, &maxMs);
+  std::cout << "Without write-back: " << totalMs << " ms in checkpoints, longest " << maxMs << " ms" << std::endl;
+  totalMs = runCheckpoints(10, &maxMs);
+  std::cout << "With write-back every 10 ms: " << totalMs << " ms in checkpoints, longest " << maxMs << " ms" << std::endl;
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <memory/buffer_pool.h>
+#include <storage/checksum.h>
+#include <tasking/tasking.h>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+SMILE_NS_BEGIN
+
+#define PAGE_SIZE_KB 64
+#define DATA_KB (1024*1024)
+#define NUM_SCANS 5
+
+/**
+ * Creates a storage with DATA_KB of data and returns its pages
+ */
+static std::vector<pageId_t> createStorage( const std::string& path, 
+                                            bool checksums ) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*1024;
+  FileStorageConfig fsConfig;
+  fsConfig.m_pageSizeKB = PAGE_SIZE_KB;
+  fsConfig.m_checksums = checksums;
+  std::vector<pageId_t> pages;
+  if (bufferPool.create(bpConfig, path, fsConfig, true) != ErrorCode::E_NO_ERROR) {
+    return pages;
+  }
+  BufferHandler bufferHandler;
+  for (uint64_t i = 0; i < DATA_KB; i += PAGE_SIZE_KB) {
+    bufferPool.alloc(&bufferHandler);
+    bufferPool.setPageDirty(bufferHandler.m_pId);
+    memset(bufferHandler.m_buffer, static_cast<char>(i), PAGE_SIZE_KB*1024);
+    pages.push_back(bufferHandler.m_pId);
+    bufferPool.unpin(bufferHandler);
+  }
+  bufferPool.close();
+  return pages;
+}
+
+/**
+ * Scans the given pages through a Buffer Pool smaller than the data, and
+ * returns the elapsed time in milliseconds
+ */
+static uint64_t scan( const std::string& path, 
+                      const std::vector<pageId_t>& pages ) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 256*1024;
+  bpConfig.m_prefetchingDegree = 0;
+  bufferPool.open(bpConfig, path);
+  BufferHandler bufferHandler;
+  std::vector<uint64_t> dummy(PAGE_SIZE_KB*1024*8/64);
+
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (pageId_t page : pages) {
+    EXPECT_TRUE(bufferPool.pin(page, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    memcpy(&dummy[0], bufferHandler.m_buffer, PAGE_SIZE_KB*1024);
+    bufferPool.unpin(bufferHandler);
+  }
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  bufferPool.close();
+  return std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+}
+
+/**
+ * Measures the cost of verifying page checksums, comparing a scan over a
+ * storage with checksums against the same scan over one without them.
+ */
+TEST(PerformanceTest, PerformanceTestChecksumOverhead) {
+  startThreadPool(1);
+
+  std::vector<char> page(PAGE_SIZE_KB*1024, 'x');
+  uint32_t crc = 0;
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (uint64_t i = 0; i < DATA_KB; i += PAGE_SIZE_KB) {
+    crc ^= computeCRC32C(page.data(), page.size());
+  }
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  uint64_t crcMs = std::max<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count(), 1);
+  std::cout << "CRC32C (" << (isCRC32CAccelerated() ? "SSE4.2" : "portable") << "): " << crcMs << " ms (" 
+            << DATA_KB/1024*1000/crcMs << " MB/s) " << crc << std::endl;
+
+  std::vector<pageId_t> plainPages = createStorage("./plain.db", false);
+  std::vector<pageId_t> checksumPages = createStorage("./checksum.db", true);
+  ASSERT_TRUE(plainPages.size() == DATA_KB/PAGE_SIZE_KB && checksumPages == plainPages);
+
+  // The first scans warm up the page cache, so that both files are read
+  // from memory and the difference is only the verification. The scans
+  // then alternate and the fastest of each is kept, to filter out noise.
+  scan("./plain.db", plainPages);
+  scan("./checksum.db", checksumPages);
+  uint64_t plainMs = std::numeric_limits<uint64_t>::max();
+  uint64_t checksumMs = std::numeric_limits<uint64_t>::max();
+  for (uint32_t i = 0; i < NUM_SCANS; ++i) {
+    plainMs = std::min(plainMs, std::max<uint64_t>(scan("./plain.db", plainPages), 1));
+    checksumMs = std::min(checksumMs, scan("./checksum.db", checksumPages));
+  }
+
+  std::cout << "Scan without checksums: " << plainMs << " ms" << std::endl;
+  std::cout << "Scan with checksums: " << checksumMs << " ms (" 
+            << (static_cast<int64_t>(checksumMs) - static_cast<int64_t>(plainMs))*100.0/plainMs << "% overhead)" << std::endl;
+
+  stopThreadPool();
+  std::remove("./plain.db");
+  std::remove("./plain.db.config");
+  std::remove("./checksum.db");
+  std::remove("./checksum.db.config");
+  std::remove("./checksum.db.crc");
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
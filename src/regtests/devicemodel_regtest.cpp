@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <memory/buffer_pool.h>
+#include <tasking/tasking.h>
+#include <chrono>
+#include <random>
+
+SMILE_NS_BEGIN
+
+#define PAGE_SIZE_KB 64
+#define DATA_KB (128*1024)
+#define BATCH_SIZE 16
+#define RANDOM_PINS 256
+
+/**
+ * Fills an in-memory storage behind the given device through a Buffer Pool
+ * smaller than the data, then scans it with batched pins and pins random
+ * pages, reporting the time of both phases.
+ */
+static void runOnDevice( const std::string& name,
+                         const DeviceProfile& profile ) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 32*1024;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_deviceProfile = profile;
+  bpConfig.m_ioQueueDepth = 32;
+  FileStorageConfig fsConfig;
+  fsConfig.m_pageSizeKB = PAGE_SIZE_KB;
+  fsConfig.m_inMemory = true;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./devicemodel.db", fsConfig) == ErrorCode::E_NO_ERROR);
+
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint64_t i = 0; i < DATA_KB; i += PAGE_SIZE_KB) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    bufferPool.setPageDirty(bufferHandler.m_pId);
+    memset(bufferHandler.m_buffer, static_cast<char>(i), PAGE_SIZE_KB*1024);
+    pages.push_back(bufferHandler.m_pId);
+    bufferPool.unpin(bufferHandler);
+  }
+  ASSERT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+
+  std::vector<BufferHandler> handlers(BATCH_SIZE);
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (uint64_t i = 0; i + BATCH_SIZE <= pages.size(); i += BATCH_SIZE) {
+    ASSERT_TRUE(bufferPool.pinBatch(&pages[i], BATCH_SIZE, handlers.data()) == ErrorCode::E_NO_ERROR);
+    for (BufferHandler& handler : handlers) {
+      bufferPool.unpin(handler);
+    }
+  }
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  uint64_t scanMs = std::max<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count(), 1);
+
+  std::mt19937_64 generator(0);
+  t1 = std::chrono::high_resolution_clock::now();
+  for (uint32_t i = 0; i < RANDOM_PINS; ++i) {
+    ASSERT_TRUE(bufferPool.pin(pages[generator() % pages.size()], &bufferHandler) == ErrorCode::E_NO_ERROR);
+    bufferPool.unpin(bufferHandler);
+  }
+  t2 = std::chrono::high_resolution_clock::now();
+  uint64_t randomUs = std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
+
+  std::cout << name << ": scan " << scanMs << " ms (" << DATA_KB/1024*1000/scanMs << " MB/s), " 
+            << RANDOM_PINS << " random pins " << randomUs/1000 << " ms (" << randomUs/RANDOM_PINS << " us/pin)" << std::endl;
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Compares the Buffer Pool over in-memory storages emulating different
+ * devices, which lets its behavior on slow devices be measured without
+ * having them.
+ */
+TEST(PerformanceTest, PerformanceTestDeviceModel) {
+  startThreadPool(1);
+  runOnDevice("Memory", DeviceProfile{});
+  runOnDevice("NVMe", DeviceProfile::nvme());
+  runOnDevice("SATA SSD", DeviceProfile::sataSSD());
+  runOnDevice("HDD", DeviceProfile::hdd());
+  stopThreadPool();
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
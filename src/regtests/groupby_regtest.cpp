@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <memory/buffer_pool.h>
 #include <tasking/tasking.h>
+#include <chrono>
 #include <omp.h>
 #include <unordered_map>
 #include <numa.h>
@@ -9,6 +10,7 @@ SMILE_NS_BEGIN
 
 #define PAGE_SIZE_KB 64
 #define DATA_KB 1*1024*1024
+#define EMULATED_DATA_KB (32*1024)
 #define NUM_THREADS 1
 
 /**
@@ -21,7 +23,7 @@ TEST(PerformanceTest, PerformanceTestGroupBy) {
 		BufferPool bufferPool;
 		BufferPoolConfig bpConfig;
 		bpConfig.m_poolSizeKB = 1024*1024;
-		bpConfig.m_prefetchingDegree = 1;
+		bpConfig.m_prefetchingDegree = 64;
 		bpConfig.m_numberOfPartitions = 16;
 		ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
 
@@ -85,6 +87,66 @@ TEST(PerformanceTest, PerformanceTestGroupBy) {
 	}
 }
 
+/**
+ * Groups the bytes of an in-memory storage behind an emulated SATA SSD,
+ * read through a Buffer Pool smaller than the data.
+ *
+ * @return The time of the Group By in milliseconds.
+ */
+static uint64_t groupByEmulated( uint16_t prefetchingDegree ) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 8*1024;
+  bpConfig.m_prefetchingDegree = prefetchingDegree;
+  bpConfig.m_deviceProfile = DeviceProfile::sataSSD();
+  bpConfig.m_ioQueueDepth = 32;
+  FileStorageConfig fsConfig;
+  fsConfig.m_pageSizeKB = PAGE_SIZE_KB;
+  fsConfig.m_inMemory = true;
+  EXPECT_TRUE(bufferPool.create(bpConfig, "./groupby.db", fsConfig) == ErrorCode::E_NO_ERROR);
+
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint64_t i = 0; i < EMULATED_DATA_KB; i += PAGE_SIZE_KB) {
+    EXPECT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    bufferPool.setPageDirty(bufferHandler.m_pId);
+    for (uint64_t byte = 0; byte < PAGE_SIZE_KB*1024; ++byte) {
+      bufferHandler.m_buffer[byte] = static_cast<char>(byte*i % 251);
+    }
+    pages.push_back(bufferHandler.m_pId);
+    bufferPool.unpin(bufferHandler);
+  }
+  EXPECT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+
+  std::array<uint32_t, 256> occurrences{};
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (pageId_t pId : pages) {
+    EXPECT_TRUE(bufferPool.pin(pId, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    const uint8_t* buffer = reinterpret_cast<const uint8_t*>(bufferHandler.m_buffer);
+    for (uint64_t byte = 0; byte < PAGE_SIZE_KB*1024; ++byte) {
+      ++occurrences[buffer[byte]];
+    }
+    bufferPool.unpin(bufferHandler);
+  }
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  EXPECT_TRUE(occurrences[0] > 0);
+  EXPECT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  return std::max<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count(), 1);
+}
+
+/**
+ * Compares the Group By with and without prefetching over an emulated
+ * device, which needs no data file
+ */
+TEST(PerformanceTest, PerformanceTestGroupByPrefetch) {
+  startThreadPool(1);
+  uint64_t plainMs = groupByEmulated(0);
+  uint64_t prefetchMs = groupByEmulated(64);
+  std::cout << "Group By without prefetching: " << plainMs << " ms, with prefetching: " << prefetchMs 
+            << " ms (speedup " << static_cast<double>(plainMs)/prefetchMs << "x)" << std::endl;
+  stopThreadPool();
+}
+
 SMILE_NS_END
 
 int main(int argc, char* argv[]){
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <storage/file_storage.h>
+#include <storage/sequential_file_storage.h>
+#include <chrono>
+#include <cstdio>
+
+SMILE_NS_BEGIN
+
+#define PAGE_SIZE_KB 64
+#define EXTENT_SIZE_KB (4*1024)
+#define DATA_KB (512*1024)
+
+/**
+ * Compares streaming data to disk through large appends to a
+ * SequentialFileStorage against writing it page by page through the
+ * FileStorage, synchronizing both files at the end.
+ */
+TEST(PerformanceTest, PerformanceTestIngest) {
+  std::vector<char> data(EXTENT_SIZE_KB*1024, 'x');
+
+  SequentialFileStorage sequentialStorage;
+  ISequentialStorage::SequentialStorageConfig config;
+  config.m_extentSizeKB = EXTENT_SIZE_KB;
+  ASSERT_TRUE(sequentialStorage.create("./ingest.seq", config, true) == ErrorCode::E_NO_ERROR);
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (uint64_t i = 0; i < DATA_KB / EXTENT_SIZE_KB; ++i) {
+    extentId_t extent;
+    ASSERT_TRUE(sequentialStorage.append(data.data(), 1, extent) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(sequentialStorage.sync() == ErrorCode::E_NO_ERROR);
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  uint64_t appendMs = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+  ASSERT_TRUE(sequentialStorage.close() == ErrorCode::E_NO_ERROR);
+
+  FileStorage fileStorage;
+  ASSERT_TRUE(fileStorage.create("./ingest.db", FileStorageConfig{PAGE_SIZE_KB}, true) == ErrorCode::E_NO_ERROR);
+  t1 = std::chrono::high_resolution_clock::now();
+  for (uint64_t i = 0; i < DATA_KB / PAGE_SIZE_KB; ++i) {
+    pageId_t pId;
+    ASSERT_TRUE(fileStorage.reserve(1, &pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(fileStorage.write(data.data(), pId) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+  t2 = std::chrono::high_resolution_clock::now();
+  uint64_t pageMs = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+
+  uint64_t totalMB = DATA_KB/1024;
+  std::cout << "Extent appends: " << appendMs << " ms (" << totalMB*1000/std::max<uint64_t>(appendMs,1) << " MB/s)" << std::endl;
+  std::cout << "Page writes: " << pageMs << " ms (" << totalMB*1000/std::max<uint64_t>(pageMs,1) << " MB/s)" << std::endl;
+
+  std::remove("./ingest.seq");
+  std::remove("./ingest.seq.config");
+  std::remove("./ingest.db");
+  std::remove("./ingest.db.config");
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
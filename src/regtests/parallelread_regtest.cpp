@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <memory/buffer_pool.h>
+#include <tasking/tasking.h>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+
+SMILE_NS_BEGIN
+
+#define PAGE_SIZE_KB 64
+#define DATA_KB 256*1024
+#define NUM_THREADS 8
+#define READS_PER_THREAD 2048
+
+/**
+ * Runs the given read function from NUM_THREADS threads, each one reading
+ * READS_PER_THREAD random pages, and returns the elapsed time in milliseconds.
+ */
+template <typename ReadFunction>
+static uint64_t runRandomReads( uint64_t numPages, ReadFunction readPage ) {
+  std::vector<std::thread> threads;
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (uint32_t t = 0; t < NUM_THREADS; ++t) {
+    threads.push_back(std::thread([t, numPages, &readPage] () {
+      std::mt19937_64 generator(t);
+      std::vector<char> data(PAGE_SIZE_KB*1024);
+      for (uint32_t i = 0; i < READS_PER_THREAD; ++i) {
+        pageId_t page = 1 + generator() % (numPages - 1);
+        readPage(data.data(), page);
+      }
+    }));
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+}
+
+/**
+ * Compares the throughput of concurrent random page reads through the
+ * positional FileStorage against a single std::fstream shared by all threads,
+ * which needs a lock around every seek and read to be correct.
+ */
+TEST(PerformanceTest, PerformanceTestParallelStorageRead) {
+  uint64_t numPages = DATA_KB / PAGE_SIZE_KB;
+  FileStorage fileStorage;
+  ASSERT_TRUE(fileStorage.create("./parallelread.db", FileStorageConfig{PAGE_SIZE_KB}, true) == ErrorCode::E_NO_ERROR);
+  pageId_t pId;
+  ASSERT_TRUE(fileStorage.reserve(numPages, &pId) == ErrorCode::E_NO_ERROR);
+  std::vector<char> data(PAGE_SIZE_KB*1024);
+  for (pageId_t i = 0; i < numPages; ++i) {
+    std::fill(data.begin(), data.end(), static_cast<char>(i));
+    ASSERT_TRUE(fileStorage.write(data.data(), i) == ErrorCode::E_NO_ERROR);
+  }
+
+  uint64_t positionalMs = runRandomReads(numPages, [&fileStorage] (char* buffer, pageId_t page) {
+    fileStorage.read(buffer, page);
+  });
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+
+  std::fstream stream("./parallelread.db", std::ios_base::in | std::ios_base::binary);
+  std::mutex streamLock;
+  uint64_t streamMs = runRandomReads(numPages, [&stream, &streamLock] (char* buffer, pageId_t page) {
+    std::lock_guard<std::mutex> guard(streamLock);
+    stream.seekg(page*PAGE_SIZE_KB*1024, std::ios_base::beg);
+    stream.read(buffer, PAGE_SIZE_KB*1024);
+  });
+  stream.close();
+
+  uint64_t totalMB = NUM_THREADS*READS_PER_THREAD*PAGE_SIZE_KB/1024;
+  std::cout << "Positional reads: " << positionalMs << " ms (" << totalMB*1000/std::max<uint64_t>(positionalMs,1) << " MB/s)" << std::endl;
+  std::cout << "Shared fstream reads: " << streamMs << " ms (" << totalMB*1000/std::max<uint64_t>(streamMs,1) << " MB/s)" << std::endl;
+}
+
+/**
+ * Pins random pages from several threads over a Buffer Pool much smaller
+ * than the data, so that almost every pin misses and goes to the storage.
+ */
+TEST(PerformanceTest, PerformanceTestParallelMisses) {
+  if (std::ifstream("./parallelread.db")) {
+    startThreadPool(1);
+
+    BufferPool bufferPool;
+    BufferPoolConfig bpConfig;
+    bpConfig.m_poolSizeKB = 16*1024;
+    bpConfig.m_prefetchingDegree = 0;
+    bpConfig.m_numberOfPartitions = 1;
+    ASSERT_TRUE(bufferPool.open(bpConfig, "./parallelread.db") == ErrorCode::E_NO_ERROR);
+    uint64_t numPages = DATA_KB / PAGE_SIZE_KB;
+
+    uint64_t missesMs = runRandomReads(numPages, [&bufferPool] (char* buffer, pageId_t page) {
+      BufferHandler bufferHandler;
+      bufferPool.pin(page, &bufferHandler);
+      memcpy(buffer, bufferHandler.m_buffer, PAGE_SIZE_KB*1024);
+      bufferPool.unpin(bufferHandler);
+    });
+    std::cout << "Execution time: " << missesMs << std::endl;
+
+    stopThreadPool();
+    ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+    std::remove("./parallelread.db");
+    std::remove("./parallelread.db.config");
+  }
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+#include <memory/buffer_pool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+#define PAGE_SIZE_KB 64
+#define POOL_BUFFERS 256
+#define PINS_PER_THREAD (1024*1024)
+
+/**
+ * Gets the CPUs the process may run on. False sharing only shows when the
+ * threads run at once, so each benchmark thread is bound to one of them.
+ * @return The identifiers of the CPUs
+ **/
+static std::vector<int> getCPUs() {
+  std::vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+/**
+ * Binds the calling thread to a CPU
+ * @param in cpu The CPU to run on
+ **/
+static void bindToCPU( int cpu ) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  EXPECT_TRUE(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0);
+}
+
+/**
+ * Gets the number of threads of the benchmarks, one per CPU up to 16
+ * @return The number of threads, or 0 if there are not two CPUs to run them
+ **/
+static uint32_t getNumThreads() {
+  std::vector<int> cpus = getCPUs();
+  if (cpus.size() < 2) {
+    std::cout << "Only " << cpus.size() << " CPU available: false sharing cannot be measured here" << std::endl;
+    return 0;
+  }
+  return std::min<uint32_t>(cpus.size(), 16);
+}
+
+/**
+ * Pins and unpins a page over and over from each thread, each thread
+ * pinning its own resident page on its own CPU.
+ * @param in bufferPool The Buffer Pool holding the pages
+ * @param in pages The page pinned by each thread
+ * @return The number of pins per second of all the threads together
+ **/
+static double runPins( BufferPool* bufferPool,
+                       const std::vector<pageId_t>& pages ) {
+  std::vector<int> cpus = getCPUs();
+  std::vector<std::thread> threads;
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (uint32_t t = 0; t < pages.size(); ++t) {
+    pageId_t pId = pages[t];
+    int cpu = cpus[t % cpus.size()];
+    threads.emplace_back([bufferPool, pId, cpu] () {
+      bindToCPU(cpu);
+      BufferHandler handler;
+      for (uint32_t i = 0; i < PINS_PER_THREAD; ++i) {
+        EXPECT_TRUE(bufferPool->pin(pId, &handler) == ErrorCode::E_NO_ERROR);
+        EXPECT_TRUE(bufferPool->unpin(handler) == ErrorCode::E_NO_ERROR);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
+  return static_cast<double>(pages.size())*PINS_PER_THREAD / std::max<uint64_t>(us, 1) * 1000000;
+}
+
+/**
+ * The layout of the buffer descriptors before they were aligned to cache
+ * lines, with the same fields packed one after the other.
+ */
+struct PackedDescriptor {
+  std::atomic<uint64_t>   m_state{0};
+  std::atomic<uint64_t>   m_version{0};
+  std::atomic<pageId_t>   m_pageId{0};
+  std::atomic<lsn_t>      m_pageLSN{0};
+  Swip*                   p_swip = nullptr;
+};
+
+/**
+ * Pins and unpins a descriptor over and over as the Buffer Pool does, taking
+ * the header lock to increment the reference count and decrementing it once
+ * the lock is free.
+ * @param in descriptor The descriptor to pin
+ * @param in cpu The CPU to run on
+ **/
+template <typename Descriptor>
+static void pinDescriptor( Descriptor* descriptor,
+                           int cpu ) {
+  bindToCPU(cpu);
+  for (uint32_t i = 0; i < PINS_PER_THREAD; ++i) {
+    uint64_t state = descriptor->m_state.load(std::memory_order_relaxed);
+    while ((state & BUF_LOCKED) ||
+           !descriptor->m_state.compare_exchange_weak(state, state | BUF_LOCKED, std::memory_order_acquire)) {
+      state = descriptor->m_state.load(std::memory_order_relaxed);
+    }
+    descriptor->m_state.store(state + BUF_REFCOUNT_ONE, std::memory_order_release);
+
+    state = descriptor->m_state.load(std::memory_order_relaxed);
+    while ((state & BUF_LOCKED) ||
+           !descriptor->m_state.compare_exchange_weak(state, state - BUF_REFCOUNT_ONE, std::memory_order_release)) {
+      state = descriptor->m_state.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * Pins and unpins neighbouring descriptors of an array, one per thread and
+ * CPU. The array is allocated at the start of a cache line, as in the Buffer
+ * Pool.
+ * @param in numThreads The number of threads
+ * @return The number of pins per second of all the threads together
+ **/
+template <typename Descriptor>
+static double runDescriptorPins( uint32_t numThreads ) {
+  void* memory = nullptr;
+  EXPECT_TRUE(posix_memalign(&memory, CACHE_LINE_SIZE, numThreads*sizeof(Descriptor)) == 0);
+  Descriptor* descriptors = new (memory) Descriptor[numThreads];
+  std::vector<int> cpus = getCPUs();
+  std::vector<std::thread> threads;
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (uint32_t t = 0; t < numThreads; ++t) {
+    threads.emplace_back(pinDescriptor<Descriptor>, &descriptors[t], cpus[t % cpus.size()]);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
+  for (uint32_t t = 0; t < numThreads; ++t) {
+    EXPECT_TRUE(descriptors[t].m_state.load() == 0);
+    descriptors[t].~Descriptor();
+  }
+  free(memory);
+  return static_cast<double>(numThreads)*PINS_PER_THREAD / std::max<uint64_t>(us, 1) * 1000000;
+}
+
+/**
+ * Compares the pins of neighbouring descriptors packed as they used to be,
+ * several of them sharing a cache line, against the pins of neighbouring
+ * descriptors aligned to cache lines, as they are in the Buffer Pool. The
+ * difference only shows on machines with several cores.
+ */
+TEST(PerformanceTest, PerformanceTestPinDescriptorLayout) {
+  uint32_t numThreads = getNumThreads();
+  if (numThreads == 0) {
+    return;
+  }
+  double packedRate = runDescriptorPins<PackedDescriptor>(numThreads);
+  double paddedRate = runDescriptorPins<BufferDescriptor>(numThreads);
+  std::cout << numThreads << " threads, each on its own CPU" << std::endl;
+  std::cout << "Packed descriptors (" << sizeof(PackedDescriptor) << " bytes): " << packedRate/1000000 << " M pins/s" << std::endl;
+  std::cout << "Padded descriptors (" << sizeof(BufferDescriptor) << " bytes): " << paddedRate/1000000 << " M pins/s" << std::endl;
+  std::cout << "Speedup: " << paddedRate/packedRate << "x" << std::endl;
+}
+
+/**
+ * Compares threads pinning pages held by neighbouring buffers, whose
+ * descriptors would share cache lines if they were packed, against threads
+ * pinning pages held by buffers far apart. With every descriptor in its own
+ * cache line, both are expected to run at the same rate.
+ */
+TEST(PerformanceTest, PerformanceTestPinFalseSharing) {
+  uint32_t numThreads = getNumThreads();
+  if (numThreads == 0) {
+    return;
+  }
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = POOL_BUFFERS*PAGE_SIZE_KB;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./pin.db", FileStorageConfig{PAGE_SIZE_KB}, true) == ErrorCode::E_NO_ERROR);
+
+  // Pages are allocated into consecutive buffers
+  std::vector<pageId_t> pages;
+  BufferHandler bufferHandler;
+  for (uint32_t i = 0; i < POOL_BUFFERS; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_bId == i);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    pages.push_back(bufferHandler.m_pId);
+  }
+
+  std::vector<pageId_t> neighbours, apart;
+  for (uint32_t t = 0; t < numThreads; ++t) {
+    neighbours.push_back(pages[t]);
+    apart.push_back(pages[t*(POOL_BUFFERS/numThreads)]);
+  }
+  double neighbourRate = runPins(&bufferPool, neighbours);
+  double apartRate = runPins(&bufferPool, apart);
+  std::cout << numThreads << " threads pinning neighbouring buffers: " << neighbourRate/1000000 << " M pins/s" << std::endl;
+  std::cout << numThreads << " threads pinning buffers far apart: " << apartRate/1000000 << " M pins/s" << std::endl;
+
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./pin.db");
+  std::remove("./pin.db.config");
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -1,11 +1,13 @@
 #include <gtest/gtest.h>
 #include <memory/buffer_pool.h>
 #include <tasking/tasking.h>
+#include <chrono>
 
 SMILE_NS_BEGIN
 
 #define PAGE_SIZE_KB 64
 #define DATA_KB 4*1024*1024
+#define EMULATED_DATA_KB (64*1024)
 
 /**
  * Tests a scan operation of 4GB over a 1GB-size Buffer Pool for benchmarking purposes.
@@ -17,8 +19,9 @@ TEST(PerformanceTest, PerformanceTestScan) {
 		BufferPool bufferPool;
     BufferPoolConfig bpConfig;
     bpConfig.m_poolSizeKB = 1024*1024;
-    bpConfig.m_prefetchingDegree = 1;
+    bpConfig.m_prefetchingDegree = 64;
 		ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+		ASSERT_TRUE(bufferPool.adviseAccess(AccessPattern::E_SEQUENTIAL) == ErrorCode::E_NO_ERROR);
 		BufferHandler bufferHandler;
 
 		uint64_t page = 0;
@@ -38,6 +41,138 @@ TEST(PerformanceTest, PerformanceTestScan) {
 	}
 }
 
+/**
+ * Tests the same scan pinning runs of 64 contiguous pages at once, so that
+ * the Buffer Pool reads them with 4MB vectored requests.
+ */
+TEST(PerformanceTest, PerformanceTestScanBatched) {
+	if (std::ifstream("./test.db")) {
+		startThreadPool(1);
+
+		BufferPool bufferPool;
+    BufferPoolConfig bpConfig;
+    bpConfig.m_poolSizeKB = 1024*1024;
+    bpConfig.m_prefetchingDegree = 0;
+    bpConfig.m_ioQueueDepth = 32;
+		ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+		ASSERT_TRUE(bufferPool.adviseAccess(AccessPattern::E_SEQUENTIAL) == ErrorCode::E_NO_ERROR);
+		std::vector<BufferHandler> bufferHandlers(64);
+		std::vector<pageId_t> pages;
+
+		uint64_t page = 0;
+		std::vector<uint64_t> dummy(PAGE_SIZE_KB*1024*8/64);
+
+		// Scan operation
+		for (uint64_t i = 0; i < DATA_KB; i += PAGE_SIZE_KB) {
+			if ( page%(PAGE_SIZE_KB*1024*8) == 0 ) ++page;
+			pages.push_back(page);
+			if (pages.size() == bufferHandlers.size() || i + PAGE_SIZE_KB >= DATA_KB) {
+				ASSERT_TRUE(bufferPool.pinBatch(pages.data(), pages.size(), bufferHandlers.data()) == ErrorCode::E_NO_ERROR);
+				for (uint32_t j = 0; j < pages.size(); ++j) {
+					memcpy(&dummy[0], bufferHandlers[j].m_buffer, PAGE_SIZE_KB*1024);
+					ASSERT_TRUE(bufferPool.unpin(bufferHandlers[j]) == ErrorCode::E_NO_ERROR);
+				}
+				pages.clear();
+			}
+			++page;
+		}
+
+		stopThreadPool();
+    bufferPool.close();
+	}
+}
+
+/**
+ * Tests the same scan over a read-only mapping of the storage, which serves
+ * pages in place instead of copying them into buffers.
+ */
+TEST(PerformanceTest, PerformanceTestScanMapped) {
+	if (std::ifstream("./test.db")) {
+		startThreadPool(1);
+
+		BufferPool bufferPool;
+    BufferPoolConfig bpConfig;
+    bpConfig.m_prefetchingDegree = 0;
+    bpConfig.m_readOnlyMapping = true;
+		ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+		ASSERT_TRUE(bufferPool.adviseAccess(AccessPattern::E_SEQUENTIAL) == ErrorCode::E_NO_ERROR);
+		BufferHandler bufferHandler;
+
+		uint64_t page = 0;
+		std::vector<uint64_t> dummy(PAGE_SIZE_KB*1024*8/64);
+
+		// Scan operation
+		for (uint64_t i = 0; i < DATA_KB; i += PAGE_SIZE_KB) {
+			if ( page%(PAGE_SIZE_KB*1024*8) == 0 ) ++page;
+			ASSERT_TRUE(bufferPool.pin(page, &bufferHandler) == ErrorCode::E_NO_ERROR);
+			memcpy(&dummy[0], bufferHandler.m_buffer, PAGE_SIZE_KB*1024);
+			ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+			++page;
+		}
+
+		stopThreadPool();
+    bufferPool.close();
+	}
+}
+
+/**
+ * Scans an in-memory storage behind an emulated SATA SSD through a Buffer
+ * Pool smaller than the data, adding up the words of every page.
+ *
+ * @return The time of the scan in milliseconds.
+ */
+static uint64_t scanEmulated( uint16_t prefetchingDegree ) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 16*1024;
+  bpConfig.m_prefetchingDegree = prefetchingDegree;
+  bpConfig.m_deviceProfile = DeviceProfile::sataSSD();
+  bpConfig.m_ioQueueDepth = 32;
+  FileStorageConfig fsConfig;
+  fsConfig.m_pageSizeKB = PAGE_SIZE_KB;
+  fsConfig.m_inMemory = true;
+  EXPECT_TRUE(bufferPool.create(bpConfig, "./scan.db", fsConfig) == ErrorCode::E_NO_ERROR);
+
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint64_t i = 0; i < EMULATED_DATA_KB; i += PAGE_SIZE_KB) {
+    EXPECT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    bufferPool.setPageDirty(bufferHandler.m_pId);
+    memset(bufferHandler.m_buffer, static_cast<char>(i), PAGE_SIZE_KB*1024);
+    pages.push_back(bufferHandler.m_pId);
+    bufferPool.unpin(bufferHandler);
+  }
+  EXPECT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+
+  uint64_t sum = 0;
+  std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+  for (pageId_t pId : pages) {
+    EXPECT_TRUE(bufferPool.pin(pId, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(bufferHandler.m_buffer);
+    for (uint64_t i = 0; i < PAGE_SIZE_KB*1024/sizeof(uint64_t); ++i) {
+      sum += words[i];
+    }
+    bufferPool.unpin(bufferHandler);
+  }
+  std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+  EXPECT_TRUE(sum > 0);
+  EXPECT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  return std::max<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count(), 1);
+}
+
+/**
+ * Compares the scan with and without prefetching over an emulated device,
+ * which needs no data file
+ */
+TEST(PerformanceTest, PerformanceTestScanPrefetch) {
+  startThreadPool(1);
+  uint64_t plainMs = scanEmulated(0);
+  uint64_t prefetchMs = scanEmulated(64);
+  std::cout << "Scan without prefetching: " << plainMs << " ms, with prefetching: " << prefetchMs 
+            << " ms (speedup " << static_cast<double>(plainMs)/prefetchMs << "x)" << std::endl;
+  stopThreadPool();
+}
+
 SMILE_NS_END
 
 int main(int argc, char* argv[]){
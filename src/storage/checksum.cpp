@@ -0,0 +1,319 @@
+
+
+#include "checksum.h"
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+SMILE_NS_BEGIN
+
+// The CRC32C polynomial, bit-reflected
+#define CRC32C_POLY 0x82f63b78
+
+/**
+ * Lookup tables of the portable implementation, which processes 8 bytes per
+ * step: m_table[k][b] is the CRC of byte b followed by k zero bytes.
+ */
+struct CRC32CTables {
+  uint32_t m_table[8][256];
+
+  /**
+   * x^(2^n) modulo the polynomial, used to shift a CRC over zero bytes
+   */
+  uint32_t m_x2n[32];
+
+  CRC32CTables() noexcept {
+    for (uint32_t b = 0; b < 256; ++b) {
+      uint32_t crc = b;
+      for (uint32_t i = 0; i < 8; ++i) {
+        crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+      }
+      m_table[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; ++b) {
+      for (uint32_t k = 1; k < 8; ++k) {
+        m_table[k][b] = (m_table[k-1][b] >> 8) ^ m_table[0][m_table[k-1][b] & 0xff];
+      }
+    }
+    m_x2n[0] = 1u << 30;
+    for (uint32_t n = 1; n < 32; ++n) {
+      m_x2n[n] = multiply(m_x2n[n-1], m_x2n[n-1]);
+    }
+  }
+
+  /**
+   * Multiplies two polynomials modulo the CRC polynomial, bit-reflected
+   */
+  static uint32_t multiply( uint32_t a, uint32_t b ) noexcept {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+    while (true) {
+      if (a & m) {
+        p ^= b;
+        if ((a & (m - 1)) == 0) {
+          break;
+        }
+      }
+      m >>= 1;
+      b = (b & 1) ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+    }
+    return p;
+  }
+
+  /**
+   * Computes x^exponent modulo the polynomial, from the powers x^(2^n) of
+   * the bits of the exponent
+   */
+  uint32_t power( uint64_t exponent ) const noexcept {
+    uint32_t x = 1u << 31;
+    for (uint32_t n = 0; exponent > 0; exponent >>= 1, ++n) {
+      if (exponent & 1) {
+        x = multiply(m_x2n[n & 31], x);
+      }
+    }
+    return x;
+  }
+
+  /**
+   * Computes x^(8*size) modulo the polynomial. Multiplying a raw CRC
+   * register state by it appends size zero bytes to the data.
+   */
+  uint32_t shiftOperator( size_t size ) const noexcept {
+    return power(8*size);
+  }
+};
+
+static const CRC32CTables& getTables() noexcept {
+  static const CRC32CTables tables;
+  return tables;
+}
+
+/**
+ * Updates a raw CRC register state with the given data, 8 bytes at a time
+ */
+static uint32_t updatePortable( uint32_t crc, 
+                                const unsigned char* data, 
+                                size_t size ) noexcept {
+  const CRC32CTables& t = getTables();
+  while (size >= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    word ^= crc;
+    crc = t.m_table[7][word & 0xff] ^
+          t.m_table[6][(word >> 8) & 0xff] ^
+          t.m_table[5][(word >> 16) & 0xff] ^
+          t.m_table[4][(word >> 24) & 0xff] ^
+          t.m_table[3][(word >> 32) & 0xff] ^
+          t.m_table[2][(word >> 40) & 0xff] ^
+          t.m_table[1][(word >> 48) & 0xff] ^
+          t.m_table[0][word >> 56];
+    data += 8;
+    size -= 8;
+  }
+  while (size > 0) {
+    crc = (crc >> 8) ^ t.m_table[0][(crc ^ *data) & 0xff];
+    ++data;
+    --size;
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+
+/**
+ * Constants folding a 128-bit block of data forward by a distance of bits
+ * D, which multiplies it by x^D modulo the polynomial. The low half of the
+ * block holds the higher degrees, and is multiplied by x^(D+63), the high
+ * half by x^(D-1). One less than the distance, as the carry-less product of
+ * two bit-reflected values is one bit short.
+ */
+struct CRC32CFoldConstants {
+  uint64_t m_fold256[2];
+  uint64_t m_fold64[2];
+  uint64_t m_fold48[2];
+  uint64_t m_fold32[2];
+  uint64_t m_fold16[2];
+
+  CRC32CFoldConstants() noexcept {
+    setConstants(m_fold256, 256);
+    setConstants(m_fold64, 64);
+    setConstants(m_fold48, 48);
+    setConstants(m_fold32, 32);
+    setConstants(m_fold16, 16);
+  }
+
+  static void setConstants( uint64_t* constants, uint32_t distance ) noexcept {
+    const CRC32CTables& t = getTables();
+    constants[0] = static_cast<uint64_t>(t.power(8*distance + 63)) << 32;
+    constants[1] = static_cast<uint64_t>(t.power(8*distance - 1)) << 32;
+  }
+};
+
+static const CRC32CFoldConstants& getFoldConstants() noexcept {
+  static const CRC32CFoldConstants constants;
+  return constants;
+}
+
+/**
+ * Whether the processor multiplies 512-bit vectors carry-less, to fold
+ * large buffers faster than the crc32 instruction can checksum them
+ */
+static bool isFoldingAccelerated() noexcept {
+  static const bool accelerated = __builtin_cpu_supports("avx512f") && 
+                                  __builtin_cpu_supports("vpclmulqdq");
+  return accelerated;
+}
+
+__attribute__((target("avx512f,vpclmulqdq")))
+static inline __m512i fold512( __m512i block, 
+                               __m512i constants ) noexcept {
+  return _mm512_xor_si512(_mm512_clmulepi64_epi128(block, constants, 0x00),
+                          _mm512_clmulepi64_epi128(block, constants, 0x11));
+}
+
+__attribute__((target("pclmul")))
+static inline __m128i fold128( __m128i block, 
+                               const uint64_t* constants ) noexcept {
+  __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(constants));
+  return _mm_xor_si128(_mm_clmulepi64_si128(block, k, 0x00),
+                       _mm_clmulepi64_si128(block, k, 0x11));
+}
+
+/**
+ * Updates a raw CRC register state with a multiple of 256 bytes, folding
+ * four 512-bit accumulators forward by 256 bytes per step with carry-less
+ * multiplications. The CRC register state is folded in as the first bytes
+ * of the data, and the 16 bytes left at the end are checksummed with the
+ * crc32 instruction.
+ */
+__attribute__((target("avx512f,vpclmulqdq,pclmul,sse4.2")))
+static uint32_t updateFolding( uint32_t crc, 
+                               const unsigned char* data, 
+                               size_t size ) noexcept {
+  const CRC32CFoldConstants& k = getFoldConstants();
+  __m512i x0 = _mm512_loadu_si512(data);
+  __m512i x1 = _mm512_loadu_si512(data + 64);
+  __m512i x2 = _mm512_loadu_si512(data + 128);
+  __m512i x3 = _mm512_loadu_si512(data + 192);
+  x0 = _mm512_xor_si512(x0, _mm512_inserti32x4(_mm512_setzero_si512(), _mm_cvtsi32_si128(crc), 0));
+  data += 256;
+  size -= 256;
+
+  __m512i fold256 = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(k.m_fold256)));
+  while (size >= 256) {
+    x0 = _mm512_xor_si512(fold512(x0, fold256), _mm512_loadu_si512(data));
+    x1 = _mm512_xor_si512(fold512(x1, fold256), _mm512_loadu_si512(data + 64));
+    x2 = _mm512_xor_si512(fold512(x2, fold256), _mm512_loadu_si512(data + 128));
+    x3 = _mm512_xor_si512(fold512(x3, fold256), _mm512_loadu_si512(data + 192));
+    data += 256;
+    size -= 256;
+  }
+
+  // The accumulators are folded into the last one, and its four blocks
+  // into the last block
+  __m512i fold64 = _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(k.m_fold64)));
+  x1 = _mm512_xor_si512(fold512(x0, fold64), x1);
+  x2 = _mm512_xor_si512(fold512(x1, fold64), x2);
+  x3 = _mm512_xor_si512(fold512(x2, fold64), x3);
+  __m128i block = _mm_xor_si128(fold128(_mm512_extracti32x4_epi32(x3, 0), k.m_fold48),
+                                fold128(_mm512_extracti32x4_epi32(x3, 1), k.m_fold32));
+  block = _mm_xor_si128(block, fold128(_mm512_extracti32x4_epi32(x3, 2), k.m_fold16));
+  block = _mm_xor_si128(block, _mm512_extracti32x4_epi32(x3, 3));
+
+  uint64_t result = _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(block)));
+  result = _mm_crc32_u64(result, static_cast<uint64_t>(_mm_extract_epi64(block, 1)));
+  return static_cast<uint32_t>(result);
+}
+
+/**
+ * Updates a raw CRC register state with the crc32 instruction. The
+ * instruction has a latency of three cycles but a throughput of one per
+ * cycle, so large buffers are split in three streams computed at once and
+ * combined at the end. Where carry-less multiplications of 512-bit vectors
+ * are supported, large buffers are folded instead, up to the last bytes.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t updateHardware( uint32_t crc, 
+                                const unsigned char* data, 
+                                size_t size ) noexcept {
+  if (size >= 1024 && isFoldingAccelerated()) {
+    size_t foldedSize = size & ~static_cast<size_t>(255);
+    crc = updateFolding(crc, data, foldedSize);
+    data += foldedSize;
+    size -= foldedSize;
+  }
+  uint64_t crc0 = crc;
+  size_t streamSize = (size / 24) * 8;
+  if (streamSize >= 256) {
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    const unsigned char* end = data + streamSize;
+    while (data < end) {
+      uint64_t w0, w1, w2;
+      memcpy(&w0, data, sizeof(w0));
+      memcpy(&w1, data + streamSize, sizeof(w1));
+      memcpy(&w2, data + 2*streamSize, sizeof(w2));
+      crc0 = _mm_crc32_u64(crc0, w0);
+      crc1 = _mm_crc32_u64(crc1, w1);
+      crc2 = _mm_crc32_u64(crc2, w2);
+      data += 8;
+    }
+    // Buffers usually have the size of a page, so the shift operator is
+    // only computed when the size changes
+    static thread_local size_t operatorSize = 0;
+    static thread_local uint32_t shiftOperator = 0;
+    if (operatorSize != streamSize) {
+      shiftOperator = getTables().shiftOperator(streamSize);
+      operatorSize = streamSize;
+    }
+    crc0 = CRC32CTables::multiply(shiftOperator, static_cast<uint32_t>(crc0)) ^ crc1;
+    crc0 = CRC32CTables::multiply(shiftOperator, static_cast<uint32_t>(crc0)) ^ crc2;
+    data += 2*streamSize;
+    size -= 3*streamSize;
+  }
+  while (size >= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc0 = _mm_crc32_u64(crc0, word);
+    data += 8;
+    size -= 8;
+  }
+  while (size > 0) {
+    crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), *data);
+    ++data;
+    --size;
+  }
+  return static_cast<uint32_t>(crc0);
+}
+
+#endif
+
+bool isCRC32CAccelerated() noexcept {
+#if defined(__x86_64__)
+  static const bool accelerated = __builtin_cpu_supports("sse4.2");
+  return accelerated;
+#else
+  return false;
+#endif
+}
+
+uint32_t computeCRC32C( const char* data,
+                        size_t size,
+                        uint32_t crc ) noexcept {
+#if defined(__x86_64__)
+  if (isCRC32CAccelerated()) {
+    return ~updateHardware(~crc, reinterpret_cast<const unsigned char*>(data), size);
+  }
+#endif
+  return computeCRC32CPortable(data, size, crc);
+}
+
+uint32_t computeCRC32CPortable( const char* data,
+                                size_t size,
+                                uint32_t crc ) noexcept {
+  return ~updatePortable(~crc, reinterpret_cast<const unsigned char*>(data), size);
+}
+
+SMILE_NS_END
@@ -0,0 +1,45 @@
+
+
+#ifndef _STORAGE_CHECKSUM_H_
+#define _STORAGE_CHECKSUM_H_
+
+#include "../base/base.h"
+
+SMILE_NS_BEGIN
+
+/**
+ * Computes the CRC32C (Castagnoli) checksum of a buffer. The SSE4.2 crc32
+ * instruction is used when the processor supports it, with large buffers
+ * folded by 512-bit carry-less multiplications where available, and a
+ * table-driven implementation otherwise. All produce the same values.
+ * @param in data The buffer to checksum
+ * @param in size The size of the buffer in bytes
+ * @param in crc The checksum of the preceding data, to checksum a buffer in
+ * several calls. 0 for the first call.
+ * @return The checksum of the data
+ **/
+uint32_t computeCRC32C( const char* data,
+                        size_t size,
+                        uint32_t crc = 0 ) noexcept;
+
+/**
+ * Computes the CRC32C checksum of a buffer with the table-driven
+ * implementation, regardless of the processor
+ * @param in data The buffer to checksum
+ * @param in size The size of the buffer in bytes
+ * @param in crc The checksum of the preceding data. 0 for the first call.
+ * @return The checksum of the data
+ **/
+uint32_t computeCRC32CPortable( const char* data,
+                                size_t size,
+                                uint32_t crc = 0 ) noexcept;
+
+/**
+ * Whether computeCRC32C uses the crc32 instruction of the processor
+ * @return true if the checksums are hardware accelerated
+ **/
+bool isCRC32CAccelerated() noexcept;
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_CHECKSUM_H_ */
@@ -0,0 +1,41 @@
+
+
+#include "device_model.h"
+#include <algorithm>
+
+SMILE_NS_BEGIN
+
+DeviceModel::DeviceModel( const DeviceProfile& profile ) noexcept :
+m_profile(profile),
+m_busyUntil(clock_t::now()),
+m_nextOffset(0)
+{
+}
+
+DeviceModel::clock_t::time_point DeviceModel::schedule( uint64_t offset,
+                                                        size_t size ) noexcept {
+  std::chrono::nanoseconds transfer(0);
+  if(m_profile.m_bandwidthMBps > 0) {
+    transfer = std::chrono::nanoseconds(size * 1000 / m_profile.m_bandwidthMBps);
+  }
+
+  std::lock_guard<std::mutex> guard(m_lock);
+  std::chrono::nanoseconds latency(0);
+  if(offset != m_nextOffset) {
+    latency = std::chrono::microseconds(m_profile.m_latencyUs);
+  }
+  clock_t::time_point start = std::max(clock_t::now(), m_busyUntil);
+  m_nextOffset = offset + size;
+  if(m_profile.m_rotational) {
+    m_busyUntil = start + latency + transfer;
+    return m_busyUntil;
+  }
+  m_busyUntil = start + transfer;
+  return m_busyUntil + latency;
+}
+
+const DeviceProfile& DeviceModel::profile() const noexcept {
+  return m_profile;
+}
+
+SMILE_NS_END
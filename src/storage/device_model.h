@@ -0,0 +1,99 @@
+
+
+#ifndef _STORAGE_DEVICE_MODEL_H_
+#define _STORAGE_DEVICE_MODEL_H_
+
+#include "../base/base.h"
+#include <chrono>
+#include <mutex>
+
+SMILE_NS_BEGIN
+
+/**
+ * Performance characteristics of an emulated storage device. A profile with
+ * no latency and no bandwidth limit disables the emulation.
+ */
+struct DeviceProfile {
+  /**
+   * Time in microseconds to access the data of a request, before it is
+   * transferred. Requests starting where the previous one ended skip it, as
+   * they would with a disk head or a device readahead in place.
+   */
+  uint32_t  m_latencyUs = 0;
+
+  /**
+   * Transfer rate in MB/s, shared by all the requests. 0 means unlimited.
+   */
+  uint32_t  m_bandwidthMBps = 0;
+
+  /**
+   * Whether the access latency is a seek that blocks the device, as in a
+   * hard disk, instead of overlapping with the other requests.
+   */
+  bool      m_rotational = false;
+
+  static DeviceProfile nvme() noexcept {
+    return DeviceProfile{20, 3000, false};
+  }
+
+  static DeviceProfile sataSSD() noexcept {
+    return DeviceProfile{80, 500, false};
+  }
+
+  static DeviceProfile hdd() noexcept {
+    return DeviceProfile{8000, 150, true};
+  }
+
+  bool isEnabled() const noexcept {
+    return m_latencyUs > 0 || m_bandwidthMBps > 0;
+  }
+};
+
+/**
+ * Computes when the requests sent to an emulated device complete. Transfers
+ * are serialized at the bandwidth of the device, while access latencies
+ * overlap unless the device is rotational. It is thread-safe.
+ */
+class DeviceModel final {
+  public:
+    SMILE_NOT_COPYABLE(DeviceModel)
+
+    using clock_t = std::chrono::steady_clock;
+
+    DeviceModel( const DeviceProfile& profile ) noexcept;
+
+    ~DeviceModel() noexcept = default;
+
+    /**
+     * Accounts a request sent to the device now
+     * @param in offset The offset of the request in the device
+     * @param in size The number of bytes transferred
+     * @return The time at which the request completes
+     **/
+    clock_t::time_point schedule( uint64_t offset,
+                                  size_t size ) noexcept;
+
+    /**
+     * Gets the profile of the device
+     * @return The profile of the device
+     **/
+    const DeviceProfile& profile() const noexcept;
+
+  private:
+
+    // The characteristics of the device
+    DeviceProfile       m_profile;
+
+    // Protects the state of the device
+    std::mutex          m_lock;
+
+    // The time at which the device finishes the requests sent so far
+    clock_t::time_point m_busyUntil;
+
+    // The offset following the last request
+    uint64_t            m_nextOffset;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_DEVICE_MODEL_H_ */
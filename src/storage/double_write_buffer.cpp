@@ -0,0 +1,213 @@
+
+
+#include "double_write_buffer.h"
+#include "checksum.h"
+#include "file_utils.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <fstream>
+#include <stddef.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Identifies staging files
+ */
+#define DWB_MAGIC 0x425744454c494d53ULL
+
+DoubleWriteBuffer::DoubleWriteBuffer() noexcept :
+m_file(-1),
+m_pageSize(0),
+m_numRestored(0),
+m_opened(false)
+{
+}
+
+DoubleWriteBuffer::~DoubleWriteBuffer() noexcept {
+  assert(!m_opened && "DoubleWriteBuffer needs to be closed first");
+
+  if(m_file != -1) {
+    ::close(m_file);
+  }
+}
+
+ErrorCode DoubleWriteBuffer::open( const std::string& path,
+                                   size_t pageSize,
+                                   const RestoreFunction& restore ) noexcept {
+  assert(!m_opened && "DoubleWriteBuffer is already opened");
+
+  m_file = ::open( path.c_str(), O_RDWR | O_CLOEXEC );
+  if(m_file == -1) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+
+  m_pageSize = pageSize;
+  ErrorCode err = this->restore(restore);
+  if(err != ErrorCode::E_NO_ERROR) {
+    ::close(m_file);
+    m_file = -1;
+    return err;
+  }
+
+  m_opened = true;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode DoubleWriteBuffer::create( const std::string& path,
+                                     size_t pageSize,
+                                     bool overwrite ) noexcept {
+  assert(!m_opened && "DoubleWriteBuffer is already opened");
+
+  if(!overwrite && std::ifstream(path)) {
+    return ErrorCode::E_STORAGE_PATH_ALREADY_EXISTS;
+  }
+
+  m_file = ::open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+  if(m_file == -1) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+
+  m_pageSize = pageSize;
+  m_opened = true;
+  m_numRestored = 0;
+  ErrorCode err = clear();
+  if(err != ErrorCode::E_NO_ERROR) {
+    close();
+    return err;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode DoubleWriteBuffer::close() noexcept {
+  assert(m_opened && "DoubleWriteBuffer is not opened");
+
+  ::close(m_file);
+  m_file = -1;
+  m_entries.clear();
+  m_entries.shrink_to_fit();
+  m_opened = false;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode DoubleWriteBuffer::stage( const pageId_t* pageIds,
+                                    const char* const* data,
+                                    uint32_t numPages ) noexcept {
+  assert(m_opened && "DoubleWriteBuffer is not opened");
+
+  m_entries.resize(numPages);
+  for(uint32_t i = 0; i < numPages; ++i) {
+    m_entries[i].m_pageId   = pageIds[i];
+    m_entries[i].m_checksum = computeCRC32C(data[i], m_pageSize);
+    m_entries[i].m_padding  = 0;
+  }
+
+  Header header;
+  memset(&header, 0, sizeof(header));
+  header.m_magic    = DWB_MAGIC;
+  header.m_pageSize = m_pageSize;
+  header.m_numPages = numPages;
+  header.m_checksum = computeChecksum(header, m_entries);
+
+  // The whole batch goes out in a single sequential write. A crash in the
+  // middle of it is detected by the checksums, whatever part was written.
+  std::vector<struct iovec> iov(numPages + 2);
+  iov[0].iov_base = &header;
+  iov[0].iov_len  = sizeof(header);
+  iov[1].iov_base = m_entries.data();
+  iov[1].iov_len  = numPages*sizeof(Entry);
+  for(uint32_t i = 0; i < numPages; ++i) {
+    iov[i+2].iov_base = const_cast<char*>(data[i]);
+    iov[i+2].iov_len  = m_pageSize;
+  }
+  if(!transferVectorFully(false, m_file, iov.data(), iov.size(), 0) ||
+     fdatasync(m_file) != 0) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode DoubleWriteBuffer::clear() noexcept {
+  assert(m_opened && "DoubleWriteBuffer is not opened");
+
+  // The header is not synced. If it is lost, the batch is restored again
+  // over pages written after it, but only until the next batch is staged,
+  // so those pages were not checkpointed, and their logged updates, if any,
+  // are redone after the restore.
+  m_entries.clear();
+  Header header;
+  memset(&header, 0, sizeof(header));
+  header.m_magic    = DWB_MAGIC;
+  header.m_pageSize = m_pageSize;
+  header.m_numPages = 0;
+  header.m_checksum = computeChecksum(header, m_entries);
+  if(!pwriteFully(m_file, reinterpret_cast<const char*>(&header), sizeof(header), 0)) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+uint64_t DoubleWriteBuffer::getNumRestored() const noexcept {
+  return m_numRestored;
+}
+
+bool DoubleWriteBuffer::isOpened() const noexcept {
+  return m_opened;
+}
+
+ErrorCode DoubleWriteBuffer::restore( const RestoreFunction& restore ) noexcept {
+  m_numRestored = 0;
+
+  Header header;
+  if(!preadFully(m_file, reinterpret_cast<char*>(&header), sizeof(header), 0) ||
+     header.m_magic != DWB_MAGIC ||
+     header.m_pageSize != m_pageSize) {
+    return ErrorCode::E_STORAGE_INVALID_DOUBLE_WRITE_BUFFER;
+  }
+
+  // A batch torn while it was staged was not written in place yet, so it is
+  // just discarded. The number of pages of a torn header may be anything, so
+  // it is checked against the size of the file first.
+  struct stat fileStat;
+  if(fstat(m_file, &fileStat) != 0) {
+    return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+  }
+  if(sizeof(header) + header.m_numPages*(sizeof(Entry) + m_pageSize) > static_cast<uint64_t>(fileStat.st_size)) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  std::vector<Entry> entries(header.m_numPages);
+  if(!preadFully(m_file, reinterpret_cast<char*>(entries.data()), entries.size()*sizeof(Entry), sizeof(header)) ||
+     header.m_checksum != computeChecksum(header, entries)) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  // Every page is verified before any of them is restored
+  std::vector<char> pages(entries.size()*m_pageSize);
+  if(!preadFully(m_file, pages.data(), pages.size(), sizeof(header) + entries.size()*sizeof(Entry))) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  for(uint32_t i = 0; i < entries.size(); ++i) {
+    if(entries[i].m_checksum != computeCRC32C(&pages[i*m_pageSize], m_pageSize)) {
+      return ErrorCode::E_NO_ERROR;
+    }
+  }
+
+  for(uint32_t i = 0; i < entries.size(); ++i) {
+    ErrorCode err = restore(entries[i].m_pageId, &pages[i*m_pageSize]);
+    if(err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+    ++m_numRestored;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+uint32_t DoubleWriteBuffer::computeChecksum( const Header& header,
+                                             const std::vector<Entry>& entries ) noexcept {
+  uint32_t checksum = computeCRC32C(reinterpret_cast<const char*>(&header), offsetof(Header, m_checksum));
+  return computeCRC32C(reinterpret_cast<const char*>(entries.data()), entries.size()*sizeof(Entry), checksum);
+}
+
+SMILE_NS_END
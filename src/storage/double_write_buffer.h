@@ -0,0 +1,154 @@
+
+
+#ifndef _STORAGE_DOUBLE_WRITE_BUFFER_H_
+#define _STORAGE_DOUBLE_WRITE_BUFFER_H_
+
+#include "../base/base.h"
+#include "types.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Staging area protecting in-place page writes from being torn by a crash.
+ * A batch of pages is first written to the staging file with a single
+ * sequential write and synced, and only then written in place. If the
+ * process crashes while the pages are being written in place, the complete
+ * batch is still in the staging file and is written again when it is
+ * opened. A batch torn itself is discarded, as its pages were not written in
+ * place yet.
+ */
+class DoubleWriteBuffer final {
+  public:
+    SMILE_NOT_COPYABLE(DoubleWriteBuffer)
+
+    /**
+     * Function writing in place a page found in the staging file when it is
+     * opened
+     * @param in pageId The page
+     * @param in data The contents of the page
+     * @return E_NO_ERROR to go on with the next page
+     **/
+    using RestoreFunction = std::function<ErrorCode (const pageId_t& pageId, const char* data)>;
+
+    DoubleWriteBuffer() noexcept;
+
+    ~DoubleWriteBuffer() noexcept;
+
+    /**
+     * Opens the staging file at the given path and restores the pages of
+     * the batch it holds, if it is complete. The batch is kept until
+     * clear() is called, which must follow a sync of the storage.
+     * @param in path The path to the staging file
+     * @param in pageSize The size of the pages in bytes
+     * @param in restore The function writing each page in place
+     * @return E_STORAGE_INVALID_DOUBLE_WRITE_BUFFER if the file is not a
+     * staging file, or the error returned by restore
+     **/
+    ErrorCode open( const std::string& path,
+                    size_t pageSize,
+                    const RestoreFunction& restore ) noexcept;
+
+    /**
+     * Creates an empty staging file at the given path
+     * @param in path The path to the staging file
+     * @param in pageSize The size of the pages in bytes
+     * @param in overwrite Whether to replace an existing file
+     * @return E_NO_ERROR if the file was created correctly
+     **/
+    ErrorCode create( const std::string& path,
+                      size_t pageSize,
+                      bool overwrite = false ) noexcept;
+
+    /**
+     * Closes the staging file
+     * @return E_NO_ERROR if the file was closed correctly
+     **/
+    ErrorCode close() noexcept;
+
+    /**
+     * Writes a batch of pages to the staging file and syncs it, replacing
+     * the previous batch. The pages can be written in place afterwards.
+     * @param in pageIds The pages of the batch
+     * @param in data numPages buffers, one for each page
+     * @param in numPages The number of pages of the batch
+     * @return E_NO_ERROR if the batch is durable
+     **/
+    ErrorCode stage( const pageId_t* pageIds,
+                     const char* const* data,
+                     uint32_t numPages ) noexcept;
+
+    /**
+     * Marks the staged batch as written in place, once the storage has been
+     * synced, so that it is not restored again
+     * @return E_NO_ERROR if the batch was cleared correctly
+     **/
+    ErrorCode clear() noexcept;
+
+    /**
+     * Gets the number of pages restored when the file was opened
+     * @return The number of pages restored
+     **/
+    uint64_t getNumRestored() const noexcept;
+
+    /**
+     * Whether the staging file is opened
+     * @return true if the file is opened
+     **/
+    bool isOpened() const noexcept;
+
+  private:
+
+    /**
+     * Header at the beginning of the staging file, followed by an entry per
+     * page of the batch and then by the pages. The checksum covers the rest
+     * of the header and the entries.
+     */
+    struct Header {
+      uint64_t  m_magic;
+      uint64_t  m_pageSize;
+      uint32_t  m_numPages;
+      uint32_t  m_checksum;
+    };
+
+    struct Entry {
+      pageId_t  m_pageId;
+      uint32_t  m_checksum;
+      uint32_t  m_padding;
+    };
+
+    /**
+     * Reads the batch of the staging file and restores its pages if it is
+     * complete
+     * @param in restore The function writing each page in place
+     * @return E_NO_ERROR if the file was read correctly
+     **/
+    ErrorCode restore( const RestoreFunction& restore ) noexcept;
+
+    /**
+     * Computes the checksum of the header and the entries of a batch
+     **/
+    static uint32_t computeChecksum( const Header& header,
+                                     const std::vector<Entry>& entries ) noexcept;
+
+    // The descriptor of the staging file
+    int                 m_file;
+
+    // The size of the pages in bytes
+    size_t              m_pageSize;
+
+    // The entries of the batch being staged
+    std::vector<Entry>  m_entries;
+
+    // The number of pages restored when the file was opened
+    uint64_t            m_numRestored;
+
+    // Stores if the file was opened and needs to be closed
+    bool                m_opened;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_DOUBLE_WRITE_BUFFER_H_ */
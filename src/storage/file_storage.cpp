@@ -1,12 +1,35 @@
 
 
 #include "file_storage.h"
+#include "checksum.h"
+#include "file_utils.h"
+#include <algorithm>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <limits>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 
 SMILE_NS_BEGIN
 
-FileStorage::FileStorage() noexcept : 
+FileStorage::FileStorage() noexcept :
+m_checksumFile(-1),
+p_checksumIndex(nullptr),
+m_checksumIndexCapacity(0),
+m_size(0),
 m_flags( std::ios_base::in | std::ios_base::out | std::ios_base::binary  ),
+p_pageFiller(nullptr),
+m_fillerChecksum(0),
+m_ioAlignment(1),
+p_mapping(nullptr),
+m_mappingSize(0),
 m_opened(false)
 {
 }
@@ -14,20 +37,106 @@ m_opened(false)
 FileStorage::~FileStorage() noexcept {
   assert(!m_opened && "FileStorage needs to be closed first");
 
-  if(m_dataFile) {
-    m_dataFile.close();
+  for(int dataFile : m_dataFiles) {
+    ::close(dataFile);
+  }
+
+  if(m_checksumFile != -1) {
+    ::close(m_checksumFile);
   }
 
   if(m_configFile) {
     m_configFile.close();
   }
+
+  free(p_pageFiller);
+}
+
+int FileStorage::openFile( const std::string& path,
+                           int flags ) const noexcept {
+  // In-memory files are anonymous. The path only names them for debugging.
+  if(m_config.m_inMemory) {
+    return memfd_create( path.c_str(), MFD_CLOEXEC );
+  }
+  return ::open( path.c_str(), O_RDWR | flags, 0644 );
+}
+
+ErrorCode FileStorage::openDataFiles( const std::string& path,
+                                      const std::vector<std::string>& stripePaths,
+                                      int flags ) noexcept {
+  if(m_config.m_numStripes == 0 || 
+     m_config.m_stripePages == 0 || 
+     stripePaths.size() + 1 != m_config.m_numStripes) {
+    return ErrorCode::E_STORAGE_INVALID_CONFIG;
+  }
+
+  if(m_config.m_directIO) {
+    if(m_config.m_inMemory) {
+      return ErrorCode::E_STORAGE_INVALID_CONFIG;
+    }
+    flags |= O_DIRECT;
+  }
+
+  // Direct transfers need buffers, offsets and sizes aligned to the device
+  // block size. We never go below the memory page size, which any device
+  // block size divides.
+  m_ioAlignment = m_config.m_directIO ? Platform::getSystemPageSize() : 1;
+  pageId_t size = 0;
+  for(uint32_t i = 0; i < m_config.m_numStripes; ++i) {
+    const std::string& filePath = (i == 0) ? path : stripePaths[i-1];
+    int dataFile = openFile( filePath, flags );
+    if(dataFile == -1) {
+      // Filesystems without direct I/O support reject O_DIRECT with EINVAL
+      return (errno == EINVAL && m_config.m_directIO) ? ErrorCode::E_STORAGE_INVALID_CONFIG : ErrorCode::E_STORAGE_INVALID_PATH;
+    }
+    m_dataFiles.push_back(dataFile);
+
+    struct stat fileStat;
+    if(fstat(dataFile, &fileStat) != 0) {
+      return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+    }
+    size += bytesToPage(fileStat.st_size);
+
+    if(m_config.m_directIO) {
+      size_t blockSize = fileStat.st_blksize;
+      if(blockSize > m_ioAlignment && getPageSize() % blockSize == 0) {
+        m_ioAlignment = blockSize;
+      }
+    }
+  }
+  if(getPageSize() % m_ioAlignment != 0) {
+    return ErrorCode::E_STORAGE_INVALID_CONFIG;
+  }
+
+  free(p_pageFiller);
+  p_pageFiller = allocAligned(getPageSize(), std::max<size_t>(m_ioAlignment, sizeof(void*)));
+  if(p_pageFiller == nullptr) {
+    return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+  }
+
+  // The checksum file is small and written in 4-byte entries, so it always
+  // goes through the page cache
+  if(m_config.m_checksums) {
+    m_checksumFile = openFile( path+".crc", flags & ~O_DIRECT );
+    if(m_checksumFile == -1) {
+      return ErrorCode::E_STORAGE_INVALID_PATH;
+    }
+    m_fillerChecksum = computeCRC32C(p_pageFiller, getPageSize());
+  }
+
+  m_writtenRanges.assign(m_dataFiles.size(), FileRange());
+  m_writeBackRanges.assign(m_dataFiles.size(), FileRange());
+  m_size = size;
+  if(m_checksumFile != -1) {
+    return loadChecksums();
+  }
+  return ErrorCode::E_NO_ERROR;
 }
 
 ErrorCode FileStorage::open( const std::string& path ) noexcept {
   assert(!m_opened && "FileStorage is already opened ");
 
-  m_dataFile.open( path, m_flags );
-  if(!m_dataFile){
+  if(!std::ifstream(path)) {
     return ErrorCode::E_STORAGE_INVALID_PATH;
   }
 
@@ -36,30 +145,57 @@ ErrorCode FileStorage::open( const std::string& path ) noexcept {
     return ErrorCode::E_STORAGE_INVALID_PATH;
   }
 
-  // Read FileStorageConfig from the first page of m_configFile
+  // Read FileStorageConfig from the first page of m_configFile, followed by
+  // the null-terminated paths of the stripes after the first one
   m_configFile.seekg(0,std::ios_base::beg);
   m_configFile.read(reinterpret_cast<char*>(&m_config), sizeof(m_config));
+  std::vector<std::string> stripePaths;
+  for(uint32_t i = 1; i < m_config.m_numStripes && m_configFile; ++i) {
+    stripePaths.emplace_back();
+    std::getline(m_configFile, stripePaths.back(), '\0');
+  }
+  if(!m_configFile) {
+    return ErrorCode::E_STORAGE_INVALID_CONFIG;
+  }
 
-  m_pageFiller.resize(getPageSize(),'\0');
-  m_dataFile.seekg(0,std::ios_base::end);
-  m_size = bytesToPage(m_dataFile.tellg());
+  ErrorCode err = openDataFiles( path, stripePaths, 0 );
+  if(err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  m_ioStats.reset();
 
   m_opened = true;
   return ErrorCode::E_NO_ERROR;
 }
 
-ErrorCode FileStorage::create( const std::string& path, 
-                               const FileStorageConfig& config, 
-                               const bool& overwrite ) noexcept {
+ErrorCode FileStorage::create( const std::string& path,
+                               const FileStorageConfig& config,
+                               const bool& overwrite,
+                               const std::vector<std::string>& stripePaths ) noexcept {
   assert(!m_opened && "FileStorage is already opened ");
 
-  if(!overwrite && std::ifstream(path)) {
+  if(!overwrite && !config.m_inMemory && std::ifstream(path)) {
     return ErrorCode::E_STORAGE_PATH_ALREADY_EXISTS;
   }
 
-  m_dataFile.open( path, m_flags | std::ios_base::trunc );
-  if(!m_dataFile) {
-    return ErrorCode::E_STORAGE_INVALID_PATH;
+  // Stripes without an explicit path are placed next to the first one
+  std::vector<std::string> paths(stripePaths);
+  for(uint32_t i = paths.size() + 1; i < config.m_numStripes; ++i) {
+    paths.push_back(path + "." + std::to_string(i));
+  }
+
+  m_config = config;
+  ErrorCode err = openDataFiles( path, paths, O_CREAT | O_TRUNC );
+  if(err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  m_ioStats.reset();
+
+  // In-memory storages are discarded when closed, so their configuration is
+  // not persisted either
+  if(m_config.m_inMemory) {
+    m_opened = true;
+    return ErrorCode::E_NO_ERROR;
   }
 
   m_configFile.open( path+std::string(".config"), m_flags | std::ios_base::trunc );
@@ -67,20 +203,26 @@ ErrorCode FileStorage::create( const std::string& path,
     return ErrorCode::E_STORAGE_INVALID_PATH;
   }
 
-  m_config = config;
-  m_pageFiller.resize(getPageSize(),'\0');
-  m_size = bytesToPage(m_dataFile.tellg());
-
   // Reserve space in m_configFile
   m_configFile.seekp(0,std::ios_base::beg);
-  m_configFile.write(m_pageFiller.data(), m_pageFiller.size());
+  m_configFile.write(p_pageFiller, getPageSize());
   if(!m_configFile) {
     return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
   }
 
   // Write FileStorageConfig in the first page of m_configFile
+  size_t configSize = sizeof(m_config);
+  for(const std::string& stripePath : paths) {
+    configSize += stripePath.size() + 1;
+  }
+  if(configSize > getPageSize()) {
+    return ErrorCode::E_STORAGE_INVALID_CONFIG;
+  }
   m_configFile.seekp(0,std::ios_base::beg);
   m_configFile.write(reinterpret_cast<char*>(&m_config), sizeof(m_config));
+  for(const std::string& stripePath : paths) {
+    m_configFile.write(stripePath.c_str(), stripePath.size() + 1);
+  }
   m_configFile.flush();
   if(!m_configFile) {
     return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
@@ -93,9 +235,26 @@ ErrorCode FileStorage::create( const std::string& path,
 ErrorCode FileStorage::close() noexcept {
   assert(m_opened && "FileSotrage is not opened");
 
-  if(m_dataFile) {
-    m_dataFile.close();
+  if(p_mapping != nullptr) {
+    unmap();
+  }
+
+  for(int dataFile : m_dataFiles) {
+    ::close(dataFile);
   }
+  m_dataFiles.clear();
+  m_devices.clear();
+  m_writtenRanges.clear();
+  m_writeBackRanges.clear();
+
+  if(m_checksumFile != -1) {
+    ::close(m_checksumFile);
+    m_checksumFile = -1;
+  }
+  p_checksumIndex = nullptr;
+  m_checksumIndexCapacity = 0;
+  m_checksumChunks.clear();
+  m_checksumIndexes.clear();
 
   if(m_configFile) {
     m_configFile.close();
@@ -105,58 +264,659 @@ ErrorCode FileStorage::close() noexcept {
   return ErrorCode::E_NO_ERROR;
 }
 
-ErrorCode FileStorage::reserve( const uint32_t& numPages, 
+ErrorCode FileStorage::reserve( const uint32_t& numPages,
                                 pageId_t* pageId ) noexcept {
 
   assert(m_opened && "FileStorage is closed");
 
-  m_dataFile.seekp(0,std::ios_base::end);
-  if(!m_dataFile) {
-    return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+  std::lock_guard<std::mutex> guard(m_reserveLock);
+  assert(p_mapping == nullptr && "Unable to grow a mapped storage");
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  // Each file grows with a single fallocate, which allocates the blocks of
+  // all its new pages at once so that later writes do not need to extend
+  // the file. Where fallocate is not supported, writing the new last page
+  // leaves the pages in between as a hole, which reads back as zeros.
+  pageId_t first = m_size;
+  for(uint32_t i = 0; i < m_dataFiles.size(); ++i) {
+    pageId_t begin = stripeSize(i, first);
+    pageId_t end = stripeSize(i, first+numPages);
+    if(begin == end) {
+      continue;
+    }
+    int res = -1;
+    do {
+      res = fallocate(m_dataFiles[i], 0, pageToBytes(begin), pageToBytes(end-begin));
+    } while(res != 0 && errno == EINTR);
+    if(res != 0 && errno != EOPNOTSUPP) {
+      return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    }
+    if(res != 0 && !pwriteFully(m_dataFiles[i], p_pageFiller, getPageSize(), pageToBytes(end-1))) {
+      return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    }
+  }
+
+  // New pages read back as the filler, so they get its checksum
+  if(m_checksumFile != -1) {
+    ErrorCode err = growChecksums(first + numPages);
+    if(err == ErrorCode::E_NO_ERROR) {
+      err = storeChecksums(first, numPages, nullptr);
+    }
+    if(err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+  }
+
+  *pageId = first;
+  m_size = first + numPages;
+  m_ioStats.recordLatency(IOOperation::E_RESERVE, std::chrono::steady_clock::now() - start);
+  m_ioStats.countReserve();
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::discard( const pageId_t& firstPage,
+                                uint64_t numPages ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(firstPage+numPages <= m_size && "Invalid page range");
+  assert(p_mapping == nullptr && "Unable to discard pages of a mapped storage");
+
+  // Holes read back as zeros, just like the filler of new pages. Each stripe
+  // may live on a file system of its own, so one that does not support hole
+  // punching does not keep the others from being discarded.
+  std::vector<bool> punched(m_dataFiles.size(), false);
+  for(uint32_t i = 0; i < m_dataFiles.size(); ++i) {
+    pageId_t begin = stripeSize(i, firstPage);
+    pageId_t end = stripeSize(i, firstPage+numPages);
+    if(begin == end) {
+      continue;
+    }
+    int res = -1;
+    do {
+      res = fallocate(m_dataFiles[i], FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, pageToBytes(begin), pageToBytes(end-begin));
+    } while(res != 0 && errno == EINTR);
+    if(res != 0 && errno != EOPNOTSUPP) {
+      return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    }
+    punched[i] = (res == 0);
+  }
+
+  if(m_checksumFile == -1) {
+    return ErrorCode::E_NO_ERROR;
   }
 
-  *pageId = bytesToPage(m_dataFile.tellp());
-  m_dataFile.seekp(pageToBytes((numPages-1)),std::ios_base::end);
-  m_dataFile.write(m_pageFiller.data(), m_pageFiller.size());
+  // Only the pages that were punched read back as new pages, the checksums
+  // of the others still match their contents
+  pageId_t page = firstPage;
+  while(page < firstPage+numPages) {
+    pageId_t unit = page / m_config.m_stripePages;
+    pageId_t next = std::min((unit+1)*m_config.m_stripePages, firstPage+numPages);
+    if(punched[unit % m_config.m_numStripes]) {
+      ErrorCode err = storeChecksums(page, next-page, nullptr);
+      if(err != ErrorCode::E_NO_ERROR) {
+        return err;
+      }
+    }
+    page = next;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::truncate( uint64_t numPages ) noexcept {
 
-  if(!m_dataFile) {
+  assert(m_opened && "FileStorage is closed");
+  assert(numPages <= m_size && "Unable to grow the storage by truncating it");
+
+  std::lock_guard<std::mutex> guard(m_reserveLock);
+  assert(p_mapping == nullptr && "Unable to shrink a mapped storage");
+
+  for(uint32_t i = 0; i < m_dataFiles.size(); ++i) {
+    if(ftruncate(m_dataFiles[i], pageToBytes(stripeSize(i, numPages))) != 0) {
+      return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    }
+  }
+  if(m_checksumFile != -1 && ftruncate(m_checksumFile, numPages*sizeof(uint32_t)) != 0) {
     return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
   }
 
-  m_size = bytesToPage(m_dataFile.tellp());
-  return ErrorCode::E_NO_ERROR; 
+  m_size = numPages;
+  return ErrorCode::E_NO_ERROR;
 }
 
-ErrorCode FileStorage::read( char* data, 
-                             const pageId_t& pageId ) noexcept {
+ErrorCode FileStorage::read( char* data,
+                             const pageId_t& pageId,
+                             bool verify ) noexcept {
 
   assert(m_opened && "FileStorage is closed");
   assert(pageId >= 0 && pageId < m_size && "Invalid page range");
 
-  m_dataFile.seekg(pageToBytes(pageId), std::ios_base::beg);
-  assert(m_dataFile && "FileStorage unexpected error");
+  // Direct transfers into unaligned buffers go through an aligned copy
+  char* target = data;
+  if(reinterpret_cast<uintptr_t>(data) % m_ioAlignment != 0) {
+    target = allocAligned(getPageSize(), m_ioAlignment);
+    if(target == nullptr) {
+      return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+    }
+  }
+
+  off_t offset;
+  int dataFile = locate(pageId, &offset);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool success = preadFully(dataFile, target, getPageSize(), offset);
+  waitForDevice(pageId, getPageSize());
+  m_ioStats.recordLatency(IOOperation::E_READ, std::chrono::steady_clock::now() - start);
+  m_ioStats.countTransfer(IOOperation::E_READ, 1, getPageSize());
+  if(target != data) {
+    memcpy(data, target, getPageSize());
+    free(target);
+  }
+
+  if(!success) {
+    assert(false && "FileStorage unexpected read error");
+    return ErrorCode::E_STORAGE_UNEXPECTED_READ_ERROR;
+  }
 
-  m_dataFile.read(data,getPageSize());
-  assert(m_dataFile && "FileStorage unexpected read error");
+  if(verify && m_checksumFile != -1) {
+    return verifyChecksums(pageId, 1, &data);
+  }
 
   return ErrorCode::E_NO_ERROR;
 }
 
-ErrorCode FileStorage::write( const char* data, 
+ErrorCode FileStorage::write( const char* data,
                               const pageId_t& pageId ) noexcept {
 
   assert(m_opened && "FileStorage is closed");
   assert(pageId >= 0 && pageId < m_size && "Invalid page range");
 
-  m_dataFile.seekp(pageToBytes(pageId), std::ios_base::beg);
-  assert(m_dataFile && "FileStorage unexpected error");
+  // Direct transfers from unaligned buffers go through an aligned copy
+  const char* source = data;
+  if(reinterpret_cast<uintptr_t>(data) % m_ioAlignment != 0) {
+    char* copy = allocAligned(getPageSize(), m_ioAlignment);
+    if(copy == nullptr) {
+      return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+    }
+    memcpy(copy, data, getPageSize());
+    source = copy;
+  }
+
+  off_t offset;
+  int dataFile = locate(pageId, &offset);
+  trackWrite(pageId, getPageSize());
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool success = pwriteFully(dataFile, source, getPageSize(), offset);
+  waitForDevice(pageId, getPageSize());
+  m_ioStats.recordLatency(IOOperation::E_WRITE, std::chrono::steady_clock::now() - start);
+  m_ioStats.countTransfer(IOOperation::E_WRITE, 1, getPageSize());
+  if(source != data) {
+    free(const_cast<char*>(source));
+  }
+
+  if(!success) {
+    assert(false && "FileStorage unexpected write error");
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+
+  if(m_checksumFile != -1) {
+    return storeChecksums(pageId, 1, &data);
+  }
+
+  return ErrorCode::E_NO_ERROR;
+}
+
+bool FileStorage::isAligned( const char* const* data,
+                             uint32_t numPages ) const noexcept {
+  for(uint32_t i = 0; i < numPages; ++i) {
+    if(reinterpret_cast<uintptr_t>(data[i]) % m_ioAlignment != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ErrorCode FileStorage::loadChecksums() noexcept {
+  p_checksumIndex = nullptr;
+  m_checksumIndexCapacity = 0;
+  m_checksumChunks.clear();
+  m_checksumIndexes.clear();
+  ErrorCode err = growChecksums(m_size);
+  if(err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+
+  // The file is shorter than the data if a crash lost the checksums of
+  // the last pages reserved, which still read back as the filler
+  struct stat fileStat;
+  if(fstat(m_checksumFile, &fileStat) != 0) {
+    return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+  }
+  pageId_t numStored = std::min<pageId_t>(fileStat.st_size / sizeof(uint32_t), m_size);
+  std::vector<uint32_t> checksums(CHECKSUMS_PER_CHUNK);
+  for(pageId_t first = 0; first < m_size; first += CHECKSUMS_PER_CHUNK) {
+    uint64_t numPages = std::min<pageId_t>(m_size - first, CHECKSUMS_PER_CHUNK);
+    uint64_t numRead = first < numStored ? std::min<pageId_t>(numStored - first, numPages) : 0;
+    if(numRead > 0 && !preadFully(m_checksumFile, reinterpret_cast<char*>(checksums.data()), 
+                                  numRead*sizeof(uint32_t), first*sizeof(uint32_t))) {
+      return ErrorCode::E_STORAGE_UNEXPECTED_READ_ERROR;
+    }
+    for(uint64_t i = 0; i < numPages; ++i) {
+      getChecksum(first+i).store(i < numRead ? checksums[i] : m_fillerChecksum, std::memory_order_relaxed);
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::growChecksums( pageId_t numPages ) noexcept {
+  uint64_t numChunks = (numPages + CHECKSUMS_PER_CHUNK - 1) / CHECKSUMS_PER_CHUNK;
+  if(numChunks > m_checksumIndexCapacity) {
+    uint64_t capacity = std::max<uint64_t>(numChunks, 2*m_checksumIndexCapacity);
+    std::unique_ptr<ChecksumChunk*[]> index(new (std::nothrow) ChecksumChunk*[capacity]);
+    if(!index) {
+      return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+    }
+    for(uint64_t i = 0; i < m_checksumChunks.size(); ++i) {
+      index[i] = m_checksumChunks[i].get();
+    }
+    p_checksumIndex.store(index.get(), std::memory_order_release);
+    m_checksumIndexes.push_back(std::move(index));
+    m_checksumIndexCapacity = capacity;
+  }
+
+  // New chunks are only reached through the current index, by pages that
+  // exist once the storage has grown
+  ChecksumChunk** index = p_checksumIndex.load(std::memory_order_relaxed);
+  while(m_checksumChunks.size() < numChunks) {
+    std::unique_ptr<ChecksumChunk> chunk(new (std::nothrow) ChecksumChunk());
+    if(!chunk) {
+      return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+    }
+    index[m_checksumChunks.size()] = chunk.get();
+    m_checksumChunks.push_back(std::move(chunk));
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+std::atomic<uint32_t>& FileStorage::getChecksum( const pageId_t& pageId ) const noexcept {
+  ChecksumChunk* chunk = p_checksumIndex.load(std::memory_order_acquire)[pageId / CHECKSUMS_PER_CHUNK];
+  return chunk->m_checksums[pageId % CHECKSUMS_PER_CHUNK];
+}
+
+ErrorCode FileStorage::storeChecksums( const pageId_t& firstPage,
+                                       uint64_t numPages,
+                                       const char* const* data ) noexcept {
+  std::vector<uint32_t> checksums(numPages, m_fillerChecksum);
+  for(uint64_t i = 0; i < numPages; ++i) {
+    if(data != nullptr) {
+      checksums[i] = computeCRC32C(data[i], getPageSize());
+    }
+    getChecksum(firstPage+i).store(checksums[i], std::memory_order_relaxed);
+  }
+  if(!pwriteFully(m_checksumFile, reinterpret_cast<const char*>(checksums.data()), 
+                  numPages*sizeof(uint32_t), firstPage*sizeof(uint32_t))) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::verifyChecksums( const pageId_t& firstPage,
+                                        uint32_t numPages,
+                                        const char* const* data ) noexcept {
+  for(uint32_t i = 0; i < numPages; ++i) {
+    if(getChecksum(firstPage+i).load(std::memory_order_relaxed) != computeCRC32C(data[i], getPageSize())) {
+      return ErrorCode::E_STORAGE_CHECKSUM_MISMATCH;
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::verify( const char* data,
+                               const pageId_t& pageId ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(pageId >= 0 && pageId < m_size && "Invalid page range");
+
+  if(m_checksumFile == -1) {
+    return ErrorCode::E_NO_ERROR;
+  }
+  return verifyChecksums(pageId, 1, &data);
+}
+
+ErrorCode FileStorage::readRange( const pageId_t& firstPage,
+                                  uint32_t numPages,
+                                  char* const* data,
+                                  bool verify ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(firstPage >= 0 && firstPage+numPages <= m_size && "Invalid page range");
+
+  // Unaligned buffers cannot be transferred directly, so they are read
+  // page by page through the bounce buffer of read()
+  if(!isAligned(data, numPages)) {
+    for(uint32_t i = 0; i < numPages; ++i) {
+      ErrorCode err = read(data[i], firstPage+i, verify);
+      if(err != ErrorCode::E_NO_ERROR) {
+        return err;
+      }
+    }
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  std::vector<struct iovec> iov(numPages);
+  for(uint32_t i = 0; i < numPages; ++i) {
+    iov[i].iov_base = data[i];
+    iov[i].iov_len = getPageSize();
+  }
+
+  // The range is split at stripe boundaries, each part being contiguous in
+  // its file
+  for(uint32_t i = 0; i < numPages; ) {
+    uint32_t length = std::min<uint32_t>(numPages - i, getContiguousPages(firstPage+i));
+    off_t offset;
+    int dataFile = locate(firstPage+i, &offset);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if(!transferVectorFully(true, dataFile, &iov[i], length, offset)) {
+      assert(false && "FileStorage unexpected read error");
+      return ErrorCode::E_STORAGE_UNEXPECTED_READ_ERROR;
+    }
+    waitForDevice(firstPage+i, pageToBytes(length));
+    m_ioStats.recordLatency(IOOperation::E_READ, std::chrono::steady_clock::now() - start);
+    m_ioStats.countTransfer(IOOperation::E_READ, length, pageToBytes(length));
+    i += length;
+  }
+
+  if(verify && m_checksumFile != -1) {
+    return verifyChecksums(firstPage, numPages, data);
+  }
+
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::writeRange( const pageId_t& firstPage,
+                                   uint32_t numPages,
+                                   const char* const* data ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(firstPage >= 0 && firstPage+numPages <= m_size && "Invalid page range");
+
+  if(!isAligned(data, numPages)) {
+    for(uint32_t i = 0; i < numPages; ++i) {
+      ErrorCode err = write(data[i], firstPage+i);
+      if(err != ErrorCode::E_NO_ERROR) {
+        return err;
+      }
+    }
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  std::vector<struct iovec> iov(numPages);
+  for(uint32_t i = 0; i < numPages; ++i) {
+    iov[i].iov_base = const_cast<char*>(data[i]);
+    iov[i].iov_len = getPageSize();
+  }
+
+  for(uint32_t i = 0; i < numPages; ) {
+    uint32_t length = std::min<uint32_t>(numPages - i, getContiguousPages(firstPage+i));
+    off_t offset;
+    int dataFile = locate(firstPage+i, &offset);
+    trackWrite(firstPage+i, pageToBytes(length));
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if(!transferVectorFully(false, dataFile, &iov[i], length, offset)) {
+      assert(false && "FileStorage unexpected write error");
+      return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    }
+    waitForDevice(firstPage+i, pageToBytes(length));
+    m_ioStats.recordLatency(IOOperation::E_WRITE, std::chrono::steady_clock::now() - start);
+    m_ioStats.countTransfer(IOOperation::E_WRITE, length, pageToBytes(length));
+    i += length;
+  }
+
+  if(m_checksumFile != -1) {
+    return storeChecksums(firstPage, numPages, data);
+  }
+
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::readAsync( IOEngine* engine,
+                                  char* data,
+                                  const pageId_t& pageId,
+                                  uint64_t tag,
+                                  bool linkNext ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(pageId >= 0 && pageId < m_size && "Invalid page range");
+  assert(reinterpret_cast<uintptr_t>(data) % m_ioAlignment == 0 && "Misaligned asynchronous read");
+
+  off_t offset;
+  int dataFile = locate(pageId, &offset);
+  delayOnDevice(engine, pageId, getPageSize());
+  ErrorCode err = engine->prepareRead(dataFile, data, getPageSize(), offset, tag, linkNext);
+  if(err == ErrorCode::E_NO_ERROR) {
+    m_ioStats.countTransfer(IOOperation::E_READ, 1, getPageSize());
+  }
+  return err;
+}
+
+ErrorCode FileStorage::writeAsync( IOEngine* engine,
+                                   const char* data,
+                                   const pageId_t& pageId,
+                                   uint64_t tag,
+                                   bool linkNext ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(pageId >= 0 && pageId < m_size && "Invalid page range");
+  assert(reinterpret_cast<uintptr_t>(data) % m_ioAlignment == 0 && "Misaligned asynchronous write");
+
+  // The checksum is only stored for a write the engine has room for
+  if(m_checksumFile != -1) {
+    if(engine->inFlight() >= engine->queueDepth()) {
+      return ErrorCode::E_STORAGE_IO_QUEUE_FULL;
+    }
+    ErrorCode err = storeChecksums(pageId, 1, &data);
+    if(err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+  }
 
-  m_dataFile.write(data,getPageSize());
-  assert(m_dataFile && "FileStorage unexpected read error");
+  off_t offset;
+  int dataFile = locate(pageId, &offset);
+  delayOnDevice(engine, pageId, getPageSize());
+  ErrorCode err = engine->prepareWrite(dataFile, data, getPageSize(), offset, tag, linkNext);
+  if(err == ErrorCode::E_NO_ERROR) {
+    trackWrite(pageId, getPageSize());
+    m_ioStats.countTransfer(IOOperation::E_WRITE, 1, getPageSize());
+  }
+  return err;
+}
 
+ErrorCode FileStorage::readRangeAsync( IOEngine* engine,
+                                       const struct iovec* iov,
+                                       const pageId_t& firstPage,
+                                       uint32_t numPages,
+                                       uint64_t tag,
+                                       bool linkNext ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(firstPage >= 0 && firstPage+numPages <= m_size && "Invalid page range");
+  assert(numPages <= getContiguousPages(firstPage) && "Page range spans several stripes");
+
+  off_t offset;
+  int dataFile = locate(firstPage, &offset);
+  delayOnDevice(engine, firstPage, pageToBytes(numPages));
+  ErrorCode err = engine->prepareReadv(dataFile, iov, numPages, offset, tag, linkNext);
+  if(err == ErrorCode::E_NO_ERROR) {
+    m_ioStats.countTransfer(IOOperation::E_READ, numPages, pageToBytes(numPages));
+  }
+  return err;
+}
+
+ErrorCode FileStorage::writeRangeAsync( IOEngine* engine,
+                                        const struct iovec* iov,
+                                        const pageId_t& firstPage,
+                                        uint32_t numPages,
+                                        uint64_t tag,
+                                        bool linkNext ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(firstPage >= 0 && firstPage+numPages <= m_size && "Invalid page range");
+  assert(numPages <= getContiguousPages(firstPage) && "Page range spans several stripes");
+
+  if(m_checksumFile != -1) {
+    if(engine->inFlight() >= engine->queueDepth()) {
+      return ErrorCode::E_STORAGE_IO_QUEUE_FULL;
+    }
+    std::vector<const char*> data(numPages);
+    for(uint32_t i = 0; i < numPages; ++i) {
+      data[i] = static_cast<const char*>(iov[i].iov_base);
+    }
+    ErrorCode err = storeChecksums(firstPage, numPages, data.data());
+    if(err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+  }
+
+  off_t offset;
+  int dataFile = locate(firstPage, &offset);
+  delayOnDevice(engine, firstPage, pageToBytes(numPages));
+  ErrorCode err = engine->prepareWritev(dataFile, iov, numPages, offset, tag, linkNext);
+  if(err == ErrorCode::E_NO_ERROR) {
+    trackWrite(firstPage, pageToBytes(numPages));
+    m_ioStats.countTransfer(IOOperation::E_WRITE, numPages, pageToBytes(numPages));
+  }
+  return err;
+}
+
+ErrorCode FileStorage::map( const char** data ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(p_mapping == nullptr && "FileStorage is already mapped");
+
+  std::lock_guard<std::mutex> guard(m_reserveLock);
+  m_mappingSize = pageToBytes(m_size);
+  if(m_mappingSize > 0) {
+    void* mapping = mmap(nullptr, m_mappingSize, PROT_READ, MAP_SHARED, m_dataFiles[0], 0);
+    if(m_dataFiles.size() > 1 && mapping != MAP_FAILED) {
+      // Every stripe is mapped in place over the address range reserved by
+      // the first mapping, so that pages stay contiguous in memory
+      for(pageId_t page = 0; page < m_size && mapping != MAP_FAILED; page += m_config.m_stripePages) {
+        off_t offset;
+        int dataFile = locate(page, &offset);
+        size_t length = pageToBytes(std::min<pageId_t>(m_config.m_stripePages, m_size - page));
+        if(mmap(static_cast<char*>(mapping) + pageToBytes(page), length, PROT_READ, 
+                MAP_SHARED | MAP_FIXED, dataFile, offset) == MAP_FAILED) {
+          munmap(mapping, m_mappingSize);
+          mapping = MAP_FAILED;
+        }
+      }
+    }
+    if(mapping == MAP_FAILED) {
+      m_mappingSize = 0;
+      return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+    }
+    p_mapping = static_cast<char*>(mapping);
+  }
+
+  *data = p_mapping;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::unmap() noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+
+  if(p_mapping != nullptr && munmap(p_mapping, m_mappingSize) != 0) {
+    return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+  }
+  p_mapping = nullptr;
+  m_mappingSize = 0;
   return ErrorCode::E_NO_ERROR;
 }
 
+ErrorCode FileStorage::adviseMapping( AccessPattern pattern,
+                                      const pageId_t& firstPage,
+                                      uint64_t numPages ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(pageToBytes(firstPage+numPages) <= m_mappingSize && "Invalid page range");
+
+  if(p_mapping == nullptr || numPages == 0) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  int advice = MADV_NORMAL;
+  switch(pattern) {
+    case AccessPattern::E_NORMAL:
+      advice = MADV_NORMAL;
+      break;
+    case AccessPattern::E_SEQUENTIAL:
+      advice = MADV_SEQUENTIAL;
+      break;
+    case AccessPattern::E_RANDOM:
+      advice = MADV_RANDOM;
+      break;
+    case AccessPattern::E_WILL_NEED:
+      advice = MADV_WILLNEED;
+      break;
+    case AccessPattern::E_DONT_NEED:
+      advice = MADV_DONTNEED;
+      break;
+  }
+
+  // madvise requires the range to start at a memory page boundary
+  size_t begin = pageToBytes(firstPage);
+  size_t offset = begin % Platform::getSystemPageSize();
+  if(madvise(p_mapping+begin-offset, pageToBytes(numPages)+offset, advice) != 0) {
+    return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode FileStorage::adviseFile( AccessPattern pattern,
+                                   const pageId_t& firstPage,
+                                   uint64_t numPages ) noexcept {
+
+  assert(m_opened && "FileStorage is closed");
+  assert(firstPage+numPages <= m_size && "Invalid page range");
+
+  if(m_config.m_directIO || numPages == 0) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  int advice = POSIX_FADV_NORMAL;
+  switch(pattern) {
+    case AccessPattern::E_NORMAL:
+      advice = POSIX_FADV_NORMAL;
+      break;
+    case AccessPattern::E_SEQUENTIAL:
+      advice = POSIX_FADV_SEQUENTIAL;
+      break;
+    case AccessPattern::E_RANDOM:
+      advice = POSIX_FADV_RANDOM;
+      break;
+    case AccessPattern::E_WILL_NEED:
+      advice = POSIX_FADV_WILLNEED;
+      break;
+    case AccessPattern::E_DONT_NEED:
+      advice = POSIX_FADV_DONTNEED;
+      break;
+  }
+
+  // The pages of the range stored in each data file are contiguous in it
+  for(uint32_t i = 0; i < m_dataFiles.size(); ++i) {
+    pageId_t begin = stripeSize(i, firstPage);
+    pageId_t end = stripeSize(i, firstPage+numPages);
+    if(begin != end && 
+       posix_fadvise(m_dataFiles[i], pageToBytes(begin), pageToBytes(end-begin), advice) != 0) {
+      return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+    }
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+void FileStorage::getIOStatistics( IOStatistics* stats ) const noexcept {
+  m_ioStats.snapshot(stats);
+}
+
 size_t FileStorage::size() const noexcept {
   return m_size;
 }
@@ -169,6 +929,140 @@ size_t FileStorage::getPageSize() const noexcept {
   return m_config.m_pageSizeKB*1024;
 }
 
+size_t FileStorage::getIOAlignment() const noexcept {
+  return m_ioAlignment;
+}
+
+uint32_t FileStorage::getContiguousPages( const pageId_t& pageId ) const noexcept {
+  if(m_config.m_numStripes == 1) {
+    return std::numeric_limits<uint32_t>::max();
+  }
+  return m_config.m_stripePages - pageId % m_config.m_stripePages;
+}
+
+int FileStorage::locate( const pageId_t& pageId,
+                         off_t* offset ) const noexcept {
+  if(m_config.m_numStripes == 1) {
+    *offset = pageToBytes(pageId);
+    return m_dataFiles[0];
+  }
+  pageId_t unit = pageId / m_config.m_stripePages;
+  pageId_t localPage = (unit / m_config.m_numStripes) * m_config.m_stripePages + pageId % m_config.m_stripePages;
+  *offset = pageToBytes(localPage);
+  return m_dataFiles[unit % m_config.m_numStripes];
+}
+
+ErrorCode FileStorage::writeBack() noexcept {
+  assert(m_opened && "FileStorage is closed");
+
+  if(m_config.m_directIO) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  for(uint32_t i = 0; i < m_dataFiles.size(); ++i) {
+    FileRange written;
+    {
+      std::lock_guard<std::mutex> guard(m_writeBackLock);
+      std::swap(written, m_writtenRanges[i]);
+    }
+
+    // The write-back started by the previous call has had a whole period to
+    // complete, so waiting for it is usually short. The pages are dropped
+    // from the kernel cache afterwards, as the Buffer Pool keeps its own
+    // copies.
+    FileRange& started = m_writeBackRanges[i];
+    if(started.m_begin < started.m_end) {
+      if(sync_file_range(m_dataFiles[i], started.m_begin, started.m_end - started.m_begin, 
+                         SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) != 0) {
+        return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+      }
+      posix_fadvise(m_dataFiles[i], started.m_begin, started.m_end - started.m_begin, POSIX_FADV_DONTNEED);
+    }
+
+    // The write-back of the pages written since the previous call starts
+    // without waiting for it
+    if(written.m_begin < written.m_end && 
+       sync_file_range(m_dataFiles[i], written.m_begin, written.m_end - written.m_begin, SYNC_FILE_RANGE_WRITE) != 0) {
+      return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    }
+    started = written;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+void FileStorage::trackWrite( const pageId_t& pageId,
+                              size_t size ) noexcept {
+  if(m_config.m_directIO) {
+    return;
+  }
+  off_t offset;
+  locate(pageId, &offset);
+  uint32_t stripe = (pageId / m_config.m_stripePages) % m_config.m_numStripes;
+  std::lock_guard<std::mutex> guard(m_writeBackLock);
+  FileRange& range = m_writtenRanges[stripe];
+  range.m_begin = std::min<uint64_t>(range.m_begin, offset);
+  range.m_end = std::max<uint64_t>(range.m_end, offset + size);
+}
+
+ErrorCode FileStorage::sync() noexcept {
+  assert(m_opened && "FileStorage is closed");
+
+  for(int dataFile : m_dataFiles) {
+    if(fdatasync(dataFile) != 0) {
+      return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    }
+  }
+  if(m_checksumFile != -1 && fdatasync(m_checksumFile) != 0) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+void FileStorage::setDeviceProfile( const DeviceProfile& profile ) noexcept {
+  assert(m_opened && "FileStorage is closed");
+
+  m_devices.clear();
+  if(profile.isEnabled()) {
+    for(uint32_t i = 0; i < m_config.m_numStripes; ++i) {
+      m_devices.push_back(std::make_unique<DeviceModel>(profile));
+    }
+  }
+}
+
+void FileStorage::waitForDevice( const pageId_t& pageId,
+                                 size_t size ) noexcept {
+  if(!m_devices.empty()) {
+    off_t offset;
+    locate(pageId, &offset);
+    uint32_t stripe = (pageId / m_config.m_stripePages) % m_config.m_numStripes;
+    std::this_thread::sleep_until(m_devices[stripe]->schedule(offset, size));
+  }
+}
+
+void FileStorage::delayOnDevice( IOEngine* engine,
+                                 const pageId_t& pageId,
+                                 size_t size ) noexcept {
+  if(!m_devices.empty()) {
+    off_t offset;
+    locate(pageId, &offset);
+    uint32_t stripe = (pageId / m_config.m_stripePages) % m_config.m_numStripes;
+    engine->delayNext(m_devices[stripe]->schedule(offset, size));
+  }
+}
+
+pageId_t FileStorage::stripeSize( uint32_t stripe,
+                                  pageId_t numPages ) const noexcept {
+  pageId_t units = numPages / m_config.m_stripePages;
+  pageId_t size = (units / m_config.m_numStripes) * m_config.m_stripePages;
+  if(stripe < units % m_config.m_numStripes) {
+    size += m_config.m_stripePages;
+  }
+  else if(stripe == units % m_config.m_numStripes) {
+    size += numPages % m_config.m_stripePages;
+  }
+  return size;
+}
+
 pageId_t FileStorage::bytesToPage( const size_t& bytes ) const noexcept {
   return bytes / getPageSize();
 }
@@ -4,14 +4,58 @@
 
 #include "../base/base.h"
 #include "types.h"
+#include "device_model.h"
+#include "io_engine.h"
+#include "io_statistics.h"
+#include <memory>
 #include <vector>
+#include <atomic>
+#include <limits>
+#include <mutex>
 
 #include <fstream>
 
 SMILE_NS_BEGIN
 
+// The number of page checksums held in each chunk in memory
+#define CHECKSUMS_PER_CHUNK 16384
+
 struct FileStorageConfig {
   uint32_t  m_pageSizeKB = 64;
+
+  /**
+   * Whether the data file is accessed with O_DIRECT, bypassing the kernel
+   * page cache. The page size must be a multiple of the I/O alignment.
+   */
+  bool      m_directIO = false;
+
+  /**
+   * Whether a CRC32C checksum of every page is kept. It is computed and
+   * written to a sidecar file when the page is written, and verified
+   * against a copy held in memory when it is read. Both files are only
+   * durable after sync(), so a system crash may leave pages written after
+   * it with a stale checksum. Off by default, as verification still adds
+   * about 6% to a scan served from the page cache.
+   */
+  bool      m_checksums = false;
+
+  /**
+   * Number of data files the pages are striped across. The files can be
+   * placed on different devices, which are then accessed in parallel.
+   */
+  uint32_t  m_numStripes = 1;
+
+  /**
+   * Number of consecutive pages stored in a data file before moving to the
+   * next one, round-robin.
+   */
+  uint32_t  m_stripePages = 16;
+
+  /**
+   * Keeps the pages in anonymous memory files instead of on disk. Nothing
+   * is persisted, so the storage cannot be opened again once closed.
+   */
+  bool      m_inMemory = false;
 };
 
 class FileStorage final {
@@ -33,10 +77,14 @@ class FileStorage final {
      * Opens the file storage at the given path
      * @param in the path to the storage to create
      * @return in the configuration of the storage
+     * @param in stripePaths The paths of the data files of the stripes
+     * after the first one, which is stored at path. Missing ones are stored
+     * at path.1, path.2, ...
      **/
     ErrorCode create( const std::string& path, 
                       const FileStorageConfig& config, 
-                      const bool& overwrite = false ) noexcept;
+                      const bool& overwrite = false,
+                      const std::vector<std::string>& stripePaths = {} ) noexcept;
 
     /**
      * Closes the storage
@@ -54,16 +102,41 @@ class FileStorage final {
                        pageId_t* pageId ) noexcept;
 
     /**
-     * Locks a pages into a buffer
+     * Gives the space of a range of pages back to the file system by
+     * punching holes in the data files. The pages stay in the storage and
+     * read back as new pages. The pages of a stripe whose file system does
+     * not support hole punching are left as they are, the other stripes
+     * are still discarded.
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @return E_NO_ERROR if the range was discarded correctly
+     **/
+    ErrorCode discard( const pageId_t& firstPage,
+                       uint64_t numPages ) noexcept;
+
+    /**
+     * Shrinks the storage, removing the pages from the given one to the end
+     * @param in numPages The new size of the storage in pages
+     * @return E_NO_ERROR if the storage was shrunk correctly
+     **/
+    ErrorCode truncate( uint64_t numPages ) noexcept;
+
+    /**
+     * Locks a pages into a buffer. Reads are positional, so concurrent calls
+     * from different threads do not interfere with each other.
      * @param in data The buffer where the page will be locked
      * @param in pageId The page to lock
-     * @return false if the lock was not successful. true otherwise
+     * @param in verify Whether to verify the checksum of the page, if the
+     * storage keeps checksums
+     * @return E_STORAGE_CHECKSUM_MISMATCH if the page is corrupted
      * */
     ErrorCode read( char* data, 
-                    const pageId_t& pageId ) noexcept;
+                    const pageId_t& pageId,
+                    bool verify = true ) noexcept;
 
     /**
-     * Unlocks the given page
+     * Unlocks the given page. Writes are positional, so concurrent calls
+     * from different threads do not interfere with each other.
      * @param in data The buffer where the page was locked
      * @param in pageId The page to unlock
      * @return false if the unlock was unsuccessful. true otherwise.
@@ -71,6 +144,202 @@ class FileStorage final {
     ErrorCode write( const char* data, 
                      const pageId_t& pageId ) noexcept;
 
+    /**
+     * Reads a contiguous range of pages into several buffers with a single
+     * vectored read
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @param in data numPages buffers, one for each page of the range
+     * @param in verify Whether to verify the checksums of the pages, if the
+     * storage keeps checksums
+     * @return E_STORAGE_CHECKSUM_MISMATCH if any page is corrupted
+     **/
+    ErrorCode readRange( const pageId_t& firstPage,
+                         uint32_t numPages,
+                         char* const* data,
+                         bool verify = true ) noexcept;
+
+    /**
+     * Writes several buffers to a contiguous range of pages with a single
+     * vectored write
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @param in data numPages buffers, one for each page of the range
+     * @return false if the write was successful. true otherwise
+     **/
+    ErrorCode writeRange( const pageId_t& firstPage,
+                          uint32_t numPages,
+                          const char* const* data ) noexcept;
+
+    /**
+     * Verifies a page read by an asynchronous request against its checksum
+     * @param in data The contents of the page
+     * @param in pageId The page
+     * @return E_STORAGE_CHECKSUM_MISMATCH if the page is corrupted.
+     * E_NO_ERROR if it is not, or if the storage keeps no checksums.
+     **/
+    ErrorCode verify( const char* data,
+                      const pageId_t& pageId ) noexcept;
+
+    /**
+     * Prepares an asynchronous read of a page in the given engine. The
+     * buffer must stay valid until the completion is reaped, and it must be
+     * aligned to getIOAlignment(). The page is not verified, see verify().
+     * @param in engine The engine the request is prepared in
+     * @param in data The buffer where the page will be read
+     * @param in pageId The page to read
+     * @param in tag The tag reported in the completion of the request
+     * @param in linkNext Whether the next request prepared in the engine
+     * must wait for this one and be cancelled if it fails
+     * @return E_STORAGE_IO_QUEUE_FULL if the engine has no room for the
+     * request
+     **/
+    ErrorCode readAsync( IOEngine* engine,
+                         char* data,
+                         const pageId_t& pageId,
+                         uint64_t tag,
+                         bool linkNext = false ) noexcept;
+
+    /**
+     * Prepares an asynchronous write of a page in the given engine. The
+     * buffer must stay valid until the completion is reaped, and it must be
+     * aligned to getIOAlignment(). Its checksum is stored right away.
+     * @param in engine The engine the request is prepared in
+     * @param in data The buffer with the contents of the page
+     * @param in pageId The page to write
+     * @param in tag The tag reported in the completion of the request
+     * @param in linkNext Whether the next request prepared in the engine
+     * must wait for this one and be cancelled if it fails
+     * @return E_STORAGE_IO_QUEUE_FULL if the engine has no room for the
+     * request
+     **/
+    ErrorCode writeAsync( IOEngine* engine,
+                          const char* data,
+                          const pageId_t& pageId,
+                          uint64_t tag,
+                          bool linkNext = false ) noexcept;
+
+    /**
+     * Prepares an asynchronous vectored read of a contiguous range of pages
+     * in the given engine. The iovecs must hold one page each, be aligned to
+     * getIOAlignment() and stay valid until the completion is reaped. The
+     * pages are not verified, see verify().
+     * @param in engine The engine the request is prepared in
+     * @param in iov The buffers where the pages will be read
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @param in tag The tag reported in the completion of the request
+     * @param in linkNext Whether the next request prepared in the engine
+     * must wait for this one and be cancelled if it fails
+     * @return E_STORAGE_IO_QUEUE_FULL if the engine has no room for the
+     * request
+     **/
+    ErrorCode readRangeAsync( IOEngine* engine,
+                              const struct iovec* iov,
+                              const pageId_t& firstPage,
+                              uint32_t numPages,
+                              uint64_t tag,
+                              bool linkNext = false ) noexcept;
+
+    /**
+     * Prepares an asynchronous vectored write of a contiguous range of
+     * pages in the given engine. The iovecs must hold one page each, be
+     * aligned to getIOAlignment() and stay valid until the completion is
+     * reaped. Their checksums are stored right away.
+     * @param in engine The engine the request is prepared in
+     * @param in iov The buffers with the contents of the pages
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @param in tag The tag reported in the completion of the request
+     * @param in linkNext Whether the next request prepared in the engine
+     * must wait for this one and be cancelled if it fails
+     * @return E_STORAGE_IO_QUEUE_FULL if the engine has no room for the
+     * request
+     **/
+    ErrorCode writeRangeAsync( IOEngine* engine,
+                               const struct iovec* iov,
+                               const pageId_t& firstPage,
+                               uint32_t numPages,
+                               uint64_t tag,
+                               bool linkNext = false ) noexcept;
+
+    /**
+     * Maps the whole data file in memory for reading. Pages are then
+     * accessed in place, without copies, at data + page*getPageSize(). The
+     * storage cannot grow while it is mapped.
+     * @param out data The address of the mapping. nullptr if the storage is
+     * empty.
+     * @return E_STORAGE_CRITICAL_ERROR if the file could not be mapped
+     **/
+    ErrorCode map( const char** data ) noexcept;
+
+    /**
+     * Unmaps the data file mapped with map()
+     * @return E_NO_ERROR if the file was unmapped correctly
+     **/
+    ErrorCode unmap() noexcept;
+
+    /**
+     * Tells the kernel how a range of the mapped pages is going to be
+     * accessed
+     * @param in pattern The expected access pattern
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @return E_NO_ERROR if the hint was accepted
+     **/
+    ErrorCode adviseMapping( AccessPattern pattern,
+                             const pageId_t& firstPage,
+                             uint64_t numPages ) noexcept;
+
+    /**
+     * Tells the kernel how a range of pages is going to be read through the
+     * data files, so that it adapts its read-ahead and caching. Sequential
+     * and random hints apply to whole files. Pages accessed with direct I/O
+     * bypass the kernel cache, so the hint is ignored.
+     * @param in pattern The expected access pattern
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @return E_NO_ERROR if the hint was accepted
+     **/
+    ErrorCode adviseFile( AccessPattern pattern,
+                          const pageId_t& firstPage,
+                          uint64_t numPages ) noexcept;
+
+    /**
+     * Pushes the pages written to the data files to the devices in the
+     * background. Every call starts the write-back of the pages written
+     * since the previous one, and waits for the write-back started by the
+     * previous one to complete, dropping those pages from the kernel cache.
+     * Called periodically, it keeps the kernel from accumulating a backlog
+     * of dirty pages that sync() would stall behind. It does not make the
+     * pages durable. Ignored with direct I/O. It must not be called by
+     * several threads at once.
+     * @return E_NO_ERROR if the write-back was started correctly
+     **/
+    ErrorCode writeBack() noexcept;
+
+    /**
+     * Waits until all the pages written before the call are durable
+     * @return E_NO_ERROR if the data was flushed to the devices correctly
+     **/
+    ErrorCode sync() noexcept;
+
+    /**
+     * Emulates a slower device, delaying every request according to the
+     * given profile. Each stripe is a separate device. It must not be
+     * called while there are requests in progress.
+     * @param in profile The profile of the device. A disabled profile stops
+     * the emulation.
+     **/
+    void setDeviceProfile( const DeviceProfile& profile ) noexcept;
+
+    /**
+     * Gets the I/O performed on the storage since it was opened. It can be
+     * called while other threads perform I/O.
+     * @param out stats The snapshot to fill
+     **/
+    void getIOStatistics( IOStatistics* stats ) const noexcept;
+
     /**
      * Gets the current size of the storage in pages
      * @return The current size of the storage in pages
@@ -90,8 +359,152 @@ class FileStorage final {
      **/
     size_t getPageSize() const noexcept;
 
+    /**
+     * Gets the number of pages from the given one to the end of its stripe,
+     * which are contiguous in the same data file. Asynchronous range
+     * requests must not cross this limit.
+     *
+     * @param in pageId The first page
+     * @return The number of contiguous pages
+     **/
+    uint32_t getContiguousPages( const pageId_t& pageId ) const noexcept;
+
+    /**
+     * Gets the alignment in bytes required for the buffers passed to read
+     * and write to avoid an intermediate copy. With m_directIO enabled, it
+     * is the block size the device requires for direct transfers.
+     *
+     * @return The I/O alignment in bytes
+     **/
+    size_t getIOAlignment() const noexcept;
+
   private:
 
+    /**
+     * Opens one of the files of the storage, or creates it in memory
+     * @param in path The path to the file
+     * @param in flags Extra open flags
+     * @return The file descriptor, or -1 on failure
+     **/
+    int openFile( const std::string& path,
+                  int flags ) const noexcept;
+
+    /**
+     * Opens the data files with the flags required by the configuration and
+     * computes the I/O alignment and the size of the storage
+     * @param in path The path to the first data file
+     * @param in stripePaths The paths to the other data files
+     * @param in flags Extra open flags
+     * @return E_NO_ERROR if the files were opened correctly
+     **/
+    ErrorCode openDataFiles( const std::string& path,
+                             const std::vector<std::string>& stripePaths,
+                             int flags ) noexcept;
+
+    /**
+     * Finds where a page is stored
+     * @param in pageId The page
+     * @param out offset The offset of the page in its data file
+     * @return The descriptor of the data file of the page
+     **/
+    int locate( const pageId_t& pageId,
+                off_t* offset ) const noexcept;
+
+    /**
+     * Waits until the emulated device of a page has completed a request
+     * just sent to it, if a device profile is set
+     * @param in pageId The first page of the request
+     * @param in size The number of bytes of the request
+     **/
+    void waitForDevice( const pageId_t& pageId,
+                        size_t size ) noexcept;
+
+    /**
+     * Holds back the completion of the next request prepared in the engine
+     * until the emulated device of a page would complete it, if a device
+     * profile is set
+     * @param in engine The engine the request is prepared in
+     * @param in pageId The first page of the request
+     * @param in size The number of bytes of the request
+     **/
+    void delayOnDevice( IOEngine* engine,
+                        const pageId_t& pageId,
+                        size_t size ) noexcept;
+
+    /**
+     * Computes how many pages of a storage of the given size are stored in
+     * a data file
+     * @param in stripe The index of the data file
+     * @param in numPages The size of the storage in pages
+     * @return The number of pages in the data file
+     **/
+    pageId_t stripeSize( uint32_t stripe,
+                         pageId_t numPages ) const noexcept;
+
+    /**
+     * Checks whether all the given page buffers can be transferred directly
+     * @param in data The buffers to check
+     * @param in numPages The number of buffers
+     * @return true if all the buffers are aligned to the I/O alignment
+     **/
+    bool isAligned( const char* const* data,
+                    uint32_t numPages ) const noexcept;
+
+    /**
+     * Records that a range of contiguous pages is being written, so that
+     * the next writeBack() pushes it to the device
+     * @param in pageId The first page of the range
+     * @param in size The number of bytes written
+     **/
+    void trackWrite( const pageId_t& pageId,
+                     size_t size ) noexcept;
+
+    /**
+     * Loads the persisted checksums of the pages of the storage. Pages
+     * beyond the end of the checksum file get the checksum of the filler.
+     * @return E_NO_ERROR if the checksums were loaded correctly
+     **/
+    ErrorCode loadChecksums() noexcept;
+
+    /**
+     * Allocates the chunks holding the checksums of the given number of
+     * pages, if they are not allocated yet
+     * @param in numPages The number of pages
+     * @return E_STORAGE_CRITICAL_ERROR if the chunks could not be allocated
+     **/
+    ErrorCode growChecksums( pageId_t numPages ) noexcept;
+
+    /**
+     * Gets the checksum of a page
+     * @param in pageId The page, whose chunk must be allocated
+     * @return The checksum entry of the page
+     **/
+    std::atomic<uint32_t>& getChecksum( const pageId_t& pageId ) const noexcept;
+
+    /**
+     * Computes and stores the checksums of a range of pages, in memory and
+     * in the checksum file
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @param in data numPages buffers, one for each page of the range, or
+     * nullptr to store the checksum of the filler
+     * @return E_NO_ERROR if the checksums were stored correctly
+     **/
+    ErrorCode storeChecksums( const pageId_t& firstPage,
+                              uint64_t numPages,
+                              const char* const* data ) noexcept;
+
+    /**
+     * Verifies a range of pages against their stored checksums
+     * @param in firstPage The first page of the range
+     * @param in numPages The number of pages of the range
+     * @param in data numPages buffers, one for each page of the range
+     * @return E_STORAGE_CHECKSUM_MISMATCH if any page is corrupted
+     **/
+    ErrorCode verifyChecksums( const pageId_t& firstPage,
+                               uint32_t numPages,
+                               const char* const* data ) noexcept;
+
     /**
      * Converts a position in a file in bytes to their pageId counterpart
      * where this byte belongs to
@@ -108,20 +521,83 @@ class FileStorage final {
     size_t pageToBytes( const pageId_t& pageId ) const noexcept;
 
 
-    // The data file
-    std::fstream    m_dataFile;
+    // The descriptors of the data files, one per stripe
+    std::vector<int> m_dataFiles;
+
+    // Counters of the I/O performed on the storage
+    IOStatisticsCollector m_ioStats;
+
+    // The emulated devices of the stripes, if a device profile is set
+    std::vector<std::unique_ptr<DeviceModel>> m_devices;
+
+    /**
+     * A range of bytes of a data file, empty if m_begin >= m_end
+     */
+    struct FileRange {
+      uint64_t  m_begin = std::numeric_limits<uint64_t>::max();
+      uint64_t  m_end = 0;
+    };
+
+    // The ranges of the data files written since the last writeBack()
+    std::vector<FileRange> m_writtenRanges;
+
+    // The ranges of the data files whose write-back the last writeBack()
+    // started
+    std::vector<FileRange> m_writeBackRanges;
+
+    // Protects m_writtenRanges
+    std::mutex      m_writeBackLock;
+
+    // The descriptor of the checksum file, holding a CRC32C per page
+    int             m_checksumFile;
+
+    /**
+     * The checksums of CHECKSUMS_PER_CHUNK contiguous pages
+     */
+    struct ChecksumChunk {
+      std::atomic<uint32_t> m_checksums[CHECKSUMS_PER_CHUNK];
+    };
+
+    // The chunks of the checksums, indexed by page / CHECKSUMS_PER_CHUNK.
+    // Chunks never move once allocated, and a full index is replaced by a
+    // larger copy, so that checksums are accessed without locks while the
+    // storage grows.
+    std::atomic<ChecksumChunk**> p_checksumIndex;
+
+    // The number of chunks the current index has room for
+    uint64_t        m_checksumIndexCapacity;
+
+    // The chunks and every index allocated, including replaced ones, which
+    // concurrent accesses may still be reading. Freed when closed.
+    std::vector<std::unique_ptr<ChecksumChunk>>   m_checksumChunks;
+    std::vector<std::unique_ptr<ChecksumChunk*[]>> m_checksumIndexes;
 
     // The configuration file
     std::fstream    m_configFile;
 
     // The size of the file in pages;
-    pageId_t        m_size;
+    std::atomic<pageId_t> m_size;
 
-    // The basic file modes
+    // Serializes the growth of the data file
+    std::mutex      m_reserveLock;
+
+    // The basic file modes of the configuration file
     std::ios_base::openmode m_flags;
 
     // A buffer used to initialize new pages in the file when it grows
-    std::vector<char>  m_pageFiller;
+    char*              p_pageFiller;
+
+    // The checksum of the filler, stored for new pages
+    uint32_t           m_fillerChecksum;
+
+    // The alignment in bytes required for direct transfers
+    size_t             m_ioAlignment;
+
+    // The read-only mapping of the data file, if mapped
+    char*              p_mapping;
+
+    // The size in bytes of the mapping
+    size_t             m_mappingSize;
 
     // The storage configuration data
     FileStorageConfig  m_config;
@@ -0,0 +1,89 @@
+
+
+#include "file_utils.h"
+#include <algorithm>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+bool preadFully( int fd, 
+                 char* data, 
+                 size_t size, 
+                 off_t offset ) noexcept {
+  while(size > 0) {
+    ssize_t res = pread(fd, data, size, offset);
+    if(res < 0 && errno == EINTR) {
+      continue;
+    }
+    if(res <= 0) {
+      return false;
+    }
+    data += res;
+    size -= res;
+    offset += res;
+  }
+  return true;
+}
+
+bool pwriteFully( int fd, 
+                  const char* data, 
+                  size_t size, 
+                  off_t offset ) noexcept {
+  while(size > 0) {
+    ssize_t res = pwrite(fd, data, size, offset);
+    if(res < 0 && errno == EINTR) {
+      continue;
+    }
+    if(res <= 0) {
+      return false;
+    }
+    data += res;
+    size -= res;
+    offset += res;
+  }
+  return true;
+}
+
+bool transferVectorFully( bool isRead,
+                          int fd,
+                          struct iovec* iov,
+                          uint32_t iovcnt,
+                          off_t offset ) noexcept {
+  while(iovcnt > 0) {
+    int count = std::min<uint32_t>(iovcnt, IOV_MAX);
+    ssize_t res = isRead ? preadv(fd, iov, count, offset) : pwritev(fd, iov, count, offset);
+    if(res < 0 && errno == EINTR) {
+      continue;
+    }
+    if(res <= 0) {
+      return false;
+    }
+    offset += res;
+    while(iovcnt > 0 && static_cast<size_t>(res) >= iov->iov_len) {
+      res -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if(iovcnt > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + res;
+      iov->iov_len -= res;
+    }
+  }
+  return true;
+}
+
+char* allocAligned( size_t size, 
+                    size_t alignment ) noexcept {
+  void* buffer = nullptr;
+  if(posix_memalign(&buffer, alignment, size) != 0) {
+    return nullptr;
+  }
+  memset(buffer, 0, size);
+  return static_cast<char*>(buffer);
+}
+
+SMILE_NS_END
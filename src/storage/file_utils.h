@@ -0,0 +1,53 @@
+
+
+#ifndef _STORAGE_FILE_UTILS_H_
+#define _STORAGE_FILE_UTILS_H_
+
+#include "../base/base.h"
+#include <sys/types.h>
+#include <sys/uio.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Reads exactly size bytes at the given offset, retrying on short reads and
+ * interrupted calls
+ * @return true if all the bytes were read. false otherwise
+ **/
+bool preadFully( int fd, 
+                 char* data, 
+                 size_t size, 
+                 off_t offset ) noexcept;
+
+/**
+ * Writes exactly size bytes at the given offset, retrying on short writes and
+ * interrupted calls
+ * @return true if all the bytes were written. false otherwise
+ **/
+bool pwriteFully( int fd, 
+                  const char* data, 
+                  size_t size, 
+                  off_t offset ) noexcept;
+
+/**
+ * Reads or writes exactly the bytes of the given buffers at the given offset,
+ * retrying on short transfers and interrupted calls. The iovecs are modified.
+ * @return true if all the bytes were transferred. false otherwise
+ **/
+bool transferVectorFully( bool isRead,
+                          int fd,
+                          struct iovec* iov,
+                          uint32_t iovcnt,
+                          off_t offset ) noexcept;
+
+/**
+ * Allocates a zeroed buffer of the given size aligned to the given alignment.
+ * It is released with free().
+ * @return The buffer, or nullptr if it could not be allocated
+ **/
+char* allocAligned( size_t size, 
+                    size_t alignment ) noexcept;
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_FILE_UTILS_H_ */
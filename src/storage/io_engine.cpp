@@ -0,0 +1,448 @@
+
+
+#include "io_engine.h"
+#include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+#ifdef IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+SMILE_NS_BEGIN
+
+// Kinds of request
+static const uint8_t IO_OP_READ   = 0;
+static const uint8_t IO_OP_WRITE  = 1;
+static const uint8_t IO_OP_READV  = 2;
+static const uint8_t IO_OP_WRITEV = 3;
+
+/**
+ * Transfers a range of the file from/to the given buffers, completing short
+ * transfers. Used by the synchronous mode.
+ * @return The number of bytes transferred, or a negated errno value if
+ * nothing could be transferred
+ **/
+static int64_t transfer( bool isRead,
+                         int fd,
+                         struct iovec* iov,
+                         uint32_t iovcnt,
+                         uint64_t offset ) noexcept {
+  int64_t done = 0;
+  int error = EIO;
+  while(iovcnt > 0) {
+    ssize_t res = isRead ? preadv(fd, iov, std::min<uint32_t>(iovcnt, IOV_MAX), offset+done) :
+                           pwritev(fd, iov, std::min<uint32_t>(iovcnt, IOV_MAX), offset+done);
+    if(res < 0 && errno == EINTR) {
+      continue;
+    }
+    if(res < 0) {
+      error = errno;
+    }
+    if(res <= 0) {
+      break;
+    }
+    done += res;
+    // Skip the buffers fully transferred and advance into the partial one
+    while(iovcnt > 0 && static_cast<size_t>(res) >= iov->iov_len) {
+      res -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if(iovcnt > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + res;
+      iov->iov_len -= res;
+    }
+  }
+  return (done > 0 || iovcnt == 0) ? done : -static_cast<int64_t>(error);
+}
+
+IOEngine::IOEngine() noexcept :
+m_ringFd(-1),
+p_sqRing(nullptr),
+p_cqRing(nullptr),
+m_sqRingSize(0),
+m_cqRingSize(0),
+p_sqes(nullptr),
+m_sqesSize(0),
+p_sqTail(nullptr),
+p_sqMask(nullptr),
+p_sqArray(nullptr),
+p_cqHead(nullptr),
+p_cqTail(nullptr),
+p_cqMask(nullptr),
+p_cqes(nullptr),
+m_cancelNext(false),
+m_delayNext(false),
+m_linkDelayed(false),
+m_toSubmit(0),
+m_inFlight(0),
+m_queueDepth(0),
+m_opened(false)
+{
+}
+
+IOEngine::~IOEngine() noexcept {
+  if(m_opened) {
+    close();
+  }
+}
+
+ErrorCode IOEngine::open( uint32_t queueDepth,
+                          bool synchronous ) noexcept {
+  assert(!m_opened && "IOEngine is already opened");
+  assert(queueDepth > 0 && "IOEngine queue depth must be > 0");
+
+  m_queueDepth  = queueDepth;
+  m_toSubmit    = 0;
+  m_inFlight    = 0;
+  m_cancelNext  = false;
+  m_delayNext   = false;
+  m_linkDelayed = false;
+  m_opened      = true;
+
+#ifdef IO_URING
+  if(synchronous) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ringFd = syscall(__NR_io_uring_setup, queueDepth, &params);
+  if(ringFd < 0) {
+    // Kernels without io_uring, or where it is disabled, use the
+    // synchronous path
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  m_sqRingSize = params.sq_off.array + params.sq_entries*sizeof(uint32_t);
+  m_cqRingSize = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+  bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if(singleMmap) {
+    m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+  }
+
+  void* sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+  void* cqRing = sqRing;
+  if(sqRing != MAP_FAILED && !singleMmap) {
+    cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+  }
+  m_sqesSize = params.sq_entries*sizeof(struct io_uring_sqe);
+  void* sqes = MAP_FAILED;
+  if(sqRing != MAP_FAILED && cqRing != MAP_FAILED) {
+    sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+  }
+
+  if(sqes == MAP_FAILED) {
+    if(cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, m_cqRingSize);
+    if(sqRing != MAP_FAILED) munmap(sqRing, m_sqRingSize);
+    ::close(ringFd);
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  m_ringFd  = ringFd;
+  p_sqRing  = static_cast<char*>(sqRing);
+  p_cqRing  = static_cast<char*>(cqRing);
+  p_sqes    = sqes;
+  p_sqTail  = reinterpret_cast<uint32_t*>(p_sqRing + params.sq_off.tail);
+  p_sqMask  = reinterpret_cast<uint32_t*>(p_sqRing + params.sq_off.ring_mask);
+  p_sqArray = reinterpret_cast<uint32_t*>(p_sqRing + params.sq_off.array);
+  p_cqHead  = reinterpret_cast<uint32_t*>(p_cqRing + params.cq_off.head);
+  p_cqTail  = reinterpret_cast<uint32_t*>(p_cqRing + params.cq_off.tail);
+  p_cqMask  = reinterpret_cast<uint32_t*>(p_cqRing + params.cq_off.ring_mask);
+  p_cqes    = p_cqRing + params.cq_off.cqes;
+
+  // The kernel may round the number of entries up
+  m_queueDepth = std::min(queueDepth, params.sq_entries);
+#endif
+
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode IOEngine::close() noexcept {
+  assert(m_opened && "IOEngine is not opened");
+  assert(m_inFlight == 0 && "IOEngine closed with requests in flight");
+
+#ifdef IO_URING
+  if(m_ringFd != -1) {
+    munmap(p_sqes, m_sqesSize);
+    if(p_cqRing != p_sqRing) {
+      munmap(p_cqRing, m_cqRingSize);
+    }
+    munmap(p_sqRing, m_sqRingSize);
+    ::close(m_ringFd);
+  }
+#endif
+
+  m_ringFd  = -1;
+  p_sqRing  = p_cqRing = nullptr;
+  p_sqes    = nullptr;
+  m_syncCompletions.clear();
+  m_delayed.clear();
+  m_deadlines.clear();
+  m_opened  = false;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode IOEngine::prepareRead( int fd,
+                                 char* data,
+                                 size_t size,
+                                 uint64_t offset,
+                                 uint64_t tag,
+                                 bool linkNext ) noexcept {
+  return prepare(IO_OP_READ, fd, data, size, offset, tag, linkNext);
+}
+
+ErrorCode IOEngine::prepareWrite( int fd,
+                                  const char* data,
+                                  size_t size,
+                                  uint64_t offset,
+                                  uint64_t tag,
+                                  bool linkNext ) noexcept {
+  return prepare(IO_OP_WRITE, fd, const_cast<char*>(data), size, offset, tag, linkNext);
+}
+
+ErrorCode IOEngine::prepareReadv( int fd,
+                                  const struct iovec* iov,
+                                  uint32_t iovcnt,
+                                  uint64_t offset,
+                                  uint64_t tag,
+                                  bool linkNext ) noexcept {
+  return prepare(IO_OP_READV, fd, const_cast<struct iovec*>(iov), iovcnt, offset, tag, linkNext);
+}
+
+ErrorCode IOEngine::prepareWritev( int fd,
+                                   const struct iovec* iov,
+                                   uint32_t iovcnt,
+                                   uint64_t offset,
+                                   uint64_t tag,
+                                   bool linkNext ) noexcept {
+  return prepare(IO_OP_WRITEV, fd, const_cast<struct iovec*>(iov), iovcnt, offset, tag, linkNext);
+}
+
+ErrorCode IOEngine::prepare( uint8_t opcode,
+                             int fd,
+                             void* data,
+                             size_t size,
+                             uint64_t offset,
+                             uint64_t tag,
+                             bool linkNext ) noexcept {
+  assert(m_opened && "IOEngine is not opened");
+
+  if(m_inFlight >= m_queueDepth) {
+    return ErrorCode::E_STORAGE_IO_QUEUE_FULL;
+  }
+  ++m_inFlight;
+
+  // A linked request only starts once the previous one completes, so its
+  // completion must not be reported earlier either
+  bool delayed = m_delayNext || m_linkDelayed;
+  std::chrono::steady_clock::time_point deadline = m_delayNext ? m_nextDeadline : m_linkDeadline;
+  if(m_delayNext && m_linkDelayed) {
+    deadline = std::max(m_nextDeadline, m_linkDeadline);
+  }
+  if(delayed) {
+    m_deadlines[tag] = deadline;
+  }
+  m_delayNext = false;
+  m_linkDelayed = linkNext && delayed;
+  m_linkDeadline = deadline;
+
+#ifdef IO_URING
+  if(m_ringFd != -1) {
+    // Only this thread produces submissions, so the tail is read plainly
+    // and published with release semantics once the entry is filled
+    uint32_t tail = *p_sqTail;
+    uint32_t index = tail & *p_sqMask;
+    struct io_uring_sqe* sqe = &static_cast<struct io_uring_sqe*>(p_sqes)[index];
+    memset(sqe, 0, sizeof(*sqe));
+    static const uint8_t opcodes[] = { IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READV, IORING_OP_WRITEV };
+    sqe->opcode     = opcodes[opcode];
+    sqe->fd         = fd;
+    sqe->addr       = reinterpret_cast<uint64_t>(data);
+    sqe->len        = size;
+    sqe->off        = offset;
+    sqe->user_data  = tag;
+    sqe->flags      = linkNext ? IOSQE_IO_LINK : 0;
+    p_sqArray[index] = index;
+    __atomic_store_n(p_sqTail, tail+1, __ATOMIC_RELEASE);
+    ++m_toSubmit;
+    return ErrorCode::E_NO_ERROR;
+  }
+#endif
+
+  // Synchronous fallback. Short transfers are completed here, as the
+  // kernel would do for regular files.
+  int64_t result = -ECANCELED;
+  size_t expected = size;
+  if(opcode == IO_OP_READ || opcode == IO_OP_WRITE) {
+    struct iovec single = { data, size };
+    if(!m_cancelNext) {
+      result = transfer(opcode == IO_OP_READ, fd, &single, 1, offset);
+    }
+  }
+  else {
+    // The iovec array belongs to the caller, so it is advanced on a copy
+    const struct iovec* iov = static_cast<const struct iovec*>(data);
+    expected = 0;
+    for(size_t i = 0; i < size; ++i) {
+      expected += iov[i].iov_len;
+    }
+    if(!m_cancelNext) {
+      std::vector<struct iovec> copy(iov, iov+size);
+      result = transfer(opcode == IO_OP_READV, fd, copy.data(), copy.size(), offset);
+    }
+  }
+  m_cancelNext = linkNext && result != static_cast<int64_t>(expected);
+  m_syncCompletions.push_back(IOCompletion{tag, result});
+  return ErrorCode::E_NO_ERROR;
+}
+
+void IOEngine::delayNext( std::chrono::steady_clock::time_point notBefore ) noexcept {
+  assert(m_opened && "IOEngine is not opened");
+
+  m_nextDeadline = notBefore;
+  m_delayNext = true;
+}
+
+ErrorCode IOEngine::submit() noexcept {
+  assert(m_opened && "IOEngine is not opened");
+
+#ifdef IO_URING
+  while(m_ringFd != -1 && m_toSubmit > 0) {
+    int res = syscall(__NR_io_uring_enter, m_ringFd, m_toSubmit, 0, 0, nullptr, 0);
+    if(res < 0) {
+      if(errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        continue;
+      }
+      return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+    }
+    m_toSubmit -= res;
+  }
+#endif
+
+  return ErrorCode::E_NO_ERROR;
+}
+
+uint32_t IOEngine::collectCompletions( IOCompletion* completions,
+                                       uint32_t maxCompletions ) noexcept {
+  // Delayed completions that are due go first
+  uint32_t count = 0;
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  for(auto it = m_delayed.begin(); it != m_delayed.end() && count < maxCompletions; ) {
+    if(it->first <= now) {
+      completions[count++] = it->second;
+      it = m_delayed.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+  m_inFlight -= count;
+
+  // Completions of requests with a deadline in the future are held back.
+  // The others keep the order they arrived in.
+  uint32_t consumed = consumeCompletions(completions+count, maxCompletions-count);
+  uint32_t end = count;
+  for(uint32_t i = count; i < count + consumed; ++i) {
+    auto it = m_deadlines.find(completions[i].m_tag);
+    if(it != m_deadlines.end()) {
+      std::chrono::steady_clock::time_point deadline = it->second;
+      m_deadlines.erase(it);
+      if(deadline > now) {
+        m_delayed.push_back(std::make_pair(deadline, completions[i]));
+        continue;
+      }
+    }
+    completions[end++] = completions[i];
+  }
+  m_inFlight -= end - count;
+  return end;
+}
+
+uint32_t IOEngine::consumeCompletions( IOCompletion* completions,
+                                       uint32_t maxCompletions ) noexcept {
+  uint32_t count = 0;
+
+#ifdef IO_URING
+  if(m_ringFd != -1) {
+    uint32_t head = *p_cqHead;
+    uint32_t tail = __atomic_load_n(p_cqTail, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe* cqes = static_cast<struct io_uring_cqe*>(p_cqes);
+    while(head != tail && count < maxCompletions) {
+      struct io_uring_cqe* cqe = &cqes[head & *p_cqMask];
+      completions[count].m_tag    = cqe->user_data;
+      completions[count].m_result = cqe->res;
+      ++count;
+      ++head;
+    }
+    __atomic_store_n(p_cqHead, head, __ATOMIC_RELEASE);
+    return count;
+  }
+#endif
+
+  while(count < maxCompletions && count < m_syncCompletions.size()) {
+    completions[count] = m_syncCompletions[count];
+    ++count;
+  }
+  m_syncCompletions.erase(m_syncCompletions.begin(), m_syncCompletions.begin()+count);
+  return count;
+}
+
+uint32_t IOEngine::reap( IOCompletion* completions,
+                         uint32_t maxCompletions,
+                         uint32_t minCompletions ) noexcept {
+  assert(m_opened && "IOEngine is not opened");
+
+  minCompletions = std::min(minCompletions, std::min(maxCompletions, m_inFlight));
+  uint32_t count = collectCompletions(completions, maxCompletions);
+
+  while(count < minCompletions || m_toSubmit > 0) {
+#ifdef IO_URING
+    // The kernel is only waited for when no held back completion is due
+    // earlier
+    uint32_t wait = (count < minCompletions && m_delayed.empty()) ? minCompletions - count : 0;
+    if(m_ringFd != -1 && (wait > 0 || m_toSubmit > 0)) {
+      int res = syscall(__NR_io_uring_enter, m_ringFd, m_toSubmit, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+      if(res < 0) {
+        if(errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          continue;
+        }
+        break;
+      }
+      m_toSubmit -= res;
+    }
+#endif
+    if(count < minCompletions && !m_delayed.empty()) {
+      auto first = std::min_element(m_delayed.begin(), m_delayed.end(), 
+                                    [] (const auto& a, const auto& b) { return a.first < b.first; });
+      std::this_thread::sleep_until(first->first);
+    }
+    count += collectCompletions(completions+count, maxCompletions-count);
+  }
+
+  return count;
+}
+
+uint32_t IOEngine::inFlight() const noexcept {
+  return m_inFlight;
+}
+
+uint32_t IOEngine::queueDepth() const noexcept {
+  return m_queueDepth;
+}
+
+bool IOEngine::isAsync() const noexcept {
+  return m_ringFd != -1;
+}
+
+bool IOEngine::isOpened() const noexcept {
+  return m_opened;
+}
+
+SMILE_NS_END
@@ -0,0 +1,282 @@
+
+
+#ifndef _STORAGE_IO_ENGINE_H_
+#define _STORAGE_IO_ENGINE_H_
+
+#include "../base/base.h"
+#include <sys/uio.h>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+struct IOCompletion {
+  /**
+   * The tag given when the request was prepared.
+   */
+  uint64_t  m_tag;
+
+  /**
+   * The number of bytes transferred, or a negated errno value on failure.
+   */
+  int64_t   m_result;
+};
+
+/**
+ * Asynchronous I/O engine that keeps several reads and writes in flight at
+ * once. It is backed by an io_uring submission/completion ring when the
+ * kernel supports it, and falls back to executing every request
+ * synchronously at preparation time otherwise, so callers are written the
+ * same way in both cases. An engine must only be used by one thread at a
+ * time.
+ */
+class IOEngine final {
+  public:
+    SMILE_NOT_COPYABLE(IOEngine)
+
+    IOEngine() noexcept;
+
+    ~IOEngine() noexcept;
+
+    /**
+     * Opens the engine
+     * @param in queueDepth The maximum number of requests in flight
+     * @param in synchronous Forces the synchronous fallback
+     * @return E_NO_ERROR if the engine was opened. The engine falls back to
+     * synchronous mode silently when io_uring is not available.
+     **/
+    ErrorCode open( uint32_t queueDepth,
+                    bool synchronous = false ) noexcept;
+
+    /**
+     * Closes the engine. All the requests must have been reaped first.
+     * @return E_NO_ERROR if the engine was closed correctly
+     **/
+    ErrorCode close() noexcept;
+
+    /**
+     * Prepares a read request. Prepared requests are sent to the kernel by
+     * submit() or reap().
+     * @param in fd The file descriptor to read from
+     * @param in data The buffer to read into
+     * @param in size The number of bytes to read
+     * @param in offset The offset in the file to read from
+     * @param in tag The tag reported in the completion of the request
+     * @param in linkNext Whether the next prepared request must only start
+     * once this one completes successfully. Otherwise it is cancelled.
+     * @return E_STORAGE_IO_QUEUE_FULL if there are already queueDepth()
+     * requests in flight
+     **/
+    ErrorCode prepareRead( int fd,
+                           char* data,
+                           size_t size,
+                           uint64_t offset,
+                           uint64_t tag,
+                           bool linkNext = false ) noexcept;
+
+    /**
+     * Prepares a write request. Prepared requests are sent to the kernel by
+     * submit() or reap().
+     * @param in fd The file descriptor to write to
+     * @param in data The buffer to write from
+     * @param in size The number of bytes to write
+     * @param in offset The offset in the file to write to
+     * @param in tag The tag reported in the completion of the request
+     * @param in linkNext Whether the next prepared request must only start
+     * once this one completes successfully. Otherwise it is cancelled.
+     * @return E_STORAGE_IO_QUEUE_FULL if there are already queueDepth()
+     * requests in flight
+     **/
+    ErrorCode prepareWrite( int fd,
+                            const char* data,
+                            size_t size,
+                            uint64_t offset,
+                            uint64_t tag,
+                            bool linkNext = false ) noexcept;
+
+    /**
+     * Prepares a read request scattering a contiguous range of the file into
+     * several buffers. The iovec array must stay valid until the request is
+     * reaped.
+     * @param in fd The file descriptor to read from
+     * @param in iov The buffers to read into
+     * @param in iovcnt The number of buffers
+     * @param in offset The offset in the file to read from
+     * @param in tag The tag reported in the completion of the request
+     * @param in linkNext Whether the next prepared request must only start
+     * once this one completes successfully. Otherwise it is cancelled.
+     * @return E_STORAGE_IO_QUEUE_FULL if there are already queueDepth()
+     * requests in flight
+     **/
+    ErrorCode prepareReadv( int fd,
+                            const struct iovec* iov,
+                            uint32_t iovcnt,
+                            uint64_t offset,
+                            uint64_t tag,
+                            bool linkNext = false ) noexcept;
+
+    /**
+     * Prepares a write request gathering several buffers into a contiguous
+     * range of the file. The iovec array must stay valid until the request
+     * is reaped.
+     * @param in fd The file descriptor to write to
+     * @param in iov The buffers to write from
+     * @param in iovcnt The number of buffers
+     * @param in offset The offset in the file to write to
+     * @param in tag The tag reported in the completion of the request
+     * @param in linkNext Whether the next prepared request must only start
+     * once this one completes successfully. Otherwise it is cancelled.
+     * @return E_STORAGE_IO_QUEUE_FULL if there are already queueDepth()
+     * requests in flight
+     **/
+    ErrorCode prepareWritev( int fd,
+                             const struct iovec* iov,
+                             uint32_t iovcnt,
+                             uint64_t offset,
+                             uint64_t tag,
+                             bool linkNext = false ) noexcept;
+
+    /**
+     * Holds back the completion of the next prepared request until the given
+     * time, which is used to emulate slower devices. Completions keep the
+     * order of the chains they belong to: a request linked to a delayed one
+     * is held back at least as long, even if it was not delayed itself, and
+     * completions due at once are reported in the order they arrived.
+     * Completions of requests that are not linked may still be reported in
+     * any order.
+     * @param in notBefore The earliest time the completion is reported at
+     **/
+    void delayNext( std::chrono::steady_clock::time_point notBefore ) noexcept;
+
+    /**
+     * Sends the prepared requests to the kernel without waiting for them
+     * @return E_NO_ERROR if the requests were submitted correctly
+     **/
+    ErrorCode submit() noexcept;
+
+    /**
+     * Submits the prepared requests and collects completed ones
+     * @param out completions The array where completions are stored
+     * @param in maxCompletions The size of the completions array
+     * @param in minCompletions The number of completions to wait for. It
+     * is capped to the number of requests in flight.
+     * @return The number of completions stored
+     **/
+    uint32_t reap( IOCompletion* completions,
+                   uint32_t maxCompletions,
+                   uint32_t minCompletions ) noexcept;
+
+    /**
+     * Gets the number of requests prepared and not reaped yet
+     * @return The number of requests in flight
+     **/
+    uint32_t inFlight() const noexcept;
+
+    /**
+     * Gets the maximum number of requests in flight
+     * @return The queue depth of the engine
+     **/
+    uint32_t queueDepth() const noexcept;
+
+    /**
+     * Whether requests are really asynchronous or run at preparation time
+     * @return true if the engine is backed by io_uring
+     **/
+    bool isAsync() const noexcept;
+
+    /**
+     * Whether the engine is opened
+     * @return true if the engine is opened
+     **/
+    bool isOpened() const noexcept;
+
+  private:
+
+    /**
+     * Prepares a request of the given kind, or runs it directly in
+     * synchronous mode. Vectored kinds take an iovec array as data and the
+     * number of buffers as size.
+     **/
+    ErrorCode prepare( uint8_t opcode,
+                       int fd,
+                       void* data,
+                       size_t size,
+                       uint64_t offset,
+                       uint64_t tag,
+                       bool linkNext ) noexcept;
+
+    /**
+     * Moves the completions posted by the kernel to the given array
+     * @return The number of completions moved
+     **/
+    uint32_t consumeCompletions( IOCompletion* completions,
+                                 uint32_t maxCompletions ) noexcept;
+
+    /**
+     * Moves the completions that can be reported to the given array, holding
+     * back those of delayed requests until their time
+     * @return The number of completions moved
+     **/
+    uint32_t collectCompletions( IOCompletion* completions,
+                                 uint32_t maxCompletions ) noexcept;
+
+    // The io_uring file descriptor, or -1 in synchronous mode
+    int                 m_ringFd;
+
+    // Shared memory of the submission and completion rings
+    char*               p_sqRing;
+    char*               p_cqRing;
+    size_t              m_sqRingSize;
+    size_t              m_cqRingSize;
+
+    // Submission queue entries
+    void*               p_sqes;
+    size_t              m_sqesSize;
+
+    // Pointers to the fields of the rings shared with the kernel
+    uint32_t*           p_sqTail;
+    uint32_t*           p_sqMask;
+    uint32_t*           p_sqArray;
+    uint32_t*           p_cqHead;
+    uint32_t*           p_cqTail;
+    uint32_t*           p_cqMask;
+    void*               p_cqes;
+
+    // Completions of the synchronous mode waiting to be reaped
+    std::vector<IOCompletion> m_syncCompletions;
+
+    // Whether the previous synchronous request was linked and failed
+    bool                m_cancelNext;
+
+    // The time before which the completion of the next request is held back
+    std::chrono::steady_clock::time_point m_nextDeadline;
+    bool                m_delayNext;
+
+    // The deadline inherited by the next request, if the previous one was
+    // linked to it and delayed
+    std::chrono::steady_clock::time_point m_linkDeadline;
+    bool                m_linkDelayed;
+
+    // The deadlines of the delayed requests in flight, by tag
+    std::unordered_map<uint64_t, std::chrono::steady_clock::time_point> m_deadlines;
+
+    // Completions held back until their deadline
+    std::vector<std::pair<std::chrono::steady_clock::time_point, IOCompletion>> m_delayed;
+
+    // The number of requests prepared and not submitted yet
+    uint32_t            m_toSubmit;
+
+    // The number of requests prepared and not reaped yet
+    uint32_t            m_inFlight;
+
+    // The maximum number of requests in flight
+    uint32_t            m_queueDepth;
+
+    // Stores if the engine was opened and needs to be closed
+    bool                m_opened;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_IO_ENGINE_H_ */
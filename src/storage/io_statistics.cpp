@@ -0,0 +1,154 @@
+
+
+#include "io_statistics.h"
+#include <algorithm>
+#include <assert.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Used to give every collector a distinct id
+ */
+static std::atomic<uint64_t> nextCollectorId(0);
+
+/**
+ * Maximum number of collectors a thread keeps its counters cached for.
+ * Entries of destroyed collectors are dropped when the cache is full.
+ */
+#define CACHED_COLLECTORS 16
+
+/**
+ * Gets the bucket of a latency histogram a latency falls in
+ **/
+static uint32_t latencyBucket( std::chrono::nanoseconds latency ) noexcept {
+  uint64_t ns = std::max<int64_t>(latency.count(), 1);
+  return std::min<uint32_t>(63 - __builtin_clzll(ns), IO_LATENCY_BUCKETS - 1);
+}
+
+uint64_t IOStatistics::getLatencyPercentile( const uint64_t* histogram,
+                                             double percentile ) noexcept {
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < IO_LATENCY_BUCKETS; ++i) {
+    total += histogram[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  // The rank of the percentile, counting from 1
+  uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(total * percentile / 100.0 + 0.5), 1);
+  uint64_t count = 0;
+  for (uint32_t i = 0; i < IO_LATENCY_BUCKETS; ++i) {
+    count += histogram[i];
+    if (count >= rank) {
+      return 1ULL << (i + 1);
+    }
+  }
+  return 1ULL << IO_LATENCY_BUCKETS;
+}
+
+IOStatisticsCollector::IOStatisticsCollector() noexcept :
+m_id(nextCollectorId.fetch_add(1))
+{
+}
+
+void IOStatisticsCollector::countTransfer( IOOperation operation,
+                                           uint64_t numPages,
+                                           uint64_t numBytes,
+                                           uint64_t numCalls ) noexcept {
+  assert(operation != IOOperation::E_RESERVE && "Reserves do not transfer data");
+
+  Counters* counters = local();
+  if (operation == IOOperation::E_READ) {
+    add(counters, E_PAGES_READ, numPages);
+    add(counters, E_BYTES_READ, numBytes);
+    add(counters, E_READ_CALLS, numCalls);
+  }
+  else {
+    add(counters, E_PAGES_WRITTEN, numPages);
+    add(counters, E_BYTES_WRITTEN, numBytes);
+    add(counters, E_WRITE_CALLS, numCalls);
+  }
+}
+
+void IOStatisticsCollector::countReserve() noexcept {
+  add(local(), E_RESERVE_CALLS, 1);
+}
+
+void IOStatisticsCollector::recordLatency( IOOperation operation,
+                                           std::chrono::nanoseconds latency ) noexcept {
+  uint32_t first = E_READ_LATENCY;
+  if (operation == IOOperation::E_WRITE) {
+    first = E_WRITE_LATENCY;
+  }
+  else if (operation == IOOperation::E_RESERVE) {
+    first = E_RESERVE_LATENCY;
+  }
+  add(local(), first + latencyBucket(latency), 1);
+}
+
+void IOStatisticsCollector::snapshot( IOStatistics* stats ) const noexcept {
+  uint64_t values[E_NUM_VALUES] = {};
+  std::lock_guard<std::mutex> guard(m_lock);
+  for (const auto& entry : m_counters) {
+    for (uint32_t i = 0; i < E_NUM_VALUES; ++i) {
+      values[i] += entry.second->m_values[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  stats->m_pagesRead    = values[E_PAGES_READ];
+  stats->m_pagesWritten = values[E_PAGES_WRITTEN];
+  stats->m_bytesRead    = values[E_BYTES_READ];
+  stats->m_bytesWritten = values[E_BYTES_WRITTEN];
+  stats->m_readCalls    = values[E_READ_CALLS];
+  stats->m_writeCalls   = values[E_WRITE_CALLS];
+  stats->m_reserveCalls = values[E_RESERVE_CALLS];
+  std::copy(&values[E_READ_LATENCY], &values[E_WRITE_LATENCY], stats->m_readLatency);
+  std::copy(&values[E_WRITE_LATENCY], &values[E_RESERVE_LATENCY], stats->m_writeLatency);
+  std::copy(&values[E_RESERVE_LATENCY], &values[E_NUM_VALUES], stats->m_reserveLatency);
+}
+
+void IOStatisticsCollector::reset() noexcept {
+  std::lock_guard<std::mutex> guard(m_lock);
+  for (const auto& entry : m_counters) {
+    for (uint32_t i = 0; i < E_NUM_VALUES; ++i) {
+      entry.second->m_values[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+IOStatisticsCollector::Counters* IOStatisticsCollector::local() noexcept {
+  static thread_local std::vector<std::pair<uint64_t, Counters*>> cache;
+  for (const auto& entry : cache) {
+    if (entry.first == m_id) {
+      return entry.second;
+    }
+  }
+
+  // First call of the thread, or its cache entry was dropped
+  std::lock_guard<std::mutex> guard(m_lock);
+  std::thread::id thread = std::this_thread::get_id();
+  auto it = std::find_if(m_counters.begin(), m_counters.end(), 
+                         [thread] (const auto& entry) { return entry.first == thread; });
+  if (it == m_counters.end()) {
+    m_counters.push_back(std::make_pair(thread, std::make_unique<Counters>()));
+    for (uint32_t i = 0; i < E_NUM_VALUES; ++i) {
+      m_counters.back().second->m_values[i].store(0, std::memory_order_relaxed);
+    }
+    it = m_counters.end() - 1;
+  }
+  if (cache.size() == CACHED_COLLECTORS) {
+    cache.clear();
+  }
+  cache.push_back(std::make_pair(m_id, it->second.get()));
+  return it->second.get();
+}
+
+void IOStatisticsCollector::add( Counters* counters,
+                                 uint32_t value,
+                                 uint64_t amount ) noexcept {
+  std::atomic<uint64_t>& counter = counters->m_values[value];
+  counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+SMILE_NS_END
@@ -0,0 +1,172 @@
+
+
+#ifndef _STORAGE_IO_STATISTICS_H_
+#define _STORAGE_IO_STATISTICS_H_
+
+#include "../base/base.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Number of buckets of the latency histograms. Bucket i counts the requests
+ * that took between 2^i and 2^(i+1) nanoseconds, and the last one also
+ * those that took longer.
+ */
+#define IO_LATENCY_BUCKETS 32
+
+enum class IOOperation {
+  E_READ,
+  E_WRITE,
+  E_RESERVE
+};
+
+/**
+ * Snapshot of the I/O performed on a storage since it was opened.
+ * Asynchronous requests are counted when they are prepared, and only
+ * synchronous ones are timed in the latency histograms.
+ */
+struct IOStatistics {
+  uint64_t  m_pagesRead = 0;
+  uint64_t  m_pagesWritten = 0;
+  uint64_t  m_bytesRead = 0;
+  uint64_t  m_bytesWritten = 0;
+
+  /**
+   * Number of read and write system calls, counting each asynchronous
+   * request as one.
+   */
+  uint64_t  m_readCalls = 0;
+  uint64_t  m_writeCalls = 0;
+
+  /**
+   * Number of times the storage was extended.
+   */
+  uint64_t  m_reserveCalls = 0;
+
+  uint64_t  m_readLatency[IO_LATENCY_BUCKETS] = {};
+  uint64_t  m_writeLatency[IO_LATENCY_BUCKETS] = {};
+  uint64_t  m_reserveLatency[IO_LATENCY_BUCKETS] = {};
+
+  /**
+   * Estimates a percentile of a latency histogram
+   * @param in histogram One of the latency histograms
+   * @param in percentile The percentile, between 0 and 100
+   * @return The upper bound in nanoseconds of the bucket the percentile
+   * falls in, or 0 if the histogram is empty
+   **/
+  static uint64_t getLatencyPercentile( const uint64_t* histogram,
+                                        double percentile ) noexcept;
+};
+
+/**
+ * Collects the I/O statistics of a storage. Every thread updates its own
+ * counters, placed in separate cache lines, so that counting is a couple of
+ * uncontended stores. Snapshots add up the counters of all the threads.
+ */
+class IOStatisticsCollector final {
+  public:
+    SMILE_NOT_COPYABLE(IOStatisticsCollector)
+
+    IOStatisticsCollector() noexcept;
+
+    ~IOStatisticsCollector() noexcept = default;
+
+    /**
+     * Counts a transfer of the calling thread
+     * @param in operation E_READ or E_WRITE
+     * @param in numPages The number of pages transferred
+     * @param in numBytes The number of bytes transferred
+     * @param in numCalls The number of system calls or requests issued
+     **/
+    void countTransfer( IOOperation operation,
+                        uint64_t numPages,
+                        uint64_t numBytes,
+                        uint64_t numCalls = 1 ) noexcept;
+
+    /**
+     * Counts a reserve of the calling thread
+     **/
+    void countReserve() noexcept;
+
+    /**
+     * Adds a latency to the histogram of an operation
+     * @param in operation The operation that was timed
+     * @param in latency The time it took
+     **/
+    void recordLatency( IOOperation operation,
+                        std::chrono::nanoseconds latency ) noexcept;
+
+    /**
+     * Adds up the counters of all the threads
+     * @param out stats The snapshot to fill
+     **/
+    void snapshot( IOStatistics* stats ) const noexcept;
+
+    /**
+     * Clears the counters. No thread may be counting at the same time.
+     **/
+    void reset() noexcept;
+
+  private:
+
+    /**
+     * Indices of the values of a thread
+     */
+    enum Value {
+      E_PAGES_READ,
+      E_PAGES_WRITTEN,
+      E_BYTES_READ,
+      E_BYTES_WRITTEN,
+      E_READ_CALLS,
+      E_WRITE_CALLS,
+      E_RESERVE_CALLS,
+      E_READ_LATENCY,
+      E_WRITE_LATENCY = E_READ_LATENCY + IO_LATENCY_BUCKETS,
+      E_RESERVE_LATENCY = E_WRITE_LATENCY + IO_LATENCY_BUCKETS,
+      E_NUM_VALUES = E_RESERVE_LATENCY + IO_LATENCY_BUCKETS
+    };
+
+    /**
+     * The values of a thread. They are only written by their thread, so
+     * they are incremented with a relaxed load and store instead of an
+     * atomic read-modify-write. The padding keeps the values of different
+     * threads in different cache lines, as heap allocations are not
+     * aligned to them.
+     */
+    struct Counters {
+      char                  m_head[64];
+      std::atomic<uint64_t> m_values[E_NUM_VALUES];
+      char                  m_tail[64];
+    };
+
+    /**
+     * Gets the counters of the calling thread, creating them on its first
+     * call
+     **/
+    Counters* local() noexcept;
+
+    static void add( Counters* counters,
+                     uint32_t value,
+                     uint64_t amount ) noexcept;
+
+    // Identifies the collector in the per thread caches. Ids are never
+    // reused, so cached entries of destroyed collectors are never matched.
+    uint64_t            m_id;
+
+    // Protects the list of counters
+    mutable std::mutex  m_lock;
+
+    // The counters of every thread that counted, with the thread they
+    // belong to
+    std::vector<std::pair<std::thread::id, std::unique_ptr<Counters>>> m_counters;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_IO_STATISTICS_H_ */
@@ -0,0 +1,264 @@
+
+
+#include "sequential_file_storage.h"
+#include "file_utils.h"
+#include <algorithm>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+SequentialFileStorage::SequentialFileStorage() noexcept :
+m_dataFile(-1),
+m_size(0),
+m_writtenBytes(0),
+m_syncedBytes(0),
+m_requestedBytes(0),
+m_syncError(ErrorCode::E_NO_ERROR),
+m_stopSync(false),
+m_opened(false)
+{
+}
+
+SequentialFileStorage::~SequentialFileStorage() noexcept {
+  assert(!m_opened && "SequentialFileStorage needs to be closed first");
+
+  if(m_dataFile != -1) {
+    ::close(m_dataFile);
+  }
+}
+
+ErrorCode SequentialFileStorage::openDataFile( const std::string& path,
+                                               int flags ) noexcept {
+  if(m_config.m_extentSizeKB == 0) {
+    return ErrorCode::E_STORAGE_INVALID_CONFIG;
+  }
+
+  m_dataFile = ::open( path.c_str(), O_RDWR | flags, 0644 );
+  if(m_dataFile == -1) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+
+  // A trailing partial extent, left by an interrupted append, is ignored
+  struct stat fileStat;
+  if(fstat(m_dataFile, &fileStat) != 0) {
+    return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+  }
+  m_size = fileStat.st_size / getExtentSize();
+
+  m_writtenBytes    = 0;
+  m_syncedBytes     = 0;
+  m_requestedBytes  = 0;
+  m_syncError       = ErrorCode::E_NO_ERROR;
+  m_stopSync        = false;
+  m_syncThread      = std::thread(&SequentialFileStorage::syncLoop, this);
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SequentialFileStorage::open( const std::string& path ) noexcept {
+  assert(!m_opened && "SequentialFileStorage is already opened");
+
+  if(!std::ifstream(path)) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+
+  m_configFile.open( path+".config", std::ios_base::in | std::ios_base::binary );
+  if(!m_configFile) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  m_configFile.read(reinterpret_cast<char*>(&m_config), sizeof(m_config));
+  m_configFile.close();
+
+  ErrorCode err = openDataFile( path, 0 );
+  if(err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+
+  m_opened = true;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SequentialFileStorage::create( const std::string& path,
+                                         const SequentialStorageConfig& config,
+                                         const bool overwrite ) noexcept {
+  assert(!m_opened && "SequentialFileStorage is already opened");
+
+  if(!overwrite && std::ifstream(path)) {
+    return ErrorCode::E_STORAGE_PATH_ALREADY_EXISTS;
+  }
+
+  m_config = config;
+  m_configFile.open( path+".config", std::ios_base::out | std::ios_base::binary | std::ios_base::trunc );
+  if(!m_configFile) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+  m_configFile.write(reinterpret_cast<const char*>(&m_config), sizeof(m_config));
+  m_configFile.close();
+  if(!m_configFile) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+
+  ErrorCode err = openDataFile( path, O_CREAT | O_TRUNC );
+  if(err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+
+  m_opened = true;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SequentialFileStorage::close() noexcept {
+  assert(m_opened && "SequentialFileStorage is not opened");
+
+  ErrorCode err = sync();
+
+  {
+    std::lock_guard<std::mutex> guard(m_syncLock);
+    m_stopSync = true;
+  }
+  m_syncCondition.notify_all();
+  m_syncThread.join();
+
+  ::close(m_dataFile);
+  m_dataFile = -1;
+
+  m_opened = false;
+  return err;
+}
+
+ErrorCode SequentialFileStorage::reserve( const uint32_t numExtents,
+                                          extentId_t& extent ) noexcept {
+  assert(m_opened && "SequentialFileStorage is closed");
+
+  std::lock_guard<std::mutex> guard(m_reserveLock);
+
+  // Reserved extents are allocated on the device right away, so that
+  // writing them later does not need to extend the file
+  extentId_t first = m_size;
+  int res = -1;
+  do {
+    res = fallocate(m_dataFile, 0, extentToBytes(first), extentToBytes(numExtents));
+  } while(res != 0 && errno == EINTR);
+  if(res != 0 && (errno != EOPNOTSUPP || ftruncate(m_dataFile, extentToBytes(first+numExtents)) != 0)) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+
+  extent = first;
+  m_size = first + numExtents;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SequentialFileStorage::append( const char* data,
+                                         const uint32_t numExtents,
+                                         extentId_t& extent ) noexcept {
+  assert(m_opened && "SequentialFileStorage is closed");
+
+  // Only the position is taken under the lock, so concurrent appends write
+  // their extents in parallel
+  extentId_t first;
+  {
+    std::lock_guard<std::mutex> guard(m_reserveLock);
+    first = m_size;
+    m_size = first + numExtents;
+  }
+
+  if(!pwriteFully(m_dataFile, data, extentToBytes(numExtents), extentToBytes(first))) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  notifyWritten(extentToBytes(numExtents));
+
+  extent = first;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SequentialFileStorage::read( char* data,
+                                       const extentId_t extent ) noexcept {
+  assert(m_opened && "SequentialFileStorage is closed");
+  assert(extent < m_size && "Invalid extent");
+
+  if(!preadFully(m_dataFile, data, getExtentSize(), extentToBytes(extent))) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_READ_ERROR;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SequentialFileStorage::write( const char* data,
+                                        const extentId_t extent ) noexcept {
+  assert(m_opened && "SequentialFileStorage is closed");
+  assert(extent < m_size && "Invalid extent");
+
+  if(!pwriteFully(m_dataFile, data, getExtentSize(), extentToBytes(extent))) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  notifyWritten(getExtentSize());
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode SequentialFileStorage::sync() noexcept {
+  assert(m_opened && "SequentialFileStorage is closed");
+
+  // Waits for a flush started after every write completed so far
+  std::unique_lock<std::mutex> guard(m_syncLock);
+  uint64_t target = m_writtenBytes;
+  if(m_syncedBytes >= target) {
+    return m_syncError;
+  }
+  m_requestedBytes = std::max(m_requestedBytes, target);
+  m_syncCondition.notify_all();
+  m_syncCondition.wait(guard, [this, target] () { return m_syncedBytes >= target; });
+  return m_syncError;
+}
+
+void SequentialFileStorage::notifyWritten( size_t bytes ) noexcept {
+  std::lock_guard<std::mutex> guard(m_syncLock);
+  m_writtenBytes += bytes;
+  if(m_config.m_syncIntervalKB > 0 && 
+     m_writtenBytes - m_syncedBytes >= m_config.m_syncIntervalKB*1024ull) {
+    m_syncCondition.notify_all();
+  }
+}
+
+void SequentialFileStorage::syncLoop() noexcept {
+  std::unique_lock<std::mutex> guard(m_syncLock);
+  while(true) {
+    m_syncCondition.wait(guard, [this] () {
+      return m_stopSync || 
+             m_requestedBytes > m_syncedBytes ||
+             (m_config.m_syncIntervalKB > 0 && m_writtenBytes - m_syncedBytes >= m_config.m_syncIntervalKB*1024ull);
+    });
+    if(m_stopSync) {
+      return;
+    }
+
+    // Writes accounted so far have completed, so this flush covers them
+    uint64_t target = m_writtenBytes;
+    guard.unlock();
+    int res = fdatasync(m_dataFile);
+    guard.lock();
+
+    m_syncError = (res == 0) ? ErrorCode::E_NO_ERROR : ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    m_syncedBytes = std::max(m_syncedBytes, target);
+    m_syncCondition.notify_all();
+  }
+}
+
+uint64_t SequentialFileStorage::size() const noexcept {
+  return m_size;
+}
+
+const ISequentialStorage::SequentialStorageConfig& SequentialFileStorage::config() const noexcept {
+  return m_config;
+}
+
+size_t SequentialFileStorage::getExtentSize() const noexcept {
+  return m_config.m_extentSizeKB*1024ull;
+}
+
+size_t SequentialFileStorage::extentToBytes( const extentId_t& extent ) const noexcept {
+  return extent * getExtentSize();
+}
+
+SMILE_NS_END
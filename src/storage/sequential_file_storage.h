@@ -0,0 +1,140 @@
+
+
+#ifndef _STORAGE_SEQUENTIAL_FILE_STORAGE_H_
+#define _STORAGE_SEQUENTIAL_FILE_STORAGE_H_
+
+#include "../base/base.h"
+#include "sequential_storage.h"
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+SMILE_NS_BEGIN
+
+/**
+ * Append-only extent store backed by a single file. Extents are large
+ * (megabytes), written with a single positional write each, and never go
+ * through the Buffer Pool, which makes it suitable for bulk loads and spill
+ * files. A background thread flushes the appended data to the device every
+ * m_syncIntervalKB, so that sync() usually has little left to wait for.
+ */
+class SequentialFileStorage final : public ISequentialStorage {
+  public:
+    SMILE_NOT_COPYABLE(SequentialFileStorage)
+
+    SequentialFileStorage() noexcept;
+
+    ~SequentialFileStorage() noexcept;
+
+    ErrorCode open( const std::string& path ) noexcept override;
+
+    ErrorCode create( const std::string& path, 
+                      const SequentialStorageConfig& config, 
+                      const bool overwrite = false ) noexcept override;
+
+    ErrorCode close() noexcept override;
+
+    ErrorCode reserve( const uint32_t numExtents, 
+                       extentId_t& extent ) noexcept override;
+
+    ErrorCode append( const char* data, 
+                      const uint32_t numExtents, 
+                      extentId_t& extent ) noexcept override;
+
+    ErrorCode read( char* data, 
+                    const extentId_t extent ) noexcept override;
+
+    ErrorCode write( const char* data, 
+                     const extentId_t extent ) noexcept override;
+
+    ErrorCode sync() noexcept override;
+
+    uint64_t size() const noexcept override;
+
+    const SequentialStorageConfig& config() const noexcept override;
+
+    /**
+     * Gets the extent size in bytes
+     *
+     * @return The extent size in bytes
+     **/
+    size_t getExtentSize() const noexcept;
+
+  private:
+
+    /**
+     * Opens the data file and starts the background flushing thread
+     * @param in path The path to the data file
+     * @param in flags Extra open flags
+     * @return E_NO_ERROR if the file was opened correctly
+     **/
+    ErrorCode openDataFile( const std::string& path,
+                            int flags ) noexcept;
+
+    /**
+     * Accounts bytes written to the data file, waking up the background
+     * flushing thread if enough data is pending
+     * @param in bytes The number of bytes written
+     **/
+    void notifyWritten( size_t bytes ) noexcept;
+
+    /**
+     * Body of the background flushing thread
+     **/
+    void syncLoop() noexcept;
+
+    /**
+     * Converts an extent to its equivalent position in bytes
+     * @param in extent The extent to convert
+     * @return the position in bytes equivalent to the extent.
+     */
+    size_t extentToBytes( const extentId_t& extent ) const noexcept;
+
+    // The descriptor of the data file
+    int                     m_dataFile;
+
+    // The configuration file
+    std::fstream            m_configFile;
+
+    // The size of the storage in extents
+    std::atomic<extentId_t> m_size;
+
+    // Serializes the growth of the data file
+    std::mutex              m_reserveLock;
+
+    // The background flushing thread
+    std::thread             m_syncThread;
+
+    // Protects the flushing state below
+    std::mutex              m_syncLock;
+
+    // Signals the flushing thread and the threads waiting in sync()
+    std::condition_variable m_syncCondition;
+
+    // Bytes written since the storage was opened
+    uint64_t                m_writtenBytes;
+
+    // Bytes written before the last completed flush started
+    uint64_t                m_syncedBytes;
+
+    // Bytes that threads in sync() wait to be flushed
+    uint64_t                m_requestedBytes;
+
+    // The error of the last flush
+    ErrorCode               m_syncError;
+
+    // Tells the flushing thread to finish
+    bool                    m_stopSync;
+
+    // The storage configuration data
+    SequentialStorageConfig m_config;
+
+    // Stores if the storage was opened and needs to be closed
+    bool                    m_opened;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_SEQUENTIAL_FILE_STORAGE_H_ */
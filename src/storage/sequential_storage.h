@@ -13,7 +13,13 @@ class ISequentialStorage {
   public:
 
     struct SequentialStorageConfig {
-      uint32_t  m_extentSizeKB = 64;
+      uint32_t  m_extentSizeKB = 1024;
+
+      /**
+       * Amount of appended data in KB after which it is flushed to the
+       * device in the background. 0 only flushes on sync().
+       */
+      uint32_t  m_syncIntervalKB = 64*1024;
     };
 
 
@@ -48,6 +54,15 @@ class ISequentialStorage {
      **/
     virtual ErrorCode reserve( const uint32_t numExtents, extentId_t& extents ) noexcept = 0;
 
+    /**
+     * Appends a set of extents at the end of the storage with a single write
+     * @param in data The contents of the extents
+     * @param in numExtents The number of extents to append
+     * @param out extent The first appended extent
+     * @return false if the append was successful. true otherwise
+     **/
+    virtual ErrorCode append( const char* data, const uint32_t numExtents, extentId_t& extent ) noexcept = 0;
+
     /**
      * Locks an extent into a buffer
      * @param in data The buffer where the extent will be locked
@@ -65,6 +80,11 @@ class ISequentialStorage {
      **/
     virtual ErrorCode write( const char* data, const extentId_t extent ) noexcept = 0;
 
+    /**
+     * Waits until all the extents written before the call are durable
+     * @return false if the data was flushed successfully. true otherwise
+     **/
+    virtual ErrorCode sync() noexcept = 0;
 
 
     /**
@@ -10,8 +10,23 @@
 SMILE_NS_BEGIN
 
 #define INVALID_PAGE_ID 0xffffffffffffffff
+#define INVALID_EXTENT_ID 0xffffffffffffffff
 
 using pageId_t = uint64_t;
+using extentId_t = uint64_t;
+using lsn_t = uint64_t;
+
+/**
+ * Hints about how a range of pages is going to be accessed, so that the
+ * kernel can adapt its read-ahead and caching.
+ */
+enum class AccessPattern {
+  E_NORMAL,
+  E_SEQUENTIAL,
+  E_RANDOM,
+  E_WILL_NEED,
+  E_DONT_NEED
+};
 
 SMILE_NS_END
 
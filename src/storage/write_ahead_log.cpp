@@ -0,0 +1,336 @@
+
+
+#include "write_ahead_log.h"
+#include "checksum.h"
+#include "file_utils.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fstream>
+#include <stddef.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Identifies log files
+ */
+#define WAL_MAGIC 0x4c4157454c494d53ULL
+
+/**
+ * Size of the chunks the log is read in when it is replayed
+ */
+#define WAL_READ_CHUNK_KB 1024
+
+WriteAheadLog::WriteAheadLog() noexcept :
+m_file(-1),
+m_firstLSN(0),
+m_bufferLSN(0),
+m_durableLSN(0),
+m_flushing(false),
+m_flushError(ErrorCode::E_NO_ERROR),
+m_numSyncs(0),
+m_opened(false)
+{
+}
+
+WriteAheadLog::~WriteAheadLog() noexcept {
+  assert(!m_opened && "WriteAheadLog needs to be closed first");
+
+  if(m_file != -1) {
+    ::close(m_file);
+  }
+}
+
+ErrorCode WriteAheadLog::open( const std::string& path,
+                               const RedoFunction& redo ) noexcept {
+  assert(!m_opened && "WriteAheadLog is already opened");
+
+  m_file = ::open( path.c_str(), O_RDWR | O_CLOEXEC );
+  if(m_file == -1) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+
+  Header header;
+  if(!preadFully(m_file, reinterpret_cast<char*>(&header), sizeof(header), 0) ||
+     header.m_magic != WAL_MAGIC ||
+     header.m_checksum != computeCRC32C(reinterpret_cast<const char*>(&header), offsetof(Header, m_checksum))) {
+    ::close(m_file);
+    m_file = -1;
+    return ErrorCode::E_STORAGE_INVALID_LOG;
+  }
+  m_firstLSN = header.m_firstLSN;
+
+  ErrorCode err = replay(redo);
+  if(err != ErrorCode::E_NO_ERROR) {
+    ::close(m_file);
+    m_file = -1;
+    return err;
+  }
+
+  m_opened = true;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode WriteAheadLog::create( const std::string& path,
+                                 bool overwrite ) noexcept {
+  assert(!m_opened && "WriteAheadLog is already opened");
+
+  if(!overwrite && std::ifstream(path)) {
+    return ErrorCode::E_STORAGE_PATH_ALREADY_EXISTS;
+  }
+
+  m_file = ::open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+  if(m_file == -1) {
+    return ErrorCode::E_STORAGE_INVALID_PATH;
+  }
+
+  ErrorCode err = writeHeader(0);
+  if(err != ErrorCode::E_NO_ERROR) {
+    ::close(m_file);
+    m_file = -1;
+    return err;
+  }
+
+  m_bufferLSN   = 0;
+  m_durableLSN  = 0;
+  m_flushError  = ErrorCode::E_NO_ERROR;
+  m_numSyncs    = 0;
+  m_opened = true;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode WriteAheadLog::close() noexcept {
+  assert(m_opened && "WriteAheadLog is not opened");
+
+  ErrorCode err = flush(getNextLSN());
+  ::close(m_file);
+  m_file = -1;
+  m_buffer.clear();
+  m_buffer.shrink_to_fit();
+  m_flushBuffer.clear();
+  m_flushBuffer.shrink_to_fit();
+  m_opened = false;
+  return err;
+}
+
+ErrorCode WriteAheadLog::append( WALRecordType type,
+                                 const pageId_t& pageId,
+                                 uint32_t offset,
+                                 const char* data,
+                                 uint32_t size,
+                                 lsn_t* lsn ) noexcept {
+  assert(m_opened && "WriteAheadLog is not opened");
+
+  WALRecord record;
+  memset(&record, 0, sizeof(record));
+  record.m_size   = size;
+  record.m_pageId = pageId;
+  record.m_offset = offset;
+  record.m_type   = type;
+
+  // The checksum covers the LSN, which is only known under the lock, so
+  // only the header is checksummed there
+  uint32_t dataChecksum = computeCRC32C(data, size);
+  std::unique_lock<std::mutex> guard(m_lock);
+  if(m_buffer.size() + sizeof(record) + size > WAL_BUFFER_KB*1024 && !m_buffer.empty()) {
+    lsn_t end = m_bufferLSN + m_buffer.size();
+    guard.unlock();
+    ErrorCode err = flush(end);
+    if(err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+    guard.lock();
+  }
+
+  record.m_lsn = m_bufferLSN + m_buffer.size();
+  record.m_checksum = computeChecksum(record, dataChecksum);
+  const char* header = reinterpret_cast<const char*>(&record);
+  m_buffer.insert(m_buffer.end(), header, header + sizeof(record));
+  m_buffer.insert(m_buffer.end(), data, data + size);
+  *lsn = m_bufferLSN + m_buffer.size();
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode WriteAheadLog::flush( const lsn_t& lsn ) noexcept {
+  assert(m_opened && "WriteAheadLog is not opened");
+
+  std::unique_lock<std::mutex> guard(m_lock);
+  assert(lsn <= m_bufferLSN + m_buffer.size() && "Flushing records not appended yet");
+  while(m_durableLSN < lsn && m_flushError == ErrorCode::E_NO_ERROR) {
+    // Another thread is syncing, and its sync or the next one covers the
+    // records of this thread
+    if(m_flushing) {
+      m_flushed.wait(guard);
+      continue;
+    }
+
+    // This thread writes everything appended so far, so that the threads
+    // waiting for later records are served by the same sync
+    m_flushing = true;
+    std::swap(m_buffer, m_flushBuffer);
+    m_buffer.clear();
+    lsn_t begin = m_bufferLSN;
+    lsn_t end = begin + m_flushBuffer.size();
+    m_bufferLSN = end;
+    guard.unlock();
+
+    bool success = pwriteFully(m_file, m_flushBuffer.data(), m_flushBuffer.size(), lsnToOffset(begin)) &&
+                   fdatasync(m_file) == 0;
+
+    guard.lock();
+    m_flushing = false;
+    ++m_numSyncs;
+    if(success) {
+      m_durableLSN = end;
+    }
+    else {
+      m_flushError = ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+    }
+    m_flushed.notify_all();
+  }
+
+  return m_durableLSN >= lsn ? ErrorCode::E_NO_ERROR : m_flushError;
+}
+
+ErrorCode WriteAheadLog::truncate( const lsn_t& lsn ) noexcept {
+  assert(m_opened && "WriteAheadLog is not opened");
+
+  std::lock_guard<std::mutex> guard(m_lock);
+  assert(lsn <= m_durableLSN && "Truncating records not flushed");
+  if(m_flushing || lsn != m_bufferLSN + m_buffer.size() || lsn == m_firstLSN) {
+    return ErrorCode::E_NO_ERROR;
+  }
+
+  // Records left behind the new header by a crash before the file is
+  // truncated have LSNs before the new first one, so they are not replayed
+  ErrorCode err = writeHeader(m_durableLSN);
+  if(err != ErrorCode::E_NO_ERROR) {
+    return err;
+  }
+  if(ftruncate(m_file, sizeof(Header)) != 0) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  return ErrorCode::E_NO_ERROR;
+}
+
+lsn_t WriteAheadLog::getNextLSN() const noexcept {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_bufferLSN + m_buffer.size();
+}
+
+lsn_t WriteAheadLog::getDurableLSN() const noexcept {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_durableLSN;
+}
+
+uint64_t WriteAheadLog::getNumSyncs() const noexcept {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_numSyncs;
+}
+
+bool WriteAheadLog::isOpened() const noexcept {
+  return m_opened;
+}
+
+ErrorCode WriteAheadLog::writeHeader( const lsn_t& firstLSN ) noexcept {
+  Header header;
+  memset(&header, 0, sizeof(header));
+  header.m_magic    = WAL_MAGIC;
+  header.m_firstLSN = firstLSN;
+  header.m_checksum = computeCRC32C(reinterpret_cast<const char*>(&header), offsetof(Header, m_checksum));
+  if(!pwriteFully(m_file, reinterpret_cast<const char*>(&header), sizeof(header), 0) ||
+     fdatasync(m_file) != 0) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  m_firstLSN = firstLSN;
+  return ErrorCode::E_NO_ERROR;
+}
+
+ErrorCode WriteAheadLog::replay( const RedoFunction& redo ) noexcept {
+  // Records are parsed from a chunk of the file. A record that does not fit
+  // in what is left of the chunk is moved to its beginning, and the chunk
+  // is refilled after it, growing it for records larger than a chunk.
+  struct stat fileStat;
+  if(fstat(m_file, &fileStat) != 0) {
+    return ErrorCode::E_STORAGE_CRITICAL_ERROR;
+  }
+  std::vector<char> chunk(WAL_READ_CHUNK_KB*1024);
+  size_t begin = 0;
+  size_t end = 0;
+  bool endOfFile = false;
+  lsn_t lsn = m_firstLSN;
+  while(true) {
+    // The size of a torn header may be anything, so records that would not
+    // fit in the file end the replay before the chunk grows for them
+    size_t needed = sizeof(WALRecord);
+    if(end - begin >= sizeof(WALRecord)) {
+      needed += reinterpret_cast<const WALRecord*>(&chunk[begin])->m_size;
+      if(lsnToOffset(lsn) + needed > static_cast<uint64_t>(fileStat.st_size)) {
+        break;
+      }
+    }
+    if(end - begin < needed && !endOfFile) {
+      memmove(&chunk[0], &chunk[begin], end - begin);
+      end -= begin;
+      begin = 0;
+      if(chunk.size() < needed) {
+        chunk.resize(needed);
+      }
+      ssize_t res = pread(m_file, &chunk[end], chunk.size() - end, lsnToOffset(lsn) + end);
+      if(res < 0 && errno == EINTR) {
+        continue;
+      }
+      if(res < 0) {
+        return ErrorCode::E_STORAGE_UNEXPECTED_READ_ERROR;
+      }
+      endOfFile = res == 0;
+      end += res;
+      continue;
+    }
+
+    // The end of the file, or a record torn by a crash or left from before
+    // the last truncation
+    const WALRecord* record = reinterpret_cast<const WALRecord*>(&chunk[begin]);
+    if(end - begin < needed ||
+       record->m_lsn != lsn ||
+       record->m_checksum != computeChecksum(*record, computeCRC32C(&chunk[begin + sizeof(WALRecord)], record->m_size))) {
+      break;
+    }
+
+    // The record header is copied, as redo may not keep pointers into the
+    // chunk
+    WALRecord header = *record;
+    ErrorCode err = redo(header, &chunk[begin + sizeof(WALRecord)]);
+    if(err != ErrorCode::E_NO_ERROR) {
+      return err;
+    }
+    begin += needed;
+    lsn += needed;
+  }
+
+  // New records overwrite the discarded ones
+  if(ftruncate(m_file, lsnToOffset(lsn)) != 0) {
+    return ErrorCode::E_STORAGE_UNEXPECTED_WRITE_ERROR;
+  }
+  m_bufferLSN   = lsn;
+  m_durableLSN  = lsn;
+  m_flushError  = ErrorCode::E_NO_ERROR;
+  m_numSyncs    = 0;
+  return ErrorCode::E_NO_ERROR;
+}
+
+uint32_t WriteAheadLog::computeChecksum( const WALRecord& record,
+                                         uint32_t dataChecksum ) noexcept {
+  const char* header = reinterpret_cast<const char*>(&record);
+  return computeCRC32C(header + sizeof(record.m_checksum), sizeof(record) - sizeof(record.m_checksum), dataChecksum);
+}
+
+uint64_t WriteAheadLog::lsnToOffset( const lsn_t& lsn ) const noexcept {
+  assert(lsn >= m_firstLSN && "LSN before the beginning of the log");
+  return sizeof(Header) + (lsn - m_firstLSN);
+}
+
+SMILE_NS_END
@@ -0,0 +1,238 @@
+
+
+#ifndef _STORAGE_WRITE_AHEAD_LOG_H_
+#define _STORAGE_WRITE_AHEAD_LOG_H_
+
+#include "../base/base.h"
+#include "types.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Size of the in-memory log buffer. Appending to a full buffer writes it
+ * out first.
+ */
+#define WAL_BUFFER_KB 1024
+
+enum class WALRecordType : uint8_t {
+  /**
+   * The new contents of a range of a page.
+   */
+  E_PAGE_UPDATE,
+
+  /**
+   * The page was released.
+   */
+  E_PAGE_RELEASE
+};
+
+/**
+ * Header of a log record, followed in the log by m_size bytes of data. The
+ * checksum covers the rest of the header and the data, so that records torn
+ * by a crash are detected.
+ */
+struct WALRecord {
+  uint32_t      m_checksum;
+  uint32_t      m_size;
+  lsn_t         m_lsn;
+  pageId_t      m_pageId;
+  uint32_t      m_offset;
+  WALRecordType m_type;
+  uint8_t       m_padding[3];
+};
+
+/**
+ * Redo log of page updates. Records are appended to a memory buffer, and
+ * made durable by flush(), which writes the buffer with a single sequential
+ * write and syncs the file. Commits are grouped: a thread that flushes
+ * while another one is syncing waits for it, and the next sync covers all
+ * the records appended in the meantime, so concurrent writers share syncs.
+ * Log sequence numbers (LSN) are positions in the stream of records, which
+ * keep growing when the log is truncated.
+ */
+class WriteAheadLog final {
+  public:
+    SMILE_NOT_COPYABLE(WriteAheadLog)
+
+    /**
+     * Function applying a record found in the log when it is opened
+     * @param in record The header of the record
+     * @param in data The data of the record
+     * @return E_NO_ERROR to go on with the next record
+     **/
+    using RedoFunction = std::function<ErrorCode (const WALRecord& record, const char* data)>;
+
+    WriteAheadLog() noexcept;
+
+    ~WriteAheadLog() noexcept;
+
+    /**
+     * Opens the log at the given path and replays its records in order. A
+     * torn record and whatever follows it are discarded.
+     * @param in path The path to the log
+     * @param in redo The function applying each record
+     * @return E_STORAGE_INVALID_LOG if the file is not a log, or the error
+     * returned by redo
+     **/
+    ErrorCode open( const std::string& path,
+                    const RedoFunction& redo ) noexcept;
+
+    /**
+     * Creates an empty log at the given path
+     * @param in path The path to the log
+     * @param in overwrite Whether to replace an existing log
+     * @return E_NO_ERROR if the log was created correctly
+     **/
+    ErrorCode create( const std::string& path,
+                      bool overwrite = false ) noexcept;
+
+    /**
+     * Flushes the log and closes it
+     * @return E_NO_ERROR if the log was closed correctly
+     **/
+    ErrorCode close() noexcept;
+
+    /**
+     * Appends a record to the log buffer. It is not durable until flushed.
+     * @param in type The type of the record
+     * @param in pageId The page the record refers to
+     * @param in offset The offset in the page of the updated range
+     * @param in data The new contents of the range
+     * @param in size The size of the range
+     * @param out lsn The LSN following the record, to be passed to flush()
+     * @return E_NO_ERROR if the record was appended correctly
+     **/
+    ErrorCode append( WALRecordType type,
+                      const pageId_t& pageId,
+                      uint32_t offset,
+                      const char* data,
+                      uint32_t size,
+                      lsn_t* lsn ) noexcept;
+
+    /**
+     * Waits until the records before the given LSN are durable, writing and
+     * syncing the log unless another thread is already doing so
+     * @param in lsn The LSN to make durable
+     * @return E_NO_ERROR if the records are durable
+     **/
+    ErrorCode flush( const lsn_t& lsn ) noexcept;
+
+    /**
+     * Discards the records before the given LSN, whose updates must be
+     * durable somewhere else. Records are only discarded all at once, so the
+     * log is kept whole if more records were appended after the LSN.
+     * @param in lsn The LSN up to which records are not needed anymore. It
+     * must have been flushed.
+     * @return E_NO_ERROR if the log was truncated correctly or kept whole
+     **/
+    ErrorCode truncate( const lsn_t& lsn ) noexcept;
+
+    /**
+     * Gets the LSN following the last appended record
+     * @return The LSN of the next record
+     **/
+    lsn_t getNextLSN() const noexcept;
+
+    /**
+     * Gets the LSN up to which records are durable
+     * @return The durable LSN
+     **/
+    lsn_t getDurableLSN() const noexcept;
+
+    /**
+     * Gets the number of times the log was synced since it was opened
+     * @return The number of syncs
+     **/
+    uint64_t getNumSyncs() const noexcept;
+
+    /**
+     * Whether the log is opened
+     * @return true if the log is opened
+     **/
+    bool isOpened() const noexcept;
+
+  private:
+
+    /**
+     * Header at the beginning of the log file.
+     */
+    struct Header {
+      uint64_t  m_magic;
+      lsn_t     m_firstLSN;
+      uint32_t  m_checksum;
+      uint32_t  m_padding;
+    };
+
+    /**
+     * Writes the header of the log and syncs it
+     * @param in firstLSN The LSN of the first record of the file
+     * @return E_NO_ERROR if the header was written correctly
+     **/
+    ErrorCode writeHeader( const lsn_t& firstLSN ) noexcept;
+
+    /**
+     * Reads the records of the log file, applying them, and truncates the
+     * file after the last valid one
+     * @param in redo The function applying each record
+     * @return E_NO_ERROR if the log was replayed correctly
+     **/
+    ErrorCode replay( const RedoFunction& redo ) noexcept;
+
+    /**
+     * Computes the checksum of a record
+     * @param in record The header of the record
+     * @param in dataChecksum The CRC32C of the data of the record
+     * @return The checksum of the record
+     **/
+    static uint32_t computeChecksum( const WALRecord& record,
+                                     uint32_t dataChecksum ) noexcept;
+
+    /**
+     * Converts an LSN to its position in the log file
+     **/
+    uint64_t lsnToOffset( const lsn_t& lsn ) const noexcept;
+
+    // The descriptor of the log file
+    int                     m_file;
+
+    // The LSN of the first record of the file
+    lsn_t                   m_firstLSN;
+
+    // Protects the state below
+    mutable std::mutex      m_lock;
+
+    // Signaled when a flush finishes
+    std::condition_variable m_flushed;
+
+    // Records appended and not written yet
+    std::vector<char>       m_buffer;
+
+    // The buffer being written by the flushing thread
+    std::vector<char>       m_flushBuffer;
+
+    // The LSN of the first record of m_buffer
+    lsn_t                   m_bufferLSN;
+
+    // The LSN up to which records are durable
+    lsn_t                   m_durableLSN;
+
+    // Whether a thread is writing and syncing the log
+    bool                    m_flushing;
+
+    // The error of the last flush, which is reported to every later one
+    ErrorCode               m_flushError;
+
+    // The number of syncs since the log was opened
+    uint64_t                m_numSyncs;
+
+    // Stores if the log was opened and needs to be closed
+    bool                    m_opened;
+};
+
+SMILE_NS_END
+
+#endif /* ifndef _STORAGE_WRITE_AHEAD_LOG_H_ */
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <memory/buffer_pool_set.h>
+#include <cstdio>
+#include <fstream>
+
+SMILE_NS_BEGIN
+
+/**
+ * Creates the configuration of a page size class
+ */
+static PageSizeClassConfig makeClass( uint32_t pageSizeKB,
+                                      uint32_t numFrames ) {
+  PageSizeClassConfig sizeClass;
+  sizeClass.m_storageConfig.m_pageSizeKB = pageSizeKB;
+  sizeClass.m_bufferPoolConfig.m_poolSizeKB = pageSizeKB*numFrames;
+  sizeClass.m_bufferPoolConfig.m_prefetchingDegree = 0;
+  sizeClass.m_bufferPoolConfig.m_numberOfPartitions = 1;
+  return sizeClass;
+}
+
+/**
+ * Tests that the pages of each page size class are kept in their own storage,
+ * with their own page size, and cached in their own frames, and that they
+ * are persisted correctly
+ */
+TEST(BufferPoolSetTest, BufferPoolSetPageSizeClasses) {
+  std::vector<PageSizeClassConfig> classes = { makeClass(64, 8), makeClass(4, 16), makeClass(1024, 2) };
+  BufferPoolSet bufferPools;
+  ASSERT_TRUE(bufferPools.create(classes, "./test.db", true) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPools.getNumClasses() == 3);
+  ASSERT_TRUE(std::ifstream("./test.db.class1") && std::ifstream("./test.db.class2"));
+
+  // More pages than frames are written in every class, so that they are
+  // evicted within their class
+  std::vector<std::vector<pageId_t>> pages(classes.size());
+  for (pageSizeClass_t c = 0; c < bufferPools.getNumClasses(); ++c) {
+    BufferPool* bufferPool = bufferPools.getBufferPool(c);
+    size_t pageSize = bufferPools.getPageSize(c);
+    ASSERT_TRUE(pageSize == classes[c].m_storageConfig.m_pageSizeKB*1024);
+    BufferPoolStatistics stats;
+    ASSERT_TRUE(bufferPool->getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(stats.m_pageSize == pageSize);
+    for (uint32_t i = 0; i < 20; ++i) {
+      BufferHandler bufferHandler;
+      ASSERT_TRUE(bufferPool->alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+      memset(bufferHandler.m_buffer, 'a'+c, pageSize);
+      bufferHandler.m_buffer[pageSize-1] = 'A'+i;
+      ASSERT_TRUE(bufferPool->setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+      ASSERT_TRUE(bufferPool->unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+      pages[c].push_back(bufferHandler.m_pId);
+    }
+  }
+  ASSERT_TRUE(bufferPools.checkpoint() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPools.close() == ErrorCode::E_NO_ERROR);
+
+  std::vector<BufferPoolConfig> bpConfigs;
+  for (auto& sizeClass : classes) {
+    bpConfigs.push_back(sizeClass.m_bufferPoolConfig);
+  }
+  ASSERT_TRUE(bufferPools.open(bpConfigs, "./test.db") == ErrorCode::E_NO_ERROR);
+  for (pageSizeClass_t c = 0; c < bufferPools.getNumClasses(); ++c) {
+    BufferPool* bufferPool = bufferPools.getBufferPool(c);
+    size_t pageSize = bufferPools.getPageSize(c);
+    ASSERT_TRUE(pageSize == classes[c].m_storageConfig.m_pageSizeKB*1024);
+    ASSERT_TRUE(bufferPool->checkConsistency() == ErrorCode::E_NO_ERROR);
+    for (uint32_t i = 0; i < pages[c].size(); ++i) {
+      BufferHandler bufferHandler;
+      ASSERT_TRUE(bufferPool->pin(pages[c][i], &bufferHandler) == ErrorCode::E_NO_ERROR);
+      ASSERT_TRUE(bufferHandler.m_buffer[0] == 'a'+c && bufferHandler.m_buffer[pageSize-1] == 'A'+i);
+      ASSERT_TRUE(bufferPool->unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    }
+  }
+  ASSERT_TRUE(bufferPools.close() == ErrorCode::E_NO_ERROR);
+
+  // A missing class fails to open
+  bpConfigs.push_back(bpConfigs.back());
+  ASSERT_TRUE(bufferPools.open(bpConfigs, "./test.db") != ErrorCode::E_NO_ERROR);
+
+  std::remove("./test.db.class1");
+  std::remove("./test.db.class1.config");
+  std::remove("./test.db.class2");
+  std::remove("./test.db.class2.config");
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
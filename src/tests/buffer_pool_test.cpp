@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 #include <memory/buffer_pool.h>
 #include <tasking/tasking.h>
+#include <atomic>
+#include <map>
 #include <thread>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 SMILE_NS_BEGIN
 
@@ -204,6 +209,1408 @@ TEST(BufferPoolTest, BufferPoolPersistence) {
   ASSERT_TRUE(bufferPoolAux.close() == ErrorCode::E_NO_ERROR);
 }
 
+/**
+ * Tests a Buffer Pool over a storage opened with direct I/O. Every buffer must
+ * be aligned to the I/O alignment of the storage, and pages written through
+ * evictions and at close must be read back after reopening.
+ **/
+TEST(BufferPoolTest, BufferPoolDirectIO) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 256;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 2;
+  FileStorageConfig fsConfig;
+  fsConfig.m_pageSizeKB = 64;
+  fsConfig.m_directIO = true;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", fsConfig, true) == ErrorCode::E_NO_ERROR);
+
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 16; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(reinterpret_cast<uintptr_t>(bufferHandler.m_buffer) % 4096 == 0);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'a'+i, 64*1024);
+    pages.push_back(bufferHandler.m_pId);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < pages.size(); ++i) {
+    ASSERT_TRUE(bufferPool.pin(pages[i], &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'a'+i && bufferHandler.m_buffer[64*1024-1] == 'a'+i);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that pages pinned in batches are read correctly, including when the
+ * batch evicts dirty pages that must be written back before the buffers are
+ * reused, and that checkpoints write all dirty pages.
+ */
+TEST(BufferPoolTest, BufferPoolPinBatch) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*16;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 2;
+  bpConfig.m_ioQueueDepth = 4;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+
+  // Twice as many dirty pages as buffers, so half of them are evicted
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 32; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'a'+i%26, 64*1024);
+    pages.push_back(bufferHandler.m_pId);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  // The first round reads the original contents and writes new ones, which
+  // the second round reads back after they have been evicted again
+  std::vector<BufferHandler> handlers(6);
+  for (uint32_t round = 0; round < 2; ++round) {
+    for (uint32_t first = 0; first < pages.size(); first += handlers.size()) {
+      uint32_t numPages = std::min<uint32_t>(handlers.size(), pages.size()-first);
+      ASSERT_TRUE(bufferPool.pinBatch(&pages[first], numPages, handlers.data()) == ErrorCode::E_NO_ERROR);
+      for (uint32_t i = 0; i < numPages; ++i) {
+        char expected = (round == 0 ? 'a' : 'A')+(first+i)%26;
+        ASSERT_TRUE(handlers[i].m_pId == pages[first+i]);
+        ASSERT_TRUE(handlers[i].m_buffer[0] == expected && handlers[i].m_buffer[64*1024-1] == expected);
+        if (round == 0) {
+          ASSERT_TRUE(bufferPool.setPageDirty(pages[first+i]) == ErrorCode::E_NO_ERROR);
+          memset(handlers[i].m_buffer, 'A'+(first+i)%26, 64*1024);
+        }
+        ASSERT_TRUE(bufferPool.unpin(handlers[i]) == ErrorCode::E_NO_ERROR);
+      }
+    }
+  }
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  // The pool is empty after reopening, so contiguous misses are read in runs
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  handlers.resize(12);
+  ASSERT_TRUE(bufferPool.pinBatch(&pages[4], handlers.size(), handlers.data()) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < handlers.size(); ++i) {
+    ASSERT_TRUE(handlers[i].m_buffer[0] == 'A'+(4+i)%26 && handlers[i].m_buffer[64*1024-1] == 'A'+(4+i)%26);
+    ASSERT_TRUE(bufferPool.unpin(handlers[i]) == ErrorCode::E_NO_ERROR);
+  }
+  for (uint32_t i = 0; i < pages.size(); ++i) {
+    ASSERT_TRUE(bufferPool.pin(pages[i], &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'A'+i%26 && bufferHandler.m_buffer[64*1024-1] == 'A'+i%26);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that a Buffer Pool opened over a read-only mapping returns the
+ * persisted contents of the pages in place and rejects modifications.
+ */
+TEST(BufferPoolTest, BufferPoolReadOnlyMapping) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*4;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 16; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'a'+i, 64*1024);
+    pages.push_back(bufferHandler.m_pId);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  bpConfig.m_readOnlyMapping = true;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_BUFPOOL_READ_ONLY);
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.adviseAccess(AccessPattern::E_SEQUENTIAL) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < pages.size(); ++i) {
+    ASSERT_TRUE(bufferPool.pin(pages[i], &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'a'+i && bufferHandler.m_buffer[64*1024-1] == 'a'+i);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  // Pages are not copied, so consecutive pages are consecutive in memory
+  std::vector<BufferHandler> handlers(pages.size());
+  ASSERT_TRUE(bufferPool.adviseAccess(AccessPattern::E_RANDOM, pages[0], pages.size()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pinBatch(pages.data(), pages.size(), handlers.data()) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < handlers.size(); ++i) {
+    ASSERT_TRUE(i == 0 || handlers[i].m_buffer == handlers[i-1].m_buffer + 64*1024);
+    ASSERT_TRUE(bufferPool.unpin(handlers[i]) == ErrorCode::E_NO_ERROR);
+  }
+
+  ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_BUFPOOL_READ_ONLY);
+  ASSERT_TRUE(bufferPool.setPageDirty(pages[0]) == ErrorCode::E_BUFPOOL_READ_ONLY);
+  ASSERT_TRUE(bufferPool.release(pages[0]) == ErrorCode::E_BUFPOOL_READ_ONLY);
+
+  BufferPoolStatistics stats;
+  ASSERT_TRUE(bufferPool.getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(stats.m_numReservedPages > pages.back());
+  ASSERT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that the storage grows according to the growth policy, that pages
+ * are allocated in order from the reserved extents, and that free pages of
+ * an extent are not lost across reopenings.
+ */
+TEST(BufferPoolTest, BufferPoolGrowth) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*8;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 4;
+  bpConfig.m_growthPolicy = GrowthPolicy::E_FIXED;
+  bpConfig.m_growthPages = 16;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+
+  // Page 0 is protected, so pages are allocated from 1 onwards
+  BufferHandler bufferHandler;
+  BufferPoolStatistics stats;
+  for (uint32_t i = 1; i <= 20; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_pId == i);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(stats.m_numReservedPages == (i < 16 ? 16 : 32));
+  }
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  // Doubling, starting from the 32 pages already reserved
+  bpConfig.m_growthPolicy = GrowthPolicy::E_GEOMETRIC;
+  bpConfig.m_growthPages = 4;
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 21; i <= 40; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_pId == i);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(stats.m_numReservedPages == 64);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that pages corrupted on disk are detected when loaded, or on their
+ * first pin with lazy verification
+ */
+TEST(BufferPoolTest, BufferPoolChecksums) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*4;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_ioQueueDepth = 32;
+  FileStorageConfig fsConfig;
+  fsConfig.m_checksums = true;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", fsConfig, true) == ErrorCode::E_NO_ERROR);
+
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 16; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'a'+i, 64*1024);
+    pages.push_back(bufferHandler.m_pId);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  std::fstream file("./test.db", std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+  file.seekp(pages[5]*64*1024 + 1000);
+  file.put('z');
+  file.close();
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(pages[4], &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(pages[5], &bufferHandler) == ErrorCode::E_STORAGE_CHECKSUM_MISMATCH);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  // The page stays marked as corrupted while it is in the Buffer Pool
+  ASSERT_TRUE(bufferPool.pin(pages[5], &bufferHandler) == ErrorCode::E_STORAGE_CHECKSUM_MISMATCH);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+
+  std::vector<BufferHandler> handlers(3);
+  std::vector<pageId_t> batch = {pages[6], pages[5], pages[7]};
+  ASSERT_TRUE(bufferPool.pinBatch(batch.data(), batch.size(), handlers.data()) == ErrorCode::E_STORAGE_CHECKSUM_MISMATCH);
+  for (uint32_t i = 0; i < handlers.size(); ++i) {
+    ASSERT_TRUE(bufferPool.unpin(handlers[i]) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  // Loads without a pin are not verified in lazy mode, so the corruption is
+  // only reported by the first pin
+  bpConfig.m_lazyChecksums = true;
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(pages[5], nullptr, false) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(pages[5], &bufferHandler) == ErrorCode::E_STORAGE_CHECKSUM_MISMATCH);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(pages[6], nullptr, false) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(pages[6], &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_buffer[0] == 'a'+6);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.crc");
+}
+
+/**
+ * Tests a Buffer Pool over a storage striped across several files, with
+ * batched pins and checkpoints whose runs cross stripe boundaries
+ */
+TEST(BufferPoolTest, BufferPoolStriping) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*16;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_ioQueueDepth = 32;
+  FileStorageConfig fsConfig;
+  fsConfig.m_numStripes = 3;
+  fsConfig.m_stripePages = 4;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", fsConfig, true) == ErrorCode::E_NO_ERROR);
+
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 40; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+i, 64*1024);
+    pages.push_back(bufferHandler.m_pId);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  // Hints on ranges covering partial stripe units of every data file
+  ASSERT_TRUE(bufferPool.adviseAccess(AccessPattern::E_SEQUENTIAL) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.adviseAccess(AccessPattern::E_WILL_NEED, 5, 17) == ErrorCode::E_NO_ERROR);
+  std::vector<BufferHandler> handlers(10);
+  for (uint32_t i = 0; i < pages.size(); i += handlers.size()) {
+    ASSERT_TRUE(bufferPool.pinBatch(&pages[i], handlers.size(), handlers.data()) == ErrorCode::E_NO_ERROR);
+    for (uint32_t j = 0; j < handlers.size(); ++j) {
+      ASSERT_TRUE(handlers[j].m_buffer[0] == 'A'+i+j && handlers[j].m_buffer[64*1024-1] == 'A'+i+j);
+      ASSERT_TRUE(bufferPool.unpin(handlers[j]) == ErrorCode::E_NO_ERROR);
+    }
+  }
+
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.1");
+  std::remove("./test.db.2");
+}
+
+/**
+ * Tests a pool over an in-memory storage behind an emulated device, where
+ * evicted pages must be read back from memory
+ */
+TEST(BufferPoolTest, BufferPoolInMemory) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*16;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_ioQueueDepth = 32;
+  bpConfig.m_deviceProfile = DeviceProfile::nvme();
+  FileStorageConfig fsConfig;
+  fsConfig.m_inMemory = true;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./inmemory.db", fsConfig) == ErrorCode::E_NO_ERROR);
+
+  BufferHandler bufferHandler;
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 40; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+i, 64*1024);
+    pages.push_back(bufferHandler.m_pId);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  std::vector<BufferHandler> handlers(10);
+  for (uint32_t i = 0; i < pages.size(); i += handlers.size()) {
+    ASSERT_TRUE(bufferPool.pinBatch(&pages[i], handlers.size(), handlers.data()) == ErrorCode::E_NO_ERROR);
+    for (uint32_t j = 0; j < handlers.size(); ++j) {
+      ASSERT_TRUE(handlers[j].m_buffer[0] == 'A'+i+j && handlers[j].m_buffer[64*1024-1] == 'A'+i+j);
+      ASSERT_TRUE(bufferPool.unpin(handlers[j]) == ErrorCode::E_NO_ERROR);
+    }
+  }
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+
+  // Only 16 of the 40 pages fit in the pool, so the others went through the
+  // storage and back
+  BufferPoolStatistics stats;
+  ASSERT_TRUE(bufferPool.getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(stats.m_io.m_pagesWritten >= 24 && stats.m_io.m_pagesRead >= 24);
+  ASSERT_TRUE(stats.m_io.m_bytesRead == stats.m_io.m_pagesRead*64*1024 && stats.m_io.m_reserveCalls > 0);
+
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_FALSE(std::ifstream("./inmemory.db"));
+}
+
+/**
+ * Tests that committed updates survive a crash of the process, being redone
+ * from the write-ahead log when the pool is opened again, and that the log
+ * is truncated by checkpoints
+ */
+TEST(BufferPoolTest, BufferPoolWriteAheadLog) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*16;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  BufferHandler bufferHandler;
+  lsn_t lsn;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.logUpdate(bufferHandler, 0, 1, &lsn) == ErrorCode::E_BUFPOOL_NO_WRITE_AHEAD_LOG);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  // The child logs updates of a checkpointed page and of pages allocated
+  // after the checkpoint, and exits without closing the pool
+  bpConfig.m_writeAheadLog = true;
+  pid_t child = fork();
+  if (child == 0) {
+    BufferPool crashing;
+    if (crashing.open(bpConfig, "./test.db") != ErrorCode::E_NO_ERROR) {
+      _exit(1);
+    }
+    for (pageId_t page = 1; page < 6; ++page) {
+      BufferHandler handler;
+      if (page > 1 && crashing.alloc(&handler) != ErrorCode::E_NO_ERROR) {
+        _exit(1);
+      }
+      if (page == 1 && crashing.pin(page, &handler) != ErrorCode::E_NO_ERROR) {
+        _exit(1);
+      }
+      memset(handler.m_buffer + 100, 'A'+page, 1000);
+      if (crashing.logUpdate(handler, 100, 1000, &lsn) != ErrorCode::E_NO_ERROR) {
+        _exit(1);
+      }
+      crashing.unpin(handler);
+    }
+    crashing.release(5);
+    _exit(crashing.commit(lsn) == ErrorCode::E_NO_ERROR ? 0 : 1);
+  }
+  int status;
+  ASSERT_TRUE(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  for (pageId_t page = 1; page < 5; ++page) {
+    ASSERT_TRUE(bufferPool.pin(page, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[100] == 'A'+page && bufferHandler.m_buffer[1099] == 'A'+page);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  // The released page is handed out again, and the redone ones are not
+  do {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_pId > 4);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  } while (bufferHandler.m_pId != 5);
+
+  // Opening checkpointed the redone updates, so only new ones are logged
+  ASSERT_TRUE(std::ifstream("./test.db.wal", std::ios_base::ate).tellg() < 1000);
+  ASSERT_TRUE(bufferPool.pin(1, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  bufferHandler.m_buffer[0] = 'z';
+  ASSERT_TRUE(bufferPool.logUpdate(bufferHandler, 0, 1, &lsn) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.commit(lsn) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(std::ifstream("./test.db.wal", std::ios_base::ate).tellg() < 100);
+  std::remove("./test.db.wal");
+}
+
+/**
+ * Tests that pages evicted after the last checkpoint verify after a crash,
+ * whether they are redone from the log or not
+ */
+TEST(BufferPoolTest, BufferPoolChecksumRecovery) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*2;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_writeAheadLog = true;
+  FileStorageConfig fsConfig;
+  fsConfig.m_checksums = true;
+  BufferHandler bufferHandler;
+  lsn_t lsn;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", fsConfig, true) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  // The pool only holds two pages, so most of the logged ones are evicted
+  pid_t child = fork();
+  if (child == 0) {
+    BufferPool crashing;
+    if (crashing.open(bpConfig, "./test.db") != ErrorCode::E_NO_ERROR) {
+      _exit(1);
+    }
+    for (uint32_t i = 0; i < 6; ++i) {
+      BufferHandler handler;
+      if (crashing.alloc(&handler) != ErrorCode::E_NO_ERROR) {
+        _exit(1);
+      }
+      memset(handler.m_buffer, 'a'+i, 64*1024);
+      if (crashing.logUpdate(handler, 0, 64*1024, &lsn) != ErrorCode::E_NO_ERROR) {
+        _exit(1);
+      }
+      crashing.unpin(handler);
+    }
+    _exit(crashing.commit(lsn) == ErrorCode::E_NO_ERROR ? 0 : 1);
+  }
+  int status;
+  ASSERT_TRUE(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  // Opening again verifies the pages against the checksums checkpointed
+  // after they were redone
+  for (uint32_t open = 0; open < 2; ++open) {
+    ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+    for (pageId_t page = 1; page < 7; ++page) {
+      ASSERT_TRUE(bufferPool.pin(page, &bufferHandler) == ErrorCode::E_NO_ERROR);
+      ASSERT_TRUE(bufferHandler.m_buffer[0] == 'a'+page-1 && bufferHandler.m_buffer[64*1024-1] == 'a'+page-1);
+      ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    }
+    ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  }
+
+  // Without the log, the pages evicted before a crash keep the checksums
+  // written with them
+  bpConfig.m_writeAheadLog = false;
+  child = fork();
+  if (child == 0) {
+    BufferPool crashing;
+    if (crashing.open(bpConfig, "./test.db") != ErrorCode::E_NO_ERROR) {
+      _exit(1);
+    }
+    for (pageId_t page = 1; page < 7; ++page) {
+      BufferHandler handler;
+      if (crashing.pin(page, &handler) != ErrorCode::E_NO_ERROR) {
+        _exit(1);
+      }
+      memset(handler.m_buffer, 'A'+page, 64*1024);
+      crashing.setPageDirty(page);
+      crashing.unpin(handler);
+    }
+    _exit(0);
+  }
+  ASSERT_TRUE(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  for (pageId_t page = 1; page < 5; ++page) {
+    ASSERT_TRUE(bufferPool.pin(page, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'A'+page && bufferHandler.m_buffer[64*1024-1] == 'A'+page);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.wal");
+  std::remove("./test.db.crc");
+}
+
+/**
+ * Tests that checkpoints stage the pages they write in the double-write
+ * buffer, and that pages torn in the middle of a checkpoint are restored from
+ * it when the pool is opened
+ */
+TEST(BufferPoolTest, BufferPoolDoubleWrite) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*16;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_doubleWrite = true;
+  bpConfig.m_doubleWriteKB = 64*2;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  for (pageId_t page = 1; page < 6; ++page) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_pId == page);
+    memset(bufferHandler.m_buffer, 'A'+page, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(page) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  // Five pages and the allocation table are written in four batches
+  ASSERT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  // Nothing is left staged after a checkpoint
+  DoubleWriteBuffer dwb;
+  auto ignore = [] (const pageId_t& pageId, const char* data) { return ErrorCode::E_NO_ERROR; };
+  ASSERT_TRUE(dwb.open("./test.db.dwb", 64*1024, ignore) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dwb.getNumRestored() == 0);
+
+  // A crash after staging a new version of page 2 and while writing it in
+  // place
+  std::string newPage(64*1024, 'z');
+  pageId_t pageId = 2;
+  const char* data = newPage.data();
+  ASSERT_TRUE(dwb.stage(&pageId, &data, 1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dwb.close() == ErrorCode::E_NO_ERROR);
+  {
+    std::fstream file("./test.db", std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    file.seekp(2*64*1024);
+    file.write(newPage.data(), 4096);
+  }
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  for (pageId_t page = 1; page < 6; ++page) {
+    char expected = page == 2 ? 'z' : 'A'+page;
+    ASSERT_TRUE(bufferPool.pin(page, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == expected && bufferHandler.m_buffer[64*1024-1] == expected);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  // Restored pages are not restored again
+  ASSERT_TRUE(dwb.open("./test.db.dwb", 64*1024, ignore) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dwb.getNumRestored() == 0);
+  ASSERT_TRUE(dwb.close() == ErrorCode::E_NO_ERROR);
+
+  // Creating a storage without the double-write buffer removes a stale one
+  bpConfig.m_doubleWrite = false;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_FALSE(std::ifstream("./test.db.dwb"));
+}
+
+/**
+ * Tests that the pages of a pool whose write-back thread runs while pages are
+ * evicted and checkpointed are persisted correctly
+ */
+TEST(BufferPoolTest, BufferPoolWriteBack) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*8;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_writeBackIntervalMs = 1;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 64; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+i%26, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    pages.push_back(bufferHandler.m_pId);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    if (i % 16 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      ASSERT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+    }
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < pages.size(); ++i) {
+    ASSERT_TRUE(bufferPool.pin(pages[i], &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'A'+i%26 && bufferHandler.m_buffer[64*1024-1] == 'A'+i%26);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that the space of released pages is given back to the file system by
+ * the next checkpoint, unless they are allocated again before
+ */
+TEST(BufferPoolTest, BufferPoolPunchHoles) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*8;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 2;
+  bpConfig.m_punchHoles = true;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < 32; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId%26, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+  struct stat before;
+  ASSERT_TRUE(stat("./test.db", &before) == 0);
+
+  for (pageId_t page = 1; page <= 16; ++page) {
+    ASSERT_TRUE(bufferPool.release(page) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.checkpoint() == ErrorCode::E_NO_ERROR);
+  struct stat after;
+  ASSERT_TRUE(stat("./test.db", &after) == 0);
+  ASSERT_TRUE(before.st_blocks - after.st_blocks >= 16*64*1024/512);
+  ASSERT_TRUE(after.st_size == before.st_size);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+
+  // A page allocated again before the checkpoint keeps its contents
+  ASSERT_TRUE(bufferPool.release(20) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+  pageId_t reused = bufferHandler.m_pId;
+  memset(bufferHandler.m_buffer, 'z', 64*1024);
+  ASSERT_TRUE(bufferPool.setPageDirty(reused) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(reused, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_buffer[0] == 'z' && bufferHandler.m_buffer[64*1024-1] == 'z');
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  for (pageId_t page = 21; page <= 32; ++page) {
+    ASSERT_TRUE(bufferPool.pin(page, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'A'+page%26 && bufferHandler.m_buffer[64*1024-1] == 'A'+page%26);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that each partition evicts only its own buffers, so that pages keep
+ * landing in the buffers of their partition, and that its clock hand skips
+ * the pinned ones.
+ */
+TEST(BufferPoolTest, BufferPoolPartitionClockSweep) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*8;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 4;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+
+  for (uint32_t i = 0; i < 32; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_bId % 4 == bufferHandler.m_pId % 4);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  // A pinned page keeps its buffer while the rest of its partition cycles
+  // through the other one
+  BufferHandler pinned;
+  ASSERT_TRUE(bufferPool.alloc(&pinned) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < 32; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_bId % 4 == bufferHandler.m_pId % 4);
+    ASSERT_TRUE(bufferHandler.m_bId != pinned.m_bId);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.pin(pinned.m_pId, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_bId == pinned.m_bId);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.unpin(pinned) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that concurrent pins and unpins of the same pages, which update the
+ * descriptors without taking any lock, keep their reference counts, while
+ * other pages are evicted from the pool. Once all are unpinned, every buffer
+ * can be reused.
+ */
+TEST(BufferPoolTest, BufferPoolConcurrentPins) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*8;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 2;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 32; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId%26, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    pages.push_back(bufferHandler.m_pId);
+  }
+
+  // Two hot pages are shared by all threads, and the others are pinned in
+  // turns, so that they keep being evicted
+  std::atomic<uint32_t> failures{0};
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] () {
+      for (uint32_t i = 0; i < 2000; ++i) {
+        pageId_t pId = pages[(i % 4 == 0) ? 2 + (i/4 + t) % (pages.size()-2) : i % 2];
+        BufferHandler handler;
+        if (bufferPool.pin(pId, &handler) != ErrorCode::E_NO_ERROR) {
+          ++failures;
+          continue;
+        }
+        if (handler.m_buffer[0] != 'A'+pId%26 || handler.m_buffer[64*1024-1] != 'A'+pId%26) {
+          ++failures;
+        }
+        bufferPool.unpin(handler);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(failures == 0);
+
+  // No reference is left behind
+  std::vector<BufferHandler> handlers(8);
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(bufferPool.pin(pages[2+i], &handlers[i]) == ErrorCode::E_NO_ERROR);
+  }
+  for (auto& handler : handlers) {
+    ASSERT_TRUE(bufferPool.unpin(handler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that optimistic reads are validated while their page stays in its
+ * buffer unmodified, and fail once it is being modified, marked as dirty or
+ * evicted. Pages not in the pool are loaded by the read.
+ */
+TEST(BufferPoolTest, BufferPoolOptimisticReads) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*4;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  BufferHandler bufferHandler;
+  OptimisticReadHandler readHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  // The first pages were evicted, and are loaded again
+  ASSERT_TRUE(bufferPool.beginOptimisticRead(1, &readHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(readHandler.m_buffer[0] == 'B' && readHandler.m_buffer[64*1024-1] == 'B');
+  ASSERT_TRUE(bufferPool.validateOptimisticRead(readHandler));
+  ASSERT_TRUE(bufferPool.validateOptimisticRead(readHandler));
+
+  // Pins do not invalidate reads, but modifications do, as soon as they
+  // begin. Reads that begin during a modification are not valid either, even
+  // once it ends.
+  ASSERT_TRUE(bufferPool.pin(1, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.validateOptimisticRead(readHandler));
+  ASSERT_TRUE(bufferPool.beginWrite(bufferHandler) == ErrorCode::E_NO_ERROR);
+  bufferHandler.m_buffer[0] = 'z';
+  ASSERT_FALSE(bufferPool.validateOptimisticRead(readHandler));
+  OptimisticReadHandler duringWrite;
+  ASSERT_TRUE(bufferPool.beginOptimisticRead(1, &duringWrite) == ErrorCode::E_NO_ERROR);
+  ASSERT_FALSE(bufferPool.validateOptimisticRead(duringWrite));
+  ASSERT_TRUE(bufferPool.endWrite(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_FALSE(bufferPool.validateOptimisticRead(readHandler));
+  ASSERT_FALSE(bufferPool.validateOptimisticRead(duringWrite));
+  ASSERT_TRUE(bufferPool.beginOptimisticRead(1, &readHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(readHandler.m_buffer[0] == 'z');
+  ASSERT_TRUE(bufferPool.validateOptimisticRead(readHandler));
+
+  // Marking the page as dirty invalidates them too
+  ASSERT_TRUE(bufferPool.setPageDirty(1) == ErrorCode::E_NO_ERROR);
+  ASSERT_FALSE(bufferPool.validateOptimisticRead(readHandler));
+  ASSERT_TRUE(bufferPool.beginOptimisticRead(1, &readHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.validateOptimisticRead(readHandler));
+
+  // So does evicting the page
+  for (uint32_t i = 0; i < 4*6; ++i) {
+    ASSERT_TRUE(bufferPool.pin(2 + i%6, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_FALSE(bufferPool.validateOptimisticRead(readHandler));
+  ASSERT_TRUE(bufferPool.beginOptimisticRead(1, &readHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(readHandler.m_buffer[0] == 'z' && readHandler.m_buffer[64*1024-1] == 'B');
+  ASSERT_TRUE(bufferPool.validateOptimisticRead(readHandler));
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that Swips are swizzled to the buffers of their pages once pinned,
+ * one per buffer, and are unswizzled when their pages are evicted or
+ * released.
+ */
+TEST(BufferPoolTest, BufferPoolSwizzling) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*4;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  Swip swip(1), other(1);
+  ASSERT_TRUE(swip.m_bId == INVALID_BUFFER_ID);
+  ASSERT_TRUE(bufferPool.pinSwip(&swip, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_pId == 1 && bufferHandler.m_buffer[0] == 'B');
+  ASSERT_TRUE(swip.m_bId == bufferHandler.m_bId);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pinSwip(&swip, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_bId == swip.m_bId && bufferHandler.m_buffer[0] == 'B');
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+
+  // The buffer already has a Swip
+  ASSERT_TRUE(bufferPool.pinSwip(&other, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_bId == swip.m_bId && other.m_bId == INVALID_BUFFER_ID);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+
+  // Evicting the page unswizzles the Swip, which is swizzled again on its
+  // next pin
+  for (uint32_t i = 0; i < 4*6; ++i) {
+    ASSERT_TRUE(bufferPool.pin(2 + i%6, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(swip.m_bId == INVALID_BUFFER_ID);
+  ASSERT_TRUE(bufferPool.pinSwip(&swip, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_buffer[0] == 'B' && swip.m_bId == bufferHandler.m_bId);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+
+  // Once unswizzled, the buffer takes another Swip
+  bufferPool.unswizzle(&swip);
+  ASSERT_TRUE(swip.m_bId == INVALID_BUFFER_ID);
+  ASSERT_TRUE(bufferPool.pinSwip(&other, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(other.m_bId == bufferHandler.m_bId);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.release(1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(other.m_bId == INVALID_BUFFER_ID);
+
+  // Closing unswizzles the rest
+  Swip last(2);
+  ASSERT_TRUE(bufferPool.pinSwip(&last, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(last.m_bId == INVALID_BUFFER_ID);
+}
+
+/**
+ * Tests that the tasks of a single thread keep their misses in flight at the
+ * same time when pinning asynchronously, each one yielding while its page is
+ * read, and that pins outside of tasks fall back to regular pins
+ */
+TEST(BufferPoolTest, BufferPoolAsyncPins) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*8;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_ioQueueDepth = 32;
+  bpConfig.m_deviceProfile = DeviceProfile::nvme();
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 32; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId%26, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    pages.push_back(bufferHandler.m_pId);
+  }
+
+  // Each task pins its own pages, most of which were evicted
+  struct Params {
+    BufferPool*             m_bp;
+    const pageId_t*         m_pages;
+    std::atomic<uint32_t>*  m_waiting;
+    std::atomic<uint32_t>*  m_maxWaiting;
+    std::atomic<uint32_t>*  m_failures;
+  };
+  std::atomic<uint32_t> waiting{0};
+  std::atomic<uint32_t> maxWaiting{0};
+  std::atomic<uint32_t> failures{0};
+  std::vector<Params> params(6);
+  SyncCounter counter;
+  for (uint32_t t = 0; t < params.size(); ++t) {
+    params[t] = Params{&bufferPool, &pages[t*4], &waiting, &maxWaiting, &failures};
+    Task pinTask {
+      [] (void* args) {
+        Params* params = reinterpret_cast<Params*>(args);
+        for (uint32_t i = 0; i < 4; ++i) {
+          pageId_t pId = params->m_pages[i];
+          BufferHandler handler;
+          uint32_t current = ++(*params->m_waiting);
+          if (current > *params->m_maxWaiting) {
+            *params->m_maxWaiting = current;
+          }
+          ErrorCode err = params->m_bp->pinAsync(pId, &handler);
+          --(*params->m_waiting);
+          if (err != ErrorCode::E_NO_ERROR) {
+            ++(*params->m_failures);
+            continue;
+          }
+          if (handler.m_buffer[0] != 'A'+pId%26 || handler.m_buffer[64*1024-1] != 'A'+pId%26) {
+            ++(*params->m_failures);
+          }
+          params->m_bp->unpin(handler);
+        }
+      },
+      &params[t]
+    };
+    executeTaskAsync(0, pinTask, &counter);
+  }
+  counter.join();
+  ASSERT_TRUE(failures == 0);
+  ASSERT_TRUE(maxWaiting > 1);
+
+  ASSERT_TRUE(bufferPool.pinAsync(pages[0], &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_buffer[0] == 'A'+pages[0]%26);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that a checkpoint waits for the write-back of a dirty page evicted by
+ * an asynchronous pin of another task, whose buffer already holds the pinned
+ * page, before it syncs the storage and truncates the log
+ */
+TEST(BufferPoolTest, BufferPoolCheckpointAsyncEviction) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*4;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_ioQueueDepth = 32;
+  bpConfig.m_writeAheadLog = true;
+  bpConfig.m_deviceProfile = DeviceProfile::hdd();
+  BufferHandler bufferHandler;
+  lsn_t lsn;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId, 64*1024);
+    ASSERT_TRUE(bufferPool.logUpdate(bufferHandler, 0, 64*1024, &lsn) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    pages.push_back(bufferHandler.m_pId);
+  }
+  ASSERT_TRUE(bufferPool.commit(lsn) == ErrorCode::E_NO_ERROR);
+
+  // The pinning task starts the checkpointing one, which runs while the
+  // write-back of the evicted page is in flight
+  struct Params {
+    BufferPool*   m_bp;
+    pageId_t      m_pId;
+    SyncCounter*  m_counter;
+    Task          m_checkpointTask;
+    uint64_t      m_pendingBefore;
+    uint64_t      m_pendingAfter;
+    bool          m_failed;
+  };
+  SyncCounter counter;
+  Params params{&bufferPool, pages[0], &counter, Task{}, 0, 0, false};
+  params.m_checkpointTask = Task {
+    [] (void* args) {
+      Params* params = reinterpret_cast<Params*>(args);
+      BufferPoolStatistics stats;
+      params->m_bp->getStatistics(&stats);
+      params->m_pendingBefore = stats.m_numPendingWriteBacks;
+      if (params->m_bp->checkpoint() != ErrorCode::E_NO_ERROR) {
+        params->m_failed = true;
+      }
+      params->m_bp->getStatistics(&stats);
+      params->m_pendingAfter = stats.m_numPendingWriteBacks;
+    },
+    &params
+  };
+  Task evictingTask {
+    [] (void* args) {
+      Params* params = reinterpret_cast<Params*>(args);
+      executeTaskAsync(0, params->m_checkpointTask, params->m_counter);
+      BufferHandler handler;
+      if (params->m_bp->pinAsync(params->m_pId, &handler) != ErrorCode::E_NO_ERROR) {
+        params->m_failed = true;
+        return;
+      }
+      if (handler.m_buffer[0] != 'A'+params->m_pId || handler.m_buffer[64*1024-1] != 'A'+params->m_pId) {
+        params->m_failed = true;
+      }
+      params->m_bp->unpin(handler);
+    },
+    &params
+  };
+  executeTaskAsync(0, evictingTask, &counter);
+  counter.join();
+  ASSERT_FALSE(params.m_failed);
+  ASSERT_TRUE(params.m_pendingBefore == 1);
+  ASSERT_TRUE(params.m_pendingAfter == 0);
+  stopThreadPool();
+
+  // Every page is in the storage, as the log was truncated
+  ASSERT_TRUE(std::ifstream("./test.db.wal", std::ios_base::ate).tellg() < 100);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.wal");
+}
+
+/**
+ * Tests that an asynchronous pin returns only once the write-back of the
+ * evicted page has completed too, when the page is read from a faster
+ * device than the one the victim is written to
+ */
+TEST(BufferPoolTest, BufferPoolAsyncEvictionSlowWrite) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*2;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_ioQueueDepth = 32;
+  FileStorageConfig fsConfig;
+  fsConfig.m_numStripes = 2;
+  fsConfig.m_stripePages = 1;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", fsConfig, true) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < 5; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  // Even pages are on the first stripe and odd ones on the second. Page 2 is
+  // dirtied and then evicted by page 5, whose read follows the one of page 3
+  // and skips the seek the write of page 2 pays.
+  bpConfig.m_deviceProfile = DeviceProfile::hdd();
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(2, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  bufferHandler.m_buffer[0] = 'z';
+  ASSERT_TRUE(bufferPool.setPageDirty(2) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  BufferHandler pinned;
+  ASSERT_TRUE(bufferPool.pin(3, &pinned) == ErrorCode::E_NO_ERROR);
+
+  struct Params {
+    BufferPool*   m_bp;
+    uint64_t      m_pendingAfter;
+    bool          m_failed;
+  };
+  Params params{&bufferPool, 0, false};
+  Task evictingTask {
+    [] (void* args) {
+      Params* params = reinterpret_cast<Params*>(args);
+      BufferHandler handler;
+      if (params->m_bp->pinAsync(5, &handler) != ErrorCode::E_NO_ERROR) {
+        params->m_failed = true;
+        return;
+      }
+      BufferPoolStatistics stats;
+      params->m_bp->getStatistics(&stats);
+      params->m_pendingAfter = stats.m_numPendingWriteBacks;
+      if (handler.m_buffer[0] != 'A'+5 || handler.m_buffer[64*1024-1] != 'A'+5) {
+        params->m_failed = true;
+      }
+      params->m_bp->unpin(handler);
+    },
+    &params
+  };
+  SyncCounter counter;
+  executeTaskAsync(0, evictingTask, &counter);
+  counter.join();
+  ASSERT_FALSE(params.m_failed);
+  ASSERT_TRUE(params.m_pendingAfter == 0);
+  stopThreadPool();
+
+  ASSERT_TRUE(bufferPool.unpin(pinned) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.pin(2, &bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_buffer[0] == 'z' && bufferHandler.m_buffer[1] == 'A'+2);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.1");
+}
+
+/**
+ * Tests that sequential and strided scans are detected and the pages ahead
+ * of them are prefetched with vectored reads, which the scans then find
+ * loaded, and that free pages ahead of a scan are not prefetched
+ */
+TEST(BufferPoolTest, BufferPoolPrefetch) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*16;
+  bpConfig.m_prefetchingDegree = 8;
+  bpConfig.m_maxPrefetchedPages = 16;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_ioQueueDepth = 32;
+  bpConfig.m_deviceProfile = DeviceProfile::sataSSD();
+  FileStorageConfig fsConfig;
+  fsConfig.m_pageSizeKB = 64;
+  fsConfig.m_inMemory = true;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", fsConfig, true) == ErrorCode::E_NO_ERROR);
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 48; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId%26, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    pages.push_back(bufferHandler.m_pId);
+  }
+  for (uint32_t i = 40; i < 48; ++i) {
+    ASSERT_TRUE(bufferPool.release(pages[i]) == ErrorCode::E_NO_ERROR);
+  }
+
+  // Most of the pages of the scan were evicted, but they are read ahead of
+  // it in runs of several pages
+  BufferPoolStatistics before;
+  BufferPoolStatistics after;
+  ASSERT_TRUE(bufferPool.getStatistics(&before) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(before.m_numPrefetchedPages == 0);
+  for (uint32_t i = 0; i < 40; ++i) {
+    ASSERT_TRUE(bufferPool.pin(pages[i], &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'A'+pages[i]%26);
+    ASSERT_TRUE(bufferHandler.m_buffer[64*1024-1] == 'A'+pages[i]%26);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_TRUE(bufferPool.getStatistics(&after) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(after.m_numPrefetchedPages > 0);
+  ASSERT_TRUE(after.m_io.m_readCalls - before.m_io.m_readCalls < after.m_io.m_pagesRead - before.m_io.m_pagesRead);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+
+  // Strided scans are prefetched too
+  before = after;
+  for (uint32_t i = 0; i < 40; i += 3) {
+    ASSERT_TRUE(bufferPool.pin(pages[i], &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'A'+pages[i]%26);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_TRUE(bufferPool.getStatistics(&after) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(after.m_numPrefetchedPages > before.m_numPrefetchedPages);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+
+  stopThreadPool();
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that compaction moves the pages at the end of the storage to the free
+ * pages at its beginning, keeping their contents, except those pinned, and
+ * truncates the storage after the last allocated page
+ */
+TEST(BufferPoolTest, BufferPoolCompaction) {
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*8;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 2;
+  bpConfig.m_punchHoles = true;
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+
+  // The contents of each page are given by the page it was allocated as
+  std::map<pageId_t, char> contents;
+  for (uint32_t i = 0; i < 40; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    contents[bufferHandler.m_pId] = 'A'+bufferHandler.m_pId%26;
+    memset(bufferHandler.m_buffer, contents[bufferHandler.m_pId], 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  for (pageId_t page = 1; page <= 30; page += 2) {
+    ASSERT_TRUE(bufferPool.release(page) == ErrorCode::E_NO_ERROR);
+    contents.erase(page);
+  }
+
+  BufferHandler pinned;
+  ASSERT_TRUE(bufferPool.pin(38, &pinned) == ErrorCode::E_NO_ERROR);
+  std::vector<std::pair<pageId_t, pageId_t>> relocations;
+  ASSERT_TRUE(bufferPool.compact(&relocations) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  for (auto& relocation : relocations) {
+    ASSERT_TRUE(relocation.first > relocation.second && relocation.first != 38);
+    ASSERT_TRUE(contents.count(relocation.first) == 1 && contents.count(relocation.second) == 0);
+    contents[relocation.second] = contents[relocation.first];
+    contents.erase(relocation.first);
+  }
+  BufferPoolStatistics stats;
+  ASSERT_TRUE(bufferPool.getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(stats.m_numReservedPages == 39);
+  ASSERT_TRUE(bufferPool.unpin(pinned) == ErrorCode::E_NO_ERROR);
+
+  // Once unpinned, it is moved too
+  ASSERT_TRUE(bufferPool.compact(&relocations) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(relocations.size() == 1 && relocations[0].first == 38);
+  contents[relocations[0].second] = contents[38];
+  contents.erase(38);
+  ASSERT_TRUE(bufferPool.getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(stats.m_numReservedPages == contents.rbegin()->first + 1);
+  ASSERT_TRUE(stats.m_numReservedPages == contents.size() + 1);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+
+  // The storage grows again from the truncated end
+  ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_pId == contents.size() + 1);
+  ASSERT_TRUE(bufferPool.release(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  for (auto& page : contents) {
+    ASSERT_TRUE(bufferPool.pin(page.first, &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == page.second && bufferHandler.m_buffer[64*1024-1] == page.second);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+
+  // With every page released, the allocation table is kept
+  for (auto& page : contents) {
+    ASSERT_TRUE(bufferPool.release(page.first) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.compact(&relocations) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(relocations.empty());
+  ASSERT_TRUE(bufferPool.getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(stats.m_numReservedPages == 1);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(bufferPool.open(bpConfig, "./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferHandler.m_pId == 1);
+  ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that releasing a page waits for the write-back of its eviction by an
+ * asynchronous pin of another task, so that the write-back does not land
+ * after the page has been released and the storage compacted
+ */
+TEST(BufferPoolTest, BufferPoolReleaseAsyncEviction) {
+  startThreadPool(1);
+  BufferPool bufferPool;
+  BufferPoolConfig bpConfig;
+  bpConfig.m_poolSizeKB = 64*4;
+  bpConfig.m_prefetchingDegree = 0;
+  bpConfig.m_numberOfPartitions = 1;
+  bpConfig.m_ioQueueDepth = 32;
+  bpConfig.m_punchHoles = true;
+  bpConfig.m_deviceProfile = DeviceProfile::hdd();
+  BufferHandler bufferHandler;
+  ASSERT_TRUE(bufferPool.create(bpConfig, "./test.db", FileStorageConfig{64}, true) == ErrorCode::E_NO_ERROR);
+  std::vector<pageId_t> pages;
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(bufferPool.alloc(&bufferHandler) == ErrorCode::E_NO_ERROR);
+    memset(bufferHandler.m_buffer, 'A'+bufferHandler.m_pId, 64*1024);
+    ASSERT_TRUE(bufferPool.setPageDirty(bufferHandler.m_pId) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+    pages.push_back(bufferHandler.m_pId);
+  }
+
+  // The pinning task evicts one of the last pages, and starts a task that
+  // releases all of them while the write-back is in flight
+  struct Params {
+    BufferPool*             m_bp;
+    const pageId_t*         m_pages;
+    SyncCounter*            m_counter;
+    Task                    m_releaseTask;
+    uint64_t                m_pendingBefore;
+    uint64_t                m_pendingAfter;
+    bool                    m_failed;
+  };
+  SyncCounter counter;
+  Params params{&bufferPool, pages.data(), &counter, Task{}, 0, 0, false};
+  params.m_releaseTask = Task {
+    [] (void* args) {
+      Params* params = reinterpret_cast<Params*>(args);
+      BufferPoolStatistics stats;
+      params->m_bp->getStatistics(&stats);
+      params->m_pendingBefore = stats.m_numPendingWriteBacks;
+      for (uint32_t i = 4; i < 8; ++i) {
+        if (params->m_bp->release(params->m_pages[i]) != ErrorCode::E_NO_ERROR) {
+          params->m_failed = true;
+        }
+      }
+      params->m_bp->getStatistics(&stats);
+      params->m_pendingAfter = stats.m_numPendingWriteBacks;
+    },
+    &params
+  };
+  Task evictingTask {
+    [] (void* args) {
+      Params* params = reinterpret_cast<Params*>(args);
+      executeTaskAsync(0, params->m_releaseTask, params->m_counter);
+      BufferHandler handler;
+      if (params->m_bp->pinAsync(params->m_pages[0], &handler) != ErrorCode::E_NO_ERROR) {
+        params->m_failed = true;
+        return;
+      }
+      params->m_bp->unpin(handler);
+    },
+    &params
+  };
+  executeTaskAsync(0, evictingTask, &counter);
+  counter.join();
+  ASSERT_FALSE(params.m_failed);
+  ASSERT_TRUE(params.m_pendingBefore == 1);
+  ASSERT_TRUE(params.m_pendingAfter == 0);
+  stopThreadPool();
+
+  // The released pages are truncated, and the others keep their contents
+  std::vector<std::pair<pageId_t, pageId_t>> relocations;
+  ASSERT_TRUE(bufferPool.compact(&relocations) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(relocations.empty());
+  BufferPoolStatistics stats;
+  ASSERT_TRUE(bufferPool.getStatistics(&stats) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(stats.m_numReservedPages == pages[4]);
+  for (uint32_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(bufferPool.pin(pages[i], &bufferHandler) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(bufferHandler.m_buffer[0] == 'A'+pages[i] && bufferHandler.m_buffer[64*1024-1] == 'A'+pages[i]);
+    ASSERT_TRUE(bufferPool.unpin(bufferHandler) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(bufferPool.checkConsistency() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
+}
+
 /**
  * Used by BufferPoolThreadSafe.
  */
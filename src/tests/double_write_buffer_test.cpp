@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <storage/double_write_buffer.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+#define DWB_TEST_PAGE_SIZE 4096
+
+/**
+ * Collects the pages restored when a staging file is opened
+ */
+struct Restored {
+  std::vector<pageId_t>     m_pageIds;
+  std::vector<std::string>  m_data;
+
+  DoubleWriteBuffer::RestoreFunction restore() {
+    return [this] (const pageId_t& pageId, const char* data) {
+      m_pageIds.push_back(pageId);
+      m_data.push_back(std::string(data, DWB_TEST_PAGE_SIZE));
+      return ErrorCode::E_NO_ERROR;
+    };
+  }
+};
+
+/**
+ * Stages a batch of three pages filled with 'a', 'b' and 'c'
+ */
+static void stageBatch( DoubleWriteBuffer* dwb ) {
+  std::string pages[3] = { std::string(DWB_TEST_PAGE_SIZE, 'a'),
+                           std::string(DWB_TEST_PAGE_SIZE, 'b'),
+                           std::string(DWB_TEST_PAGE_SIZE, 'c') };
+  pageId_t pageIds[3] = {7, 2, 9};
+  const char* data[3] = {pages[0].data(), pages[1].data(), pages[2].data()};
+  ASSERT_TRUE(dwb->stage(pageIds, data, 3) == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that a staged batch is restored when the file is opened, until it is
+ * cleared
+ */
+TEST(DoubleWriteBufferTest, DoubleWriteBufferRestore) {
+  DoubleWriteBuffer dwb;
+  ASSERT_TRUE(dwb.create("./test.dwb", DWB_TEST_PAGE_SIZE, true) == ErrorCode::E_NO_ERROR);
+  stageBatch(&dwb);
+  ASSERT_TRUE(dwb.close() == ErrorCode::E_NO_ERROR);
+
+  // Creating it again would lose the staged batch
+  ASSERT_TRUE(dwb.create("./test.dwb", DWB_TEST_PAGE_SIZE) == ErrorCode::E_STORAGE_PATH_ALREADY_EXISTS);
+
+  Restored restored;
+  ASSERT_TRUE(dwb.open("./test.dwb", DWB_TEST_PAGE_SIZE, restored.restore()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dwb.getNumRestored() == 3);
+  ASSERT_TRUE(restored.m_pageIds.size() == 3);
+  ASSERT_TRUE(restored.m_pageIds[0] == 7 && restored.m_data[0] == std::string(DWB_TEST_PAGE_SIZE, 'a'));
+  ASSERT_TRUE(restored.m_pageIds[1] == 2 && restored.m_data[1] == std::string(DWB_TEST_PAGE_SIZE, 'b'));
+  ASSERT_TRUE(restored.m_pageIds[2] == 9 && restored.m_data[2] == std::string(DWB_TEST_PAGE_SIZE, 'c'));
+  ASSERT_TRUE(dwb.clear() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dwb.close() == ErrorCode::E_NO_ERROR);
+
+  Restored again;
+  ASSERT_TRUE(dwb.open("./test.dwb", DWB_TEST_PAGE_SIZE, again.restore()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dwb.getNumRestored() == 0 && again.m_pageIds.empty());
+  ASSERT_TRUE(dwb.close() == ErrorCode::E_NO_ERROR);
+
+  // Files of another page size are rejected
+  ASSERT_TRUE(dwb.open("./test.dwb", 2*DWB_TEST_PAGE_SIZE, again.restore()) == ErrorCode::E_STORAGE_INVALID_DOUBLE_WRITE_BUFFER);
+  std::remove("./test.dwb");
+}
+
+/**
+ * Tests that a batch torn while it was staged is discarded as a whole
+ */
+TEST(DoubleWriteBufferTest, DoubleWriteBufferTornBatch) {
+  DoubleWriteBuffer dwb;
+  ASSERT_TRUE(dwb.create("./test.dwb", DWB_TEST_PAGE_SIZE, true) == ErrorCode::E_NO_ERROR);
+  stageBatch(&dwb);
+  ASSERT_TRUE(dwb.close() == ErrorCode::E_NO_ERROR);
+
+  // A page only partially written
+  {
+    std::fstream file("./test.dwb", std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    file.seekp(-DWB_TEST_PAGE_SIZE/2, std::ios_base::end);
+    file.write(std::string(16, 'x').data(), 16);
+  }
+  Restored restored;
+  ASSERT_TRUE(dwb.open("./test.dwb", DWB_TEST_PAGE_SIZE, restored.restore()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dwb.getNumRestored() == 0 && restored.m_pageIds.empty());
+  stageBatch(&dwb);
+  ASSERT_TRUE(dwb.close() == ErrorCode::E_NO_ERROR);
+
+  // A batch cut short
+  ASSERT_TRUE(truncate("./test.dwb", std::ifstream("./test.dwb", std::ios_base::ate).tellg() - static_cast<std::streamoff>(100)) == 0);
+  ASSERT_TRUE(dwb.open("./test.dwb", DWB_TEST_PAGE_SIZE, restored.restore()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(dwb.getNumRestored() == 0 && restored.m_pageIds.empty());
+  ASSERT_TRUE(dwb.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.dwb");
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
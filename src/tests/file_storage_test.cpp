@@ -1,8 +1,13 @@
 
 
 #include <gtest/gtest.h>
+#include <storage/checksum.h>
 #include <storage/file_storage.h>
 #include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <sys/stat.h>
 
 SMILE_NS_BEGIN
 
@@ -75,6 +80,565 @@ TEST(FileStorageTest, FileStorageReadWrite) {
   ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
 }
 
+/**
+ * Tests Read and Write operations on a storage opened with direct I/O, both
+ * from buffers aligned to the I/O alignment and from unaligned ones, and
+ * checks that the direct I/O setting is persisted.
+ **/
+TEST(FileStorageTest, FileStorageDirectIO) {
+  FileStorage fileStorage;
+  FileStorageConfig config;
+  config.m_pageSizeKB = 64;
+  config.m_directIO = true;
+  ASSERT_TRUE(fileStorage.create("./test.db", config, true) == ErrorCode::E_NO_ERROR);
+  size_t alignment = fileStorage.getIOAlignment();
+  size_t pageSize = fileStorage.getPageSize();
+  ASSERT_TRUE(alignment > 1 && pageSize % alignment == 0);
+
+  std::vector<char> data(pageSize + alignment);
+  char* aligned = data.data() + (alignment - reinterpret_cast<uintptr_t>(data.data()) % alignment);
+  char* unaligned = aligned + 1;
+  pageId_t pid;
+  ASSERT_TRUE(fileStorage.reserve(8,&pid) == ErrorCode::E_NO_ERROR);
+  for( auto i = pid; i < (pid+8); ++i ) {
+    char* buffer = (i % 2 == 0) ? aligned : unaligned;
+    std::fill(buffer, buffer+pageSize, static_cast<char>('a'+i));
+    ASSERT_TRUE(fileStorage.write(buffer,i) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(fileStorage.open("./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.config().m_directIO);
+  for( auto i = pid; i < (pid+8); ++i ) {
+    char* buffer = (i % 2 == 0) ? unaligned : aligned;
+    ASSERT_TRUE(fileStorage.read(buffer,i) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(std::all_of(buffer, buffer+pageSize, [i] (char c) { return c == static_cast<char>('a'+i); }));
+  }
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+
+  // Pages smaller than the I/O alignment cannot be transferred directly
+  config.m_pageSizeKB = 1;
+  ASSERT_TRUE(fileStorage.create("./test.db", config, true) == ErrorCode::E_STORAGE_INVALID_CONFIG);
+}
+
+/**
+ * Reaps the requests left in flight and closes an engine once out of scope,
+ * so that a failed assertion does not close it with requests in flight
+ */
+struct IOEngineGuard {
+  IOEngine* p_engine;
+
+  ~IOEngineGuard() {
+    if (p_engine->isOpened()) {
+      IOCompletion completion;
+      while (p_engine->inFlight() > 0) {
+        p_engine->reap(&completion, 1, 1);
+      }
+      p_engine->close();
+    }
+  }
+};
+
+/**
+ * Tests that pages written and read through the I/O engine match, both with
+ * io_uring (when available) and with the synchronous fallback, and that a
+ * failed linked request cancels the next one.
+ */
+TEST(FileStorageTest, FileStorageAsyncIO) {
+  for (bool synchronous : {false, true}) {
+    FileStorage fileStorage;
+    ASSERT_TRUE(fileStorage.create("./test.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+    size_t pageSize = fileStorage.config().m_pageSizeKB*1024;
+    pageId_t pid;
+    ASSERT_TRUE(fileStorage.reserve(8,&pid) == ErrorCode::E_NO_ERROR);
+
+    IOEngine engine;
+    IOEngineGuard engineGuard{&engine};
+    ASSERT_TRUE(engine.open(4, synchronous) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(synchronous ? !engine.isAsync() : true);
+    std::vector<char> pages(8*pageSize);
+    std::vector<IOCompletion> completions(4);
+    for (uint32_t i = 0; i < 8; ++i) {
+      std::fill(pages.begin()+i*pageSize, pages.begin()+(i+1)*pageSize, static_cast<char>('a'+i));
+    }
+
+    // Writes with up to four of them in flight
+    for (uint32_t i = 0; i < 8; ++i) {
+      if (engine.inFlight() == engine.queueDepth()) {
+        ASSERT_TRUE(engine.reap(completions.data(), completions.size(), 1) >= 1);
+      }
+      ASSERT_TRUE(fileStorage.writeAsync(&engine, &pages[i*pageSize], pid+i, i) == ErrorCode::E_NO_ERROR);
+    }
+
+    // Reaps may have returned several completions, so the queue is filled
+    // again before a request is rejected
+    while (engine.inFlight() < engine.queueDepth()) {
+      ASSERT_TRUE(fileStorage.writeAsync(&engine, &pages[7*pageSize], pid+7, 7) == ErrorCode::E_NO_ERROR);
+    }
+    ASSERT_TRUE(fileStorage.writeAsync(&engine, &pages[0], pid, 0) == ErrorCode::E_STORAGE_IO_QUEUE_FULL);
+    while (engine.inFlight() > 0) {
+      uint32_t reaped = engine.reap(completions.data(), completions.size(), 1);
+      for (uint32_t c = 0; c < reaped; ++c) {
+        ASSERT_TRUE(completions[c].m_result == static_cast<int64_t>(pageSize));
+      }
+    }
+
+    std::vector<char> buffer(4*pageSize);
+    for (uint32_t i = 0; i < 4; ++i) {
+      ASSERT_TRUE(fileStorage.readAsync(&engine, &buffer[i*pageSize], pid+7-i, i) == ErrorCode::E_NO_ERROR);
+    }
+    ASSERT_TRUE(engine.submit() == ErrorCode::E_NO_ERROR);
+    uint32_t reaped = 0;
+    while (reaped < 4) {
+      reaped += engine.reap(&completions[reaped], completions.size()-reaped, 4-reaped);
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+      char expected = static_cast<char>('a'+7-completions[i].m_tag);
+      ASSERT_TRUE(completions[i].m_result == static_cast<int64_t>(pageSize));
+      ASSERT_TRUE(std::all_of(&buffer[completions[i].m_tag*pageSize], &buffer[(completions[i].m_tag+1)*pageSize], [expected] (char c) { return c == expected; }));
+    }
+
+    // A write to an invalid descriptor fails and cancels the linked read
+    ASSERT_TRUE(engine.prepareWrite(-1, buffer.data(), pageSize, 0, 0, true) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(fileStorage.readAsync(&engine, buffer.data(), pid, 1) == ErrorCode::E_NO_ERROR);
+    reaped = 0;
+    while (reaped < 2) {
+      reaped += engine.reap(&completions[reaped], completions.size()-reaped, 2-reaped);
+    }
+    for (uint32_t i = 0; i < 2; ++i) {
+      ASSERT_TRUE(completions[i].m_result == (completions[i].m_tag == 0 ? -EBADF : -ECANCELED));
+    }
+
+    // A read linked to a delayed write is held back with it, and reported
+    // after it, even when it is delayed less
+    for (uint32_t delayRead : {0, 1}) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      engine.delayNext(start + std::chrono::milliseconds(20));
+      ASSERT_TRUE(fileStorage.writeAsync(&engine, pages.data(), pid, 0, true) == ErrorCode::E_NO_ERROR);
+      if (delayRead) {
+        engine.delayNext(start + std::chrono::milliseconds(5));
+      }
+      ASSERT_TRUE(fileStorage.readAsync(&engine, buffer.data(), pid, 1) == ErrorCode::E_NO_ERROR);
+      reaped = engine.reap(completions.data(), completions.size(), 1);
+      ASSERT_TRUE(std::chrono::steady_clock::now() >= start + std::chrono::milliseconds(20));
+      while (reaped < 2) {
+        reaped += engine.reap(&completions[reaped], completions.size()-reaped, 2-reaped);
+      }
+      ASSERT_TRUE(completions[0].m_tag == 0 && completions[1].m_tag == 1);
+      ASSERT_TRUE(completions[1].m_result == static_cast<int64_t>(pageSize));
+    }
+
+    ASSERT_TRUE(engine.close() == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+  }
+}
+
+/**
+ * Tests that ranges of pages written and read with vectored requests, both
+ * synchronously and through the I/O engine, land in the right pages and
+ * buffers
+ */
+TEST(FileStorageTest, FileStorageRange) {
+  FileStorage fileStorage;
+  ASSERT_TRUE(fileStorage.create("./test.db", FileStorageConfig{4}, true) == ErrorCode::E_NO_ERROR);
+  size_t pageSize = fileStorage.config().m_pageSizeKB*1024;
+  pageId_t pid;
+  ASSERT_TRUE(fileStorage.reserve(16,&pid) == ErrorCode::E_NO_ERROR);
+
+  // Buffers are scattered in reverse order to check each page goes to its own
+  std::vector<char> pages(8*pageSize);
+  std::vector<char*> buffers(8);
+  for (uint32_t i = 0; i < 8; ++i) {
+    buffers[i] = &pages[(7-i)*pageSize];
+    std::fill(buffers[i], buffers[i]+pageSize, static_cast<char>('a'+i));
+  }
+  ASSERT_TRUE(fileStorage.writeRange(pid+1, 8, buffers.data()) == ErrorCode::E_NO_ERROR);
+
+  std::vector<char> buffer(pageSize);
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(fileStorage.read(buffer.data(), pid+1+i) == ErrorCode::E_NO_ERROR);
+    ASSERT_TRUE(std::all_of(buffer.begin(), buffer.end(), [i] (char c) { return c == static_cast<char>('a'+i); }));
+  }
+
+  std::fill(pages.begin(), pages.end(), 0);
+  ASSERT_TRUE(fileStorage.readRange(pid+1, 8, buffers.data()) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(std::all_of(buffers[i], buffers[i]+pageSize, [i] (char c) { return c == static_cast<char>('a'+i); }));
+  }
+
+  IOEngine engine;
+  ASSERT_TRUE(engine.open(2) == ErrorCode::E_NO_ERROR);
+  std::vector<struct iovec> iov(8);
+  for (uint32_t i = 0; i < 8; ++i) {
+    iov[i].iov_base = buffers[i];
+    iov[i].iov_len = pageSize;
+  }
+  ASSERT_TRUE(fileStorage.writeRangeAsync(&engine, iov.data(), pid+8, 8, 0) == ErrorCode::E_NO_ERROR);
+  IOCompletion completion;
+  ASSERT_TRUE(engine.reap(&completion, 1, 1) == 1);
+  ASSERT_TRUE(completion.m_result == static_cast<int64_t>(8*pageSize));
+
+  std::fill(pages.begin(), pages.end(), 0);
+  ASSERT_TRUE(fileStorage.readRangeAsync(&engine, iov.data(), pid+8, 8, 1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(engine.reap(&completion, 1, 1) == 1);
+  ASSERT_TRUE(completion.m_tag == 1 && completion.m_result == static_cast<int64_t>(8*pageSize));
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(std::all_of(buffers[i], buffers[i]+pageSize, [i] (char c) { return c == static_cast<char>('a'+i); }));
+  }
+
+  ASSERT_TRUE(engine.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that the hardware and the portable CRC32C agree, and that pages
+ * corrupted behind the storage are detected when read
+ */
+TEST(FileStorageTest, FileStorageChecksums) {
+  const char* vector = "123456789";
+  ASSERT_TRUE(computeCRC32C(vector, 9) == 0xe3069283);
+  ASSERT_TRUE(computeCRC32CPortable(vector, 9) == 0xe3069283);
+  std::vector<char> random(64*1024+13);
+  for (size_t i = 0; i < random.size(); ++i) {
+    random[i] = static_cast<char>(i*2654435761u >> 13);
+  }
+  for (size_t size : {0, 7, 64, 1000, 4096, 64*1024+13}) {
+    ASSERT_TRUE(computeCRC32C(random.data(), size) == computeCRC32CPortable(random.data(), size));
+    ASSERT_TRUE(computeCRC32C(random.data()+size/2, size-size/2, computeCRC32C(random.data(), size/2)) == 
+                computeCRC32C(random.data(), size));
+  }
+
+  FileStorage fileStorage;
+  FileStorageConfig config;
+  config.m_pageSizeKB = 4;
+  config.m_checksums = true;
+  ASSERT_TRUE(fileStorage.create("./test.db", config, true) == ErrorCode::E_NO_ERROR);
+  size_t pageSize = fileStorage.getPageSize();
+  pageId_t pid;
+  ASSERT_TRUE(fileStorage.reserve(8,&pid) == ErrorCode::E_NO_ERROR);
+  std::vector<char> pages(4*pageSize);
+  std::vector<char*> buffers(4);
+  for (uint32_t i = 0; i < 4; ++i) {
+    buffers[i] = &pages[i*pageSize];
+    std::fill(buffers[i], buffers[i]+pageSize, static_cast<char>('a'+i));
+  }
+  ASSERT_TRUE(fileStorage.write(buffers[0], pid) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.writeRange(pid+1, 3, buffers.data()+1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+
+  // Flip a byte of the third page behind the storage
+  std::fstream file("./test.db", std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+  file.seekp((pid+2)*pageSize + 100);
+  file.put('z');
+  file.close();
+
+  ASSERT_TRUE(fileStorage.open("./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.config().m_checksums);
+  std::vector<char> buffer(pageSize);
+  ASSERT_TRUE(fileStorage.read(buffer.data(), pid+1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.read(buffer.data(), pid+2) == ErrorCode::E_STORAGE_CHECKSUM_MISMATCH);
+  ASSERT_TRUE(fileStorage.read(buffer.data(), pid+2, false) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.verify(buffer.data(), pid+2) == ErrorCode::E_STORAGE_CHECKSUM_MISMATCH);
+  ASSERT_TRUE(fileStorage.readRange(pid, 4, buffers.data()) == ErrorCode::E_STORAGE_CHECKSUM_MISMATCH);
+
+  // Reserved pages that were never written verify as zeros
+  ASSERT_TRUE(fileStorage.read(buffer.data(), pid+7) == ErrorCode::E_NO_ERROR);
+
+  // Rewriting the page fixes its checksum
+  std::fill(buffer.begin(), buffer.end(), 'c');
+  ASSERT_TRUE(fileStorage.write(buffer.data(), pid+2) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.readRange(pid, 4, buffers.data()) == ErrorCode::E_NO_ERROR);
+
+  // The checksum file gets the checksum of a page with its write, so that
+  // it survives a crash of the process
+  auto storedChecksum = [] (pageId_t page) {
+    std::ifstream crcFile("./test.db.crc", std::ios_base::binary);
+    crcFile.seekg(page*sizeof(uint32_t));
+    uint32_t checksum = 0;
+    crcFile.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
+    return checksum;
+  };
+  std::fill(buffer.begin(), buffer.end(), 'x');
+  ASSERT_TRUE(fileStorage.write(buffer.data(), pid+2) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(storedChecksum(pid+2) == computeCRC32C(buffer.data(), pageSize));
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.crc");
+}
+
+/**
+ * Tests that pages striped across several files keep a single address
+ * space, with ranges crossing stripe boundaries and a mapping of all of them
+ */
+TEST(FileStorageTest, FileStorageStriping) {
+  FileStorage fileStorage;
+  FileStorageConfig config;
+  config.m_pageSizeKB = 4;
+  config.m_numStripes = 3;
+  config.m_stripePages = 4;
+  ASSERT_TRUE(fileStorage.create("./test.db", config, true, {"./test.db.first"}) == ErrorCode::E_NO_ERROR);
+  size_t pageSize = fileStorage.getPageSize();
+  pageId_t pid;
+  ASSERT_TRUE(fileStorage.reserve(30, &pid) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(pid == 0 && fileStorage.size() == 30);
+  ASSERT_TRUE(fileStorage.getContiguousPages(5) == 3);
+
+  // Each stripe holds whole stripes of 4 pages, and the last one is partial
+  std::vector<char> pages(30*pageSize);
+  std::vector<char*> buffers(30);
+  for (uint32_t i = 0; i < 30; ++i) {
+    buffers[i] = &pages[i*pageSize];
+    std::fill(buffers[i], buffers[i]+pageSize, static_cast<char>('A'+i));
+  }
+  ASSERT_TRUE(fileStorage.writeRange(0, 29, buffers.data()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.write(buffers[29], 29) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(std::ifstream("./test.db", std::ios_base::ate).tellg() == static_cast<int64_t>(12*pageSize));
+  ASSERT_TRUE(std::ifstream("./test.db.first", std::ios_base::ate).tellg() == static_cast<int64_t>(10*pageSize));
+  ASSERT_TRUE(std::ifstream("./test.db.2", std::ios_base::ate).tellg() == static_cast<int64_t>(8*pageSize));
+
+  ASSERT_TRUE(fileStorage.open("./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.config().m_numStripes == 3 && fileStorage.size() == 30);
+  std::vector<char> buffer(pageSize);
+  ASSERT_TRUE(fileStorage.read(buffer.data(), 13) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(buffer[0] == 'A'+13 && buffer[pageSize-1] == 'A'+13);
+  std::fill(pages.begin(), pages.end(), 0);
+  ASSERT_TRUE(fileStorage.readRange(3, 20, buffers.data()) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < 20; ++i) {
+    ASSERT_TRUE(std::all_of(buffers[i], buffers[i]+pageSize, [i] (char c) { return c == static_cast<char>('A'+3+i); }));
+  }
+
+  IOEngine engine;
+  ASSERT_TRUE(engine.open(2) == ErrorCode::E_NO_ERROR);
+  std::vector<struct iovec> iov(3);
+  for (uint32_t i = 0; i < 3; ++i) {
+    iov[i].iov_base = buffers[i];
+    iov[i].iov_len = pageSize;
+  }
+  ASSERT_TRUE(fileStorage.readRangeAsync(&engine, iov.data(), 9, 3, 0) == ErrorCode::E_NO_ERROR);
+  IOCompletion completion;
+  ASSERT_TRUE(engine.reap(&completion, 1, 1) == 1);
+  ASSERT_TRUE(completion.m_result == static_cast<int64_t>(3*pageSize));
+  ASSERT_TRUE(buffers[0][0] == 'A'+9 && buffers[2][0] == 'A'+11);
+  ASSERT_TRUE(engine.close() == ErrorCode::E_NO_ERROR);
+
+  const char* mapping;
+  ASSERT_TRUE(fileStorage.map(&mapping) == ErrorCode::E_NO_ERROR);
+  for (uint32_t i = 0; i < 30; ++i) {
+    ASSERT_TRUE(mapping[i*pageSize] == 'A'+i && mapping[(i+1)*pageSize-1] == 'A'+i);
+  }
+  ASSERT_TRUE(fileStorage.unmap() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+
+  config.m_stripePages = 0;
+  ASSERT_TRUE(fileStorage.create("./test.db", config, true) == ErrorCode::E_STORAGE_INVALID_CONFIG);
+  std::remove("./test.db.first");
+  std::remove("./test.db.2");
+}
+
+/**
+ * Tests that in-memory storages leave no files behind, and that a device
+ * profile delays both synchronous and asynchronous requests
+ */
+TEST(FileStorageTest, FileStorageInMemory) {
+  FileStorage fileStorage;
+  FileStorageConfig config;
+  config.m_pageSizeKB = 4;
+  config.m_inMemory = true;
+  config.m_checksums = true;
+  ASSERT_TRUE(fileStorage.create("./inmemory.db", config) == ErrorCode::E_NO_ERROR);
+  ASSERT_FALSE(std::ifstream("./inmemory.db") || std::ifstream("./inmemory.db.config"));
+  size_t pageSize = fileStorage.getPageSize();
+  pageId_t pid;
+  ASSERT_TRUE(fileStorage.reserve(8, &pid) == ErrorCode::E_NO_ERROR);
+  std::vector<char> buffer(pageSize, 'a');
+  ASSERT_TRUE(fileStorage.write(buffer.data(), pid+1) == ErrorCode::E_NO_ERROR);
+  std::fill(buffer.begin(), buffer.end(), 0);
+  ASSERT_TRUE(fileStorage.read(buffer.data(), pid+1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(buffer[0] == 'a' && buffer[pageSize-1] == 'a');
+
+  // 2ms of latency per request, except for those that continue right where
+  // the previous one ended
+  fileStorage.setDeviceProfile(DeviceProfile{2000, 1000, false});
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(fileStorage.read(buffer.data(), pid+1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(2));
+
+  IOEngine engine;
+  ASSERT_TRUE(engine.open(2) == ErrorCode::E_NO_ERROR);
+  start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(fileStorage.readAsync(&engine, buffer.data(), pid+5, 0) == ErrorCode::E_NO_ERROR);
+  IOCompletion completion;
+  ASSERT_TRUE(engine.reap(&completion, 1, 1) == 1);
+  ASSERT_TRUE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(2));
+  ASSERT_TRUE(completion.m_result == static_cast<int64_t>(pageSize));
+  ASSERT_TRUE(engine.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(fileStorage.open("./inmemory.db") != ErrorCode::E_NO_ERROR);
+  config.m_directIO = true;
+  ASSERT_TRUE(fileStorage.create("./inmemory.db", config) == ErrorCode::E_STORAGE_INVALID_CONFIG);
+}
+
+/**
+ * Tests that the I/O statistics count the transfers of every thread, time
+ * the synchronous ones and are cleared when the storage is opened again
+ */
+TEST(FileStorageTest, FileStorageIOStatistics) {
+  FileStorage fileStorage;
+  FileStorageConfig config;
+  config.m_pageSizeKB = 4;
+  config.m_numStripes = 2;
+  config.m_stripePages = 4;
+  ASSERT_TRUE(fileStorage.create("./test.db", config, true) == ErrorCode::E_NO_ERROR);
+  size_t pageSize = fileStorage.getPageSize();
+  pageId_t pid;
+  ASSERT_TRUE(fileStorage.reserve(16, &pid) == ErrorCode::E_NO_ERROR);
+
+  std::vector<char> pages(8*pageSize, 'a');
+  std::vector<char*> buffers(8);
+  for (uint32_t i = 0; i < 8; ++i) {
+    buffers[i] = &pages[i*pageSize];
+  }
+  ASSERT_TRUE(fileStorage.write(buffers[0], pid) == ErrorCode::E_NO_ERROR);
+  // Split in two calls at the stripe boundary
+  ASSERT_TRUE(fileStorage.writeRange(pid+2, 4, buffers.data()) == ErrorCode::E_NO_ERROR);
+  std::thread reader([&] () {
+    std::vector<char> buffer(pageSize);
+    for (uint32_t i = 0; i < 10; ++i) {
+      fileStorage.read(buffer.data(), pid+i);
+    }
+  });
+  reader.join();
+
+  IOEngine engine;
+  ASSERT_TRUE(engine.open(2) == ErrorCode::E_NO_ERROR);
+  std::vector<struct iovec> iov(2);
+  for (uint32_t i = 0; i < 2; ++i) {
+    iov[i].iov_base = buffers[i];
+    iov[i].iov_len = pageSize;
+  }
+  ASSERT_TRUE(fileStorage.readRangeAsync(&engine, iov.data(), pid+8, 2, 0) == ErrorCode::E_NO_ERROR);
+  IOCompletion completion;
+  ASSERT_TRUE(engine.reap(&completion, 1, 1) == 1);
+  ASSERT_TRUE(engine.close() == ErrorCode::E_NO_ERROR);
+
+  IOStatistics stats;
+  fileStorage.getIOStatistics(&stats);
+  ASSERT_TRUE(stats.m_pagesWritten == 5 && stats.m_bytesWritten == 5*pageSize && stats.m_writeCalls == 3);
+  ASSERT_TRUE(stats.m_pagesRead == 12 && stats.m_bytesRead == 12*pageSize && stats.m_readCalls == 11);
+  ASSERT_TRUE(stats.m_reserveCalls == 1);
+  ASSERT_TRUE(std::accumulate(stats.m_readLatency, stats.m_readLatency+IO_LATENCY_BUCKETS, 0ULL) == 10);
+  ASSERT_TRUE(std::accumulate(stats.m_writeLatency, stats.m_writeLatency+IO_LATENCY_BUCKETS, 0ULL) == 3);
+  ASSERT_TRUE(std::accumulate(stats.m_reserveLatency, stats.m_reserveLatency+IO_LATENCY_BUCKETS, 0ULL) == 1);
+  ASSERT_TRUE(IOStatistics::getLatencyPercentile(stats.m_readLatency, 50) > 0);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(fileStorage.open("./test.db") == ErrorCode::E_NO_ERROR);
+  fileStorage.getIOStatistics(&stats);
+  ASSERT_TRUE(stats.m_pagesRead == 0 && stats.m_pagesWritten == 0 && stats.m_readLatency[0] == 0);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.1");
+
+  uint64_t histogram[IO_LATENCY_BUCKETS] = {};
+  ASSERT_TRUE(IOStatistics::getLatencyPercentile(histogram, 99) == 0);
+  histogram[10] = 99;
+  histogram[20] = 1;
+  ASSERT_TRUE(IOStatistics::getLatencyPercentile(histogram, 50) == 1 << 11);
+  ASSERT_TRUE(IOStatistics::getLatencyPercentile(histogram, 100) == 1 << 21);
+}
+
+/**
+ * Tests that pages pushed to the device by the background write-back, over
+ * several stripes and calls, are read back unchanged
+ */
+TEST(FileStorageTest, FileStorageWriteBack) {
+  FileStorage fileStorage;
+  FileStorageConfig config;
+  config.m_pageSizeKB = 4;
+  config.m_numStripes = 2;
+  config.m_stripePages = 4;
+  ASSERT_TRUE(fileStorage.create("./test.db", config, true) == ErrorCode::E_NO_ERROR);
+  size_t pageSize = fileStorage.getPageSize();
+  pageId_t pid;
+  ASSERT_TRUE(fileStorage.reserve(16, &pid) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.writeBack() == ErrorCode::E_NO_ERROR);
+
+  std::vector<char> pages(16*pageSize);
+  std::vector<char*> buffers(16);
+  for (uint32_t i = 0; i < 16; ++i) {
+    buffers[i] = &pages[i*pageSize];
+    memset(buffers[i], 'a'+i, pageSize);
+  }
+  ASSERT_TRUE(fileStorage.writeRange(pid, 6, buffers.data()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.writeBack() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.write(buffers[13], pid+13) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.writeBack() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.writeBack() == ErrorCode::E_NO_ERROR);
+
+  std::vector<char> buffer(pageSize);
+  for (uint32_t i = 0; i < 16; ++i) {
+    if (i < 6 || i == 13) {
+      ASSERT_TRUE(fileStorage.read(buffer.data(), pid+i) == ErrorCode::E_NO_ERROR);
+      ASSERT_TRUE(buffer[0] == 'a'+i && buffer[pageSize-1] == 'a'+i);
+    }
+  }
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.1");
+}
+
+/**
+ * Tests that discarded pages read back as new pages, with valid checksums,
+ * and give their space back, and that truncating the storage shrinks it
+ */
+TEST(FileStorageTest, FileStorageDiscard) {
+  FileStorage fileStorage;
+  FileStorageConfig config;
+  config.m_pageSizeKB = 4;
+  config.m_checksums = true;
+  config.m_numStripes = 2;
+  config.m_stripePages = 4;
+  ASSERT_TRUE(fileStorage.create("./test.db", config, true) == ErrorCode::E_NO_ERROR);
+  size_t pageSize = fileStorage.getPageSize();
+  pageId_t pid;
+  ASSERT_TRUE(fileStorage.reserve(16, &pid) == ErrorCode::E_NO_ERROR);
+  std::vector<char> buffer(pageSize);
+  for (uint32_t i = 0; i < 16; ++i) {
+    memset(buffer.data(), 'a'+i, pageSize);
+    ASSERT_TRUE(fileStorage.write(buffer.data(), pid+i) == ErrorCode::E_NO_ERROR);
+  }
+  ASSERT_TRUE(fileStorage.sync() == ErrorCode::E_NO_ERROR);
+  struct stat before;
+  ASSERT_TRUE(stat("./test.db", &before) == 0);
+
+  // Pages 2 to 11 span both stripes
+  ASSERT_TRUE(fileStorage.discard(pid+2, 10) == ErrorCode::E_NO_ERROR);
+  struct stat after;
+  ASSERT_TRUE(stat("./test.db", &after) == 0);
+  ASSERT_TRUE(after.st_blocks < before.st_blocks);
+  ASSERT_TRUE(after.st_size == before.st_size);
+  ASSERT_TRUE(fileStorage.size() == 16);
+  for (uint32_t i = 0; i < 16; ++i) {
+    ASSERT_TRUE(fileStorage.read(buffer.data(), pid+i) == ErrorCode::E_NO_ERROR);
+    char expected = (i >= 2 && i < 12) ? 0 : 'a'+i;
+    ASSERT_TRUE(buffer[0] == expected && buffer[pageSize-1] == expected);
+  }
+
+  ASSERT_TRUE(fileStorage.truncate(6) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.size() == 6);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+
+  ASSERT_TRUE(fileStorage.open("./test.db") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(fileStorage.size() == 6);
+  ASSERT_TRUE(fileStorage.read(buffer.data(), pid+1) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(buffer[0] == 'a'+1);
+  ASSERT_TRUE(fileStorage.reserve(2, &pid) == ErrorCode::E_NO_ERROR && pid == 6);
+  ASSERT_TRUE(fileStorage.read(buffer.data(), pid) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(buffer[0] == 0);
+  ASSERT_TRUE(fileStorage.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.db.1");
+  std::remove("./test.db.crc");
+}
+
 #if 0
 /**
  * Tests that the file storage is properly reporting errors, specially
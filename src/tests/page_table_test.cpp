@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <memory/page_table.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests that pages are found until they are erased, including those whose
+ * probe sequences were shifted back by the erasure of other pages
+ */
+TEST(PageTableTest, PageTableInsertErase) {
+  PageTable pageTable;
+  pageTable.init(64);
+  bufferId_t bId;
+  ASSERT_FALSE(pageTable.find(3, &bId));
+
+  // Pages strided like those of a partition
+  for (pageId_t pId = 3; pId < 64*16; pId += 16) {
+    pageTable.insert(pId, pId/16);
+  }
+  ASSERT_TRUE(pageTable.size() == 64);
+  for (pageId_t pId = 3; pId < 64*16; pId += 16) {
+    ASSERT_TRUE(pageTable.find(pId, &bId) && bId == pId/16);
+    ASSERT_FALSE(pageTable.find(pId+1, &bId));
+  }
+
+  for (pageId_t pId = 3; pId < 64*16; pId += 32) {
+    ASSERT_TRUE(pageTable.erase(pId));
+    ASSERT_FALSE(pageTable.erase(pId));
+  }
+  ASSERT_TRUE(pageTable.size() == 32);
+  for (pageId_t pId = 3; pId < 64*16; pId += 16) {
+    ASSERT_TRUE(pageTable.find(pId, &bId) == ((pId - 3) % 32 != 0));
+  }
+
+  // Churn leaves no tombstones behind, so the table never fills up
+  for (pageId_t pId = 64*16; pId < 64*16*100; pId += 16) {
+    pageTable.insert(pId, pId);
+    ASSERT_TRUE(pageTable.find(pId, &bId) && bId == pId);
+    ASSERT_TRUE(pageTable.erase(pId));
+  }
+  ASSERT_TRUE(pageTable.size() == 32);
+}
+
+/**
+ * Tests that lookups running concurrently with updates never return the
+ * buffer of another page
+ */
+TEST(PageTableTest, PageTableConcurrentLookups) {
+  PageTable pageTable;
+  pageTable.init(256);
+
+  // Buffers encode their pages, so that readers can check what they find
+  for (pageId_t pId = 0; pId < 128; ++pId) {
+    pageTable.insert(pId, pId << 8);
+  }
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> mismatches{0};
+  std::atomic<uint64_t> hits{0};
+  std::vector<std::thread> readers;
+  for (uint32_t r = 0; r < 4; ++r) {
+    readers.emplace_back([&] () {
+      do {
+        for (pageId_t pId = 0; pId < 256; ++pId) {
+          bufferId_t bId;
+          if (pageTable.find(pId, &bId)) {
+            ++hits;
+            if (bId >> 8 != pId) {
+              ++mismatches;
+            }
+          }
+        }
+      } while (!done);
+    });
+  }
+
+  // Pages move in and out of the table, shifting the others around
+  for (uint32_t round = 0; round < 2000; ++round) {
+    for (pageId_t pId = round % 2; pId < 256; pId += 2) {
+      bufferId_t bId;
+      if (pageTable.find(pId, &bId)) {
+        pageTable.erase(pId);
+      }
+      else {
+        pageTable.insert(pId, (pId << 8) | (round & 0xff));
+      }
+    }
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_TRUE(mismatches == 0);
+  ASSERT_TRUE(hits > 0);
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
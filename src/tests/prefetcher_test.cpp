@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <memory/prefetcher.h>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+SMILE_NS_BEGIN
+
+/**
+ * Records the pages loaded by a prefetcher
+ */
+struct LoadedPages {
+  std::mutex          m_lock;
+  std::set<pageId_t>  m_pages;
+
+  Prefetcher::LoadFunction function() {
+    return [this] (const pageId_t* pIds, uint32_t numPages) {
+      std::lock_guard<std::mutex> guard(m_lock);
+      for (uint32_t i = 0; i < numPages; ++i) {
+        m_pages.insert(pIds[i]);
+      }
+    };
+  }
+
+  /**
+   * Waits until a number of pages have been loaded, or a second has passed
+   */
+  std::set<pageId_t> wait( size_t numPages ) {
+    for (uint32_t i = 0; i < 1000; ++i) {
+      {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_pages.size() >= numPages) {
+          break;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_pages;
+  }
+};
+
+static bool skipNone( const pageId_t& pId ) {
+  return false;
+}
+
+/**
+ * Tests that the window of a sequential stream starts small and doubles as
+ * the stream reaches the prefetched pages, up to the maximum
+ */
+TEST(PrefetcherTest, PrefetcherSequential) {
+  LoadedPages loaded;
+  Prefetcher prefetcher;
+  prefetcher.start(8, 64, loaded.function());
+
+  // Two accesses set the stride and the third one trains the stream
+  prefetcher.access(10, 1000, skipNone);
+  prefetcher.access(11, 1000, skipNone);
+  ASSERT_TRUE(prefetcher.getNumRequested() == 0);
+  prefetcher.access(12, 1000, skipNone);
+  ASSERT_TRUE(loaded.wait(PREFETCH_INITIAL_WINDOW) == std::set<pageId_t>({13, 14, 15, 16}));
+
+  // Reaching the prefetched pages doubles the window
+  prefetcher.access(13, 1000, skipNone);
+  ASSERT_TRUE(loaded.wait(9) == std::set<pageId_t>({13, 14, 15, 16, 17, 18, 19, 20, 21}));
+  prefetcher.access(14, 1000, skipNone);
+  prefetcher.access(15, 1000, skipNone);
+  prefetcher.access(16, 1000, skipNone);
+  prefetcher.access(17, 1000, skipNone);
+  std::set<pageId_t> pages = loaded.wait(13);
+  ASSERT_TRUE(*pages.rbegin() == 25);
+
+  // Skipped pages, such as a protected one, do not break the stream
+  prefetcher.access(19, 1000, skipNone);
+  pages = loaded.wait(15);
+  ASSERT_TRUE(*pages.rbegin() == 27);
+  ASSERT_TRUE(prefetcher.getNumRequested() == pages.size());
+  prefetcher.stop();
+}
+
+/**
+ * Tests that strided and descending streams are detected, and that pages
+ * that are skipped or beyond the storage are not requested
+ */
+TEST(PrefetcherTest, PrefetcherStrided) {
+  LoadedPages loaded;
+  Prefetcher prefetcher;
+  prefetcher.start(8, 64, loaded.function());
+
+  // Interleaved streams of the same thread are told apart
+  prefetcher.access(100, 1000, skipNone);
+  prefetcher.access(500, 1000, skipNone);
+  prefetcher.access(103, 1000, skipNone);
+  prefetcher.access(498, 1000, skipNone);
+  prefetcher.access(106, 1000, skipNone);
+  prefetcher.access(496, 1000, skipNone);
+  std::set<pageId_t> pages = loaded.wait(8);
+  ASSERT_TRUE(pages == std::set<pageId_t>({109, 112, 115, 118, 494, 492, 490, 488}));
+
+  // Pages already loaded are left out
+  auto skipOdd = [] (const pageId_t& pId) { return pId % 2 == 1; };
+  prefetcher.access(10, 1000, skipOdd);
+  prefetcher.access(11, 1000, skipOdd);
+  prefetcher.access(12, 1000, skipOdd);
+  pages = loaded.wait(10);
+  ASSERT_TRUE(pages.count(14) == 1 && pages.count(16) == 1);
+  ASSERT_TRUE(pages.count(13) == 0 && pages.count(15) == 0);
+
+  // The storage bounds the window
+  prefetcher.access(996, 998, skipNone);
+  prefetcher.access(997, 998, skipNone);
+  prefetcher.access(998, 998, skipNone);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_TRUE(loaded.wait(0).size() == 10);
+  prefetcher.stop();
+}
+
+/**
+ * Tests that random accesses do not prefetch anything, and that each thread
+ * has its own streams
+ */
+TEST(PrefetcherTest, PrefetcherThreads) {
+  LoadedPages loaded;
+  Prefetcher prefetcher;
+  prefetcher.start(8, 64, loaded.function());
+
+  prefetcher.access(700, 1000, skipNone);
+  prefetcher.access(300, 1000, skipNone);
+  prefetcher.access(900, 1000, skipNone);
+  prefetcher.access(100, 1000, skipNone);
+  ASSERT_TRUE(prefetcher.getNumRequested() == 0);
+
+  // Accesses of another thread do not continue the streams of this one
+  prefetcher.access(10, 1000, skipNone);
+  prefetcher.access(11, 1000, skipNone);
+  std::thread other([&prefetcher] () {
+    prefetcher.access(12, 1000, skipNone);
+    prefetcher.access(13, 1000, skipNone);
+  });
+  other.join();
+  ASSERT_TRUE(prefetcher.getNumRequested() == 0);
+  prefetcher.access(12, 1000, skipNone);
+  ASSERT_TRUE(loaded.wait(4) == std::set<pageId_t>({13, 14, 15, 16}));
+  prefetcher.stop();
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -59,6 +59,20 @@ TEST(SchemaTest, SchemaPersistence) {
   ASSERT_TRUE(bufferPool.close() == ErrorCode::E_NO_ERROR);
 }
 
+TEST(SchemaTest, SchemaPageSizeClasses) {
+  Schema schema{nullptr};
+  ASSERT_TRUE(schema.getPageSizeClass(DataStructureType::E_TABLE) == 0);
+  ASSERT_TRUE(schema.getPageSizeClass(DataStructureType::E_INDEX) == 0);
+  ASSERT_TRUE(schema.getPageSizeClass(DataStructureType::E_CSR) == 0);
+
+  schema.setPageSizeClass(DataStructureType::E_INDEX, 1);
+  schema.setPageSizeClass(DataStructureType::E_CSR, 2);
+  ASSERT_TRUE(schema.getPageSizeClass(DataStructureType::E_TABLE) == 0);
+  ASSERT_TRUE(schema.getPageSizeClass(DataStructureType::E_INDEX) == 1);
+  ASSERT_TRUE(schema.getPageSizeClass(DataStructureType::E_CSR) == 2);
+  ASSERT_TRUE(schema.getPageSizeClass(DataStructureType::E_NO_STRUCT) == 0);
+}
+
 SMILE_NS_END
 
 int main(int argc, char* argv[]){
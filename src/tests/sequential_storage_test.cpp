@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <storage/sequential_file_storage.h>
+#include <algorithm>
+#include <thread>
+
+SMILE_NS_BEGIN
+
+/**
+ * Tests that appended and reserved extents are numbered in order, that their
+ * contents are persisted, and that the configuration is kept across
+ * reopenings
+ */
+TEST(SequentialStorageTest, SequentialStorageAppend) {
+  SequentialFileStorage storage;
+  ISequentialStorage::SequentialStorageConfig config;
+  config.m_extentSizeKB = 256;
+  config.m_syncIntervalKB = 512;
+  ASSERT_TRUE(storage.create("./test.seq", config, true) == ErrorCode::E_NO_ERROR);
+  size_t extentSize = storage.getExtentSize();
+
+  std::vector<char> data(4*extentSize);
+  for (uint32_t i = 0; i < 4; ++i) {
+    std::fill(data.begin()+i*extentSize, data.begin()+(i+1)*extentSize, static_cast<char>('a'+i));
+  }
+  extentId_t extent;
+  ASSERT_TRUE(storage.append(data.data(), 4, extent) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(extent == 0);
+  ASSERT_TRUE(storage.reserve(2, extent) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(extent == 4);
+  ASSERT_TRUE(storage.write(data.data(), 5) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(storage.append(&data[extentSize], 1, extent) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(extent == 6);
+  ASSERT_TRUE(storage.size() == 7);
+  ASSERT_TRUE(storage.sync() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(storage.create("./test.seq", config) == ErrorCode::E_STORAGE_PATH_ALREADY_EXISTS);
+
+  ASSERT_TRUE(storage.open("./test.seq") == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(storage.config().m_extentSizeKB == 256);
+  ASSERT_TRUE(storage.size() == 7);
+  std::vector<char> buffer(extentSize);
+  char expected[] = {'a', 'b', 'c', 'd', 0, 'a', 'b'};
+  for (extentId_t i = 0; i < storage.size(); ++i) {
+    ASSERT_TRUE(storage.read(buffer.data(), i) == ErrorCode::E_NO_ERROR);
+    char c = expected[i];
+    ASSERT_TRUE(std::all_of(buffer.begin(), buffer.end(), [c] (char b) { return b == c; }));
+  }
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+}
+
+/**
+ * Tests that concurrent appends get disjoint extents, and that sync waits
+ * for the data written by every thread
+ */
+TEST(SequentialStorageTest, SequentialStorageConcurrentAppend) {
+  SequentialFileStorage storage;
+  ISequentialStorage::SequentialStorageConfig config;
+  config.m_extentSizeKB = 64;
+  config.m_syncIntervalKB = 0;
+  ASSERT_TRUE(storage.create("./test.seq", config, true) == ErrorCode::E_NO_ERROR);
+  size_t extentSize = storage.getExtentSize();
+
+  std::vector<std::thread> threads;
+  std::vector<std::vector<extentId_t>> extents(4);
+  for (uint32_t t = 0; t < 4; ++t) {
+    threads.push_back(std::thread([t, extentSize, &storage, &extents] () {
+      std::vector<char> data(extentSize, static_cast<char>('a'+t));
+      for (uint32_t i = 0; i < 16; ++i) {
+        extentId_t extent;
+        storage.append(data.data(), 1, extent);
+        extents[t].push_back(extent);
+      }
+    }));
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  ASSERT_TRUE(storage.sync() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(storage.size() == 64);
+
+  std::vector<char> buffer(extentSize);
+  for (uint32_t t = 0; t < 4; ++t) {
+    for (extentId_t extent : extents[t]) {
+      ASSERT_TRUE(storage.read(buffer.data(), extent) == ErrorCode::E_NO_ERROR);
+      char c = 'a'+t;
+      ASSERT_TRUE(std::all_of(buffer.begin(), buffer.end(), [c] (char b) { return b == c; }));
+    }
+  }
+  ASSERT_TRUE(storage.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.seq");
+  std::remove("./test.seq.config");
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <storage/write_ahead_log.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+SMILE_NS_BEGIN
+
+/**
+ * Collects the records replayed when a log is opened
+ */
+struct Replayed {
+  std::vector<WALRecord>    m_records;
+  std::vector<std::string>  m_data;
+
+  WriteAheadLog::RedoFunction redo() {
+    return [this] (const WALRecord& record, const char* data) {
+      m_records.push_back(record);
+      m_data.push_back(std::string(data, record.m_size));
+      return ErrorCode::E_NO_ERROR;
+    };
+  }
+};
+
+/**
+ * Tests that flushed records are replayed in order when the log is opened,
+ * and that new records follow them
+ */
+TEST(WriteAheadLogTest, WriteAheadLogReplay) {
+  WriteAheadLog log;
+  ASSERT_TRUE(log.create("./test.wal", true) == ErrorCode::E_NO_ERROR);
+  WriteAheadLog other;
+  ASSERT_TRUE(other.create("./test.wal") == ErrorCode::E_STORAGE_PATH_ALREADY_EXISTS);
+  lsn_t lsn;
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 3, 10, "abc", 3, &lsn) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.getNextLSN() == lsn && log.getDurableLSN() == 0);
+  ASSERT_TRUE(log.flush(lsn) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.getDurableLSN() == lsn);
+  std::string large(3*WAL_BUFFER_KB*1024/2, 'x');
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 4, 0, large.data(), large.size(), &lsn) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_RELEASE, 3, 0, nullptr, 0, &lsn) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+
+  Replayed replayed;
+  ASSERT_TRUE(log.open("./test.wal", replayed.redo()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(replayed.m_records.size() == 3);
+  ASSERT_TRUE(replayed.m_records[0].m_pageId == 3 && replayed.m_records[0].m_offset == 10 && replayed.m_data[0] == "abc");
+  ASSERT_TRUE(replayed.m_records[1].m_pageId == 4 && replayed.m_data[1] == large);
+  ASSERT_TRUE(replayed.m_records[2].m_type == WALRecordType::E_PAGE_RELEASE);
+  ASSERT_TRUE(log.getNextLSN() == lsn && log.getDurableLSN() == lsn);
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 5, 0, "d", 1, &lsn) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+
+  Replayed again;
+  ASSERT_TRUE(log.open("./test.wal", again.redo()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(again.m_records.size() == 4 && again.m_data[3] == "d");
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.wal");
+}
+
+/**
+ * Tests that a record torn by a crash ends the replay, and is overwritten
+ * by the next records
+ */
+TEST(WriteAheadLogTest, WriteAheadLogTornRecord) {
+  WriteAheadLog log;
+  ASSERT_TRUE(log.create("./test.wal", true) == ErrorCode::E_NO_ERROR);
+  lsn_t first, second;
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 1, 0, "first", 5, &first) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 2, 0, "second", 6, &second) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(truncate("./test.wal", std::ifstream("./test.wal", std::ios_base::ate).tellg() - static_cast<std::streamoff>(2)) == 0);
+
+  Replayed replayed;
+  ASSERT_TRUE(log.open("./test.wal", replayed.redo()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(replayed.m_records.size() == 1 && replayed.m_data[0] == "first");
+  ASSERT_TRUE(log.getNextLSN() == first);
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 3, 0, "third", 5, &second) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+
+  Replayed again;
+  ASSERT_TRUE(log.open("./test.wal", again.redo()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(again.m_records.size() == 2 && again.m_data[1] == "third");
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+
+  std::ofstream("./test.wal", std::ios_base::trunc) << "not a log";
+  ASSERT_TRUE(log.open("./test.wal", again.redo()) == ErrorCode::E_STORAGE_INVALID_LOG);
+  std::remove("./test.wal");
+}
+
+/**
+ * Tests that truncated records are not replayed, and that LSNs keep
+ * growing across truncations
+ */
+TEST(WriteAheadLogTest, WriteAheadLogTruncate) {
+  WriteAheadLog log;
+  ASSERT_TRUE(log.create("./test.wal", true) == ErrorCode::E_NO_ERROR);
+  lsn_t first, second;
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 1, 0, "first", 5, &first) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.flush(first) == ErrorCode::E_NO_ERROR);
+
+  // Records appended after the LSN keep the log whole
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 2, 0, "second", 6, &second) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.truncate(first) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.flush(second) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.truncate(second) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+
+  Replayed replayed;
+  ASSERT_TRUE(log.open("./test.wal", replayed.redo()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(replayed.m_records.empty());
+  ASSERT_TRUE(log.getNextLSN() == second);
+  lsn_t third;
+  ASSERT_TRUE(log.append(WALRecordType::E_PAGE_UPDATE, 3, 0, "third", 5, &third) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(third > second);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+
+  Replayed again;
+  ASSERT_TRUE(log.open("./test.wal", again.redo()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(again.m_records.size() == 1 && again.m_records[0].m_lsn == second);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.wal");
+}
+
+/**
+ * Tests that concurrent commits are grouped into fewer syncs than commits
+ */
+TEST(WriteAheadLogTest, WriteAheadLogGroupCommit) {
+  WriteAheadLog log;
+  ASSERT_TRUE(log.create("./test.wal", true) == ErrorCode::E_NO_ERROR);
+  const uint32_t numThreads = 8;
+  const uint32_t numCommits = 32;
+  std::vector<std::thread> threads;
+  std::atomic<uint32_t> failures(0);
+  for (uint32_t t = 0; t < numThreads; ++t) {
+    threads.push_back(std::thread([&log, &failures, t] () {
+      std::string data(128, static_cast<char>('a'+t));
+      for (uint32_t i = 0; i < numCommits; ++i) {
+        lsn_t lsn;
+        if (log.append(WALRecordType::E_PAGE_UPDATE, t, i, data.data(), data.size(), &lsn) != ErrorCode::E_NO_ERROR ||
+            log.flush(lsn) != ErrorCode::E_NO_ERROR ||
+            log.getDurableLSN() < lsn) {
+          ++failures;
+        }
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(failures == 0);
+  ASSERT_TRUE(log.getNumSyncs() < numThreads*numCommits);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+
+  Replayed replayed;
+  ASSERT_TRUE(log.open("./test.wal", replayed.redo()) == ErrorCode::E_NO_ERROR);
+  ASSERT_TRUE(replayed.m_records.size() == numThreads*numCommits);
+  ASSERT_TRUE(log.close() == ErrorCode::E_NO_ERROR);
+  std::remove("./test.wal");
+}
+
+SMILE_NS_END
+
+int main(int argc, char* argv[]){
+  ::testing::InitGoogleTest(&argc,argv);
+  int ret = RUN_ALL_TESTS();
+  return ret;
+}